@@ -0,0 +1,63 @@
+#!/bin/bash
+#
+# Direct vs indirect rendering A/B benchmark over all the demos.
+#
+#   ./bench_direct.sh [build dir] [frames]
+#
+# Every demo runs with DIRECT=0 and DIRECT=1 at each of $SIZES and prints
+# one "bench:" line (see src/common/bench.h).  The lines are collected in
+# $OUT as CSV, then both modes are compared per demo and size.  A direct
+# run whose composition cost stays close to the indirect one most likely
+# fell back to the indirect copy.
+
+BUILD=${1:-.}
+FRAMES=${2:-300}
+SIZES=${SIZES:-"320x480 720x1280 1080x1920"}
+OUT=${OUT:-bench_direct.csv}
+DEMOS="opengles1/glviewcube11 opengles1/gears opengles1/torus opengles1/pbuffer
+       opengles2/glviewcube20 opengles3/transform_feedback_elm"
+
+export BENCH_FRAMES=$FRAMES
+
+echo "name,direct,size,frames,frame_ms,p95_ms,draw_ms,render_ms,compose_ms,cpu" > $OUT
+
+for demo in $DEMOS; do
+	bin=$BUILD/src/$demo
+	if [ ! -x $bin ]; then
+		echo "$bin: not built, skipped"
+		continue
+	fi
+	for size in $SIZES; do
+		for direct in 0 1; do
+			line=$(DIRECT=$direct BENCH_SIZE=$size timeout 120 $bin 2>/dev/null | grep "^bench: name=.*frame_ms=")
+			if [ -z "$line" ]; then
+				echo "$demo $size direct=$direct: no result"
+				continue
+			fi
+			echo "$line"
+			echo "$line" | sed -e 's/^bench: //' -e 's/[a-z_0-9]*=//g' -e 's/%//' -e 's/ /,/g' >> $OUT
+		done
+	done
+done
+
+echo
+awk -F, '
+NR == 1 { next }
+{
+	key = $1 " " $3
+	if (!(key in seen)) { seen[key] = 1; order[n++] = key }
+	frame[key, $2] = $5; compose[key, $2] = $9; cpu[key, $2] = $10
+}
+END {
+	printf "%-34s %19s %21s %15s\n", "demo size", "frame ms ind/dir", "compose ms ind/dir", "cpu % ind/dir"
+	for (i = 0; i < n; i++) {
+		k = order[i]
+		if (!((k, 0) in frame) || !((k, 1) in frame)) continue
+		note = ""
+		if (compose[k, 0] > 0 && compose[k, 1] >= 0.8 * compose[k, 0])
+			note = "  direct fell back?"
+		printf "%-34s %9.3f/%-9.3f %10.3f/%-10.3f %7.1f/%-7.1f%s\n", k,
+		       frame[k, 0], frame[k, 1], compose[k, 0], compose[k, 1],
+		       cpu[k, 0], cpu[k, 1], note
+	}
+}' $OUT
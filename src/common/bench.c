@@ -0,0 +1,262 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <Ecore.h>
+#include "bench.h"
+#include "gl_profile.h"
+#include "gl_redundant.h"
+#include "gl_trace.h"
+
+struct _Bench {
+   char *name;
+   Evas_Object *win;
+   Evas *evas;         /* NULL once the window is gone */
+   Eina_Bool direct;
+   int w, h;
+
+   int warmup, frames;
+   int count;               /* draw callbacks so far, warm-up included */
+   double *frame_times;     /* measured frames */
+
+   double last_begin, draw_begin;
+   double draw, render, render_begin;
+   int renders;
+
+   double wall0, cpu0;
+};
+
+static double
+_cpu_time(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static Eina_Bool
+_measuring(const Bench *b)
+{
+   return b->count > b->warmup && b->count <= b->warmup + b->frames;
+}
+
+static void
+_render_pre(void *data, Evas *e EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   Bench *b = data;
+
+   b->render_begin = ecore_time_get();
+}
+
+static void
+_render_post(void *data, Evas *e EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   Bench *b = data;
+
+   if (!_measuring(b))
+      return;
+   b->render += ecore_time_get() - b->render_begin;
+   b->renders++;
+}
+
+static void
+_win_del(void *data, Evas *e EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   Bench *b = data;
+
+   b->evas = NULL;
+}
+
+static int
+_cmp(const void *a, const void *b)
+{
+   double x = *(const double *)a, y = *(const double *)b;
+
+   return x < y ? -1 : x > y;
+}
+
+/* DIRECT=0|1, fallback when unset */
+Eina_Bool
+bench_direct(Eina_Bool fallback)
+{
+   const char *direct = getenv("DIRECT");
+
+   if (!direct)
+      return fallback;
+
+   return !!atoi(direct);
+}
+
+void
+bench_size(int *w, int *h)
+{
+   const char *size = getenv("BENCH_SIZE");
+   int bw, bh;
+
+   if (size && sscanf(size, "%dx%d", &bw, &bh) == 2 && bw > 0 && bh > 0) {
+      *w = bw;
+      *h = bh;
+   }
+}
+
+/* INSTANCES=<n>, 1 when unset */
+int
+bench_instances(void)
+{
+   const char *instances = getenv("INSTANCES");
+
+   if (!instances || atoi(instances) <= 0)
+      return 1;
+
+   return atoi(instances);
+}
+
+Bench *
+bench_new(const char *name, Evas_Object *win, Eina_Bool direct)
+{
+   const char *frames = getenv("BENCH_FRAMES");
+   const char *warmup = getenv("BENCH_WARMUP");
+   Bench *b;
+
+   if (!frames || atoi(frames) <= 0)
+      return NULL;
+
+   b = calloc(1, sizeof(Bench));
+   if (!b)
+      return NULL;
+
+   b->frames = atoi(frames);
+   b->frame_times = calloc(b->frames, sizeof(double));
+   if (!b->frame_times) {
+      free(b);
+      return NULL;
+   }
+   b->name = strdup(name);
+   b->direct = direct;
+   b->warmup = warmup ? atoi(warmup) : 30;
+
+   evas_object_geometry_get(win, NULL, NULL, &b->w, &b->h);
+   b->win = win;
+   b->evas = evas_object_evas_get(win);
+   evas_object_event_callback_add(win, EVAS_CALLBACK_DEL, _win_del, b);
+   evas_event_callback_add(b->evas, EVAS_CALLBACK_RENDER_PRE, _render_pre, b);
+   evas_event_callback_add(b->evas, EVAS_CALLBACK_RENDER_POST, _render_post, b);
+
+   return b;
+}
+
+void
+bench_draw_begin(Bench *b)
+{
+   double now;
+
+   if (!b)
+      return;
+
+   now = ecore_time_get();
+   b->count++;
+
+   if (b->count == b->warmup + 1) {
+      b->wall0 = now;
+      b->cpu0 = _cpu_time();
+   }
+   else if (_measuring(b)) {
+      b->frame_times[b->count - b->warmup - 2] = now - b->last_begin;
+   }
+
+   b->last_begin = now;
+   b->draw_begin = now;
+}
+
+/* EINA_FALSE once the measured frames are done. */
+Eina_Bool
+bench_draw_end(Bench *b)
+{
+   if (!b)
+      return EINA_TRUE;
+
+   if (_measuring(b))
+      b->draw += ecore_time_get() - b->draw_begin;
+
+   return b->count < b->warmup + b->frames;
+}
+
+void
+bench_finish(Bench *b)
+{
+   double wall, cpu, mean = 0.0;
+   int i, n;
+
+   if (!b)
+      return;
+
+   if (b->evas) {
+      evas_object_event_callback_del_full(b->win, EVAS_CALLBACK_DEL, _win_del, b);
+      evas_event_callback_del_full(b->evas, EVAS_CALLBACK_RENDER_PRE, _render_pre, b);
+      evas_event_callback_del_full(b->evas, EVAS_CALLBACK_RENDER_POST, _render_post, b);
+   }
+
+   /* frame times are intervals: one less than the frames drawn */
+   n = b->count - b->warmup - 1;
+   if (n > b->frames - 1)
+      n = b->frames - 1;
+
+   if (n > 0) {
+      wall = b->last_begin - b->wall0;
+      cpu = _cpu_time() - b->cpu0;
+      for (i = 0; i < n; i++)
+         mean += b->frame_times[i];
+      mean /= n;
+      qsort(b->frame_times, n, sizeof(double), _cmp);
+
+      printf("bench: name=%s direct=%d size=%dx%d frames=%d "
+             "frame_ms=%.3f p95_ms=%.3f draw_ms=%.3f render_ms=%.3f compose_ms=%.3f cpu=%.1f%%\n",
+             b->name, b->direct, b->w, b->h, n + 1,
+             mean * 1000.0, b->frame_times[n * 95 / 100] * 1000.0,
+             b->draw * 1000.0 / (n + 1),
+             b->renders ? b->render * 1000.0 / b->renders : 0.0,
+             b->renders ? (b->render - b->draw) * 1000.0 / b->renders : 0.0,
+             wall > 0.0 ? cpu * 100.0 / wall : 0.0);
+   }
+   else {
+      printf("bench: name=%s: only %d frames drawn, nothing measured\n", b->name, b->count);
+   }
+
+   free(b->frame_times);
+   free(b->name);
+   free(b);
+}
+
+void
+bench_api_lookup(const char *name, Evas_GL *evas_gl, Evas_GL_Context *ctx, Evas_GL_API *cached)
+{
+   const char *env = getenv("BENCH_API_LOOKUP");
+   Evas_GL_API *volatile sink;
+   Evas_GL_API *volatile api = cached;
+   double t, get, wrapped, load;
+   int i, n;
+
+   if (!env || atoi(env) <= 0 || !evas_gl || !ctx)
+      return;
+   n = atoi(env);
+
+   t = ecore_time_get();
+   for (i = 0; i < n; i++)
+      sink = evas_gl_context_api_get(evas_gl, ctx);
+   get = ecore_time_get() - t;
+
+   t = ecore_time_get();
+   for (i = 0; i < n; i++)
+      sink = gl_redundant_api(gl_profile_api(gl_trace_api(evas_gl_context_api_get(evas_gl, ctx))));
+   wrapped = ecore_time_get() - t;
+
+   t = ecore_time_get();
+   for (i = 0; i < n; i++)
+      sink = api;
+   load = ecore_time_get() - t;
+   (void)sink;
+
+   printf("api lookup: name=%s lookups=%d get_ns=%.1f wrapped_ns=%.1f cached_ns=%.2f\n",
+          name, n, get * 1e9 / n, wrapped * 1e9 / n, load * 1e9 / n);
+}
@@ -0,0 +1,43 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <Eina.h>
+#include <Evas.h>
+#include <Evas_GL.h>
+
+/*
+ * Frame benchmark shared by the demos, driven by bench_direct.sh.
+ *
+ * BENCH_FRAMES=<n> measures n frames after BENCH_WARMUP (default 30)
+ * warm-up frames, then prints one "bench:" line and asks the demo to
+ * quit.  Measured are the frame time (between two draw callbacks), the
+ * demo's own draw time, the canvas render time around it and the process
+ * CPU time against wall time.  Render minus draw is what Evas spends on
+ * top of the demo, mostly composition: with direct rendering it should
+ * nearly vanish, when it does not Evas fell back to the indirect copy.
+ *
+ * DIRECT=1 or DIRECT=0 picks direct or indirect rendering in every demo,
+ * BENCH_SIZE=<w>x<h> the window size.  INSTANCES=<n> runs n independent
+ * copies of the scene in one process, each in its own window with its own
+ * context; the measurements follow the first one.  So does GL_TRACE,
+ * which records the first context only.  GL_REDUNDANT keeps a shadow per
+ * context, and it and GL_PROFILE add up the calls of all instances over
+ * the frames of the first.
+ *
+ * BENCH_API_LOOKUP=<n> times n API table lookups at start up and prints
+ * one "api lookup:" line: evas_gl_context_api_get() alone, with the
+ * GL_PROFILE, GL_TRACE and GL_REDUNDANT wrappers around it as the demos
+ * have them, and a load of the pointer the demos cache instead.
+ */
+typedef struct _Bench Bench;
+
+Eina_Bool bench_direct(Eina_Bool fallback);
+void      bench_size(int *w, int *h);
+int       bench_instances(void);
+Bench    *bench_new(const char *name, Evas_Object *win, Eina_Bool direct);
+void      bench_draw_begin(Bench *bench);
+Eina_Bool bench_draw_end(Bench *bench);
+void      bench_finish(Bench *bench);
+void      bench_api_lookup(const char *name, Evas_GL *evas_gl, Evas_GL_Context *ctx, Evas_GL_API *cached);
+
+#endif
@@ -0,0 +1,63 @@
+#include <stdlib.h>
+#include "frame_arena.h"
+
+#define ALIGN_UP(x) (((x) + FRAME_ARENA_ALIGN - 1) & ~((size_t) FRAME_ARENA_ALIGN - 1))
+
+/* Makes sure at least size bytes are available, returns EINA_TRUE when
+ * the backing block had to be (re)allocated.  The arena never shrinks so
+ * going back and forth between window sizes costs nothing. */
+Eina_Bool
+frame_arena_reserve(Frame_Arena *arena, size_t size)
+{
+   void *base;
+
+   size = ALIGN_UP(size);
+   if (size <= arena->size)
+      return EINA_FALSE;
+
+   if (posix_memalign(&base, FRAME_ARENA_ALIGN, size))
+      return EINA_FALSE;
+
+   frame_arena_release(arena);
+   arena->base = base;
+   arena->size = size;
+   arena->used = 0;
+   arena->allocs++;
+   arena->bytes += size;
+
+   return EINA_TRUE;
+}
+
+void *
+frame_arena_alloc(Frame_Arena *arena, size_t size)
+{
+   void *ptr;
+
+   size = ALIGN_UP(size);
+   if (arena->used + size > arena->size)
+      return NULL;
+
+   ptr = arena->base + arena->used;
+   arena->used += size;
+
+   return ptr;
+}
+
+void
+frame_arena_reset(Frame_Arena *arena)
+{
+   arena->used = 0;
+}
+
+void
+frame_arena_release(Frame_Arena *arena)
+{
+   if (!arena->base)
+      return;
+
+   free(arena->base);
+   arena->base = NULL;
+   arena->size = 0;
+   arena->used = 0;
+   arena->frees++;
+}
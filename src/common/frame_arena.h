@@ -0,0 +1,36 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <stddef.h>
+#include <Eina.h>
+
+/*
+ * Bump allocator for per-frame scratch memory such as readback buffers.
+ *
+ * The backing block is reserved up front (typically from a resize
+ * callback) and only goes back to the heap when a reservation does not
+ * fit; per frame the arena is reset and carved up again without touching
+ * malloc.  allocs/frees/bytes count every trip to the heap so callers can
+ * check that steady state rendering does none.
+ */
+typedef struct _Frame_Arena Frame_Arena;
+
+struct _Frame_Arena {
+   unsigned char *base;
+   size_t size;
+   size_t used;
+
+   /* heap traffic since the arena was created */
+   unsigned long allocs;
+   unsigned long frees;
+   size_t bytes;
+};
+
+#define FRAME_ARENA_ALIGN 64
+
+Eina_Bool frame_arena_reserve(Frame_Arena *arena, size_t size);
+void     *frame_arena_alloc(Frame_Arena *arena, size_t size);
+void      frame_arena_reset(Frame_Arena *arena);
+void      frame_arena_release(Frame_Arena *arena);
+
+#endif
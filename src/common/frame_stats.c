@@ -0,0 +1,205 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <Ecore.h>
+#include "frame_stats.h"
+
+/* a power of two, holds several seconds of frames at 60 fps */
+#define RING_SIZE 1024
+
+/* histogram bucket upper bounds in ms, the last bucket is open */
+static const double buckets[] = { 4, 8, 12, 17, 20, 25, 33, 50, 100 };
+#define BUCKETS (sizeof(buckets) / sizeof(buckets[0]) + 1)
+
+struct _Frame_Stats {
+   char *name;
+   FILE *out;
+   Eina_Bool json;
+   Ecore_Timer *timer;
+   uint64_t start, since;
+
+   /* written by the drawing side only */
+   uint64_t last;
+   uint64_t ring[RING_SIZE];
+   unsigned int head;
+
+   /* read side */
+   unsigned int tail;
+   uint64_t samples[RING_SIZE];
+};
+
+static int
+_cmp(const void *a, const void *b)
+{
+   uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+   return x < y ? -1 : x > y;
+}
+
+static double
+_percentile(const uint64_t *sorted, int n, int p)
+{
+   int i = (n * p + 99) / 100 - 1;
+
+   return sorted[i < 0 ? 0 : i] / 1e6;
+}
+
+static void
+_export(Frame_Stats *fs)
+{
+   unsigned int hist[BUCKETS] = { 0 };
+   unsigned int head, dropped = 0, b;
+   uint64_t now = frame_stats_now();
+   double mean = 0.0, jank_ms, ms, dt;
+   int i, n = 0, jank = 0;
+
+   /* pairs with the release store in frame_stats_frame() */
+   head = __atomic_load_n(&fs->head, __ATOMIC_ACQUIRE);
+   if (head - fs->tail > RING_SIZE) {
+      dropped = head - fs->tail - RING_SIZE;
+      fs->tail = head - RING_SIZE;
+   }
+   while (fs->tail != head)
+      fs->samples[n++] = fs->ring[fs->tail++ & (RING_SIZE - 1)];
+   /* the producer may have lapped us while we copied, the oldest
+    * copies are then torn */
+   b = __atomic_load_n(&fs->head, __ATOMIC_ACQUIRE);
+   if (b - head > RING_SIZE - (unsigned int)n) {
+      b = b - head - (RING_SIZE - n);
+      if (b > (unsigned int)n)
+         b = n;
+      memmove(fs->samples, fs->samples + b, (n - b) * sizeof(uint64_t));
+      dropped += b;
+      n -= b;
+   }
+
+   jank_ms = ecore_animator_frametime_get() * 1.5 * 1000.0;
+   for (i = 0; i < n; i++) {
+      ms = fs->samples[i] / 1e6;
+      mean += ms;
+      if (ms > jank_ms)
+         jank++;
+      for (b = 0; b < BUCKETS - 1 && ms >= buckets[b]; b++)
+         ;
+      hist[b]++;
+   }
+   if (n)
+      mean /= n;
+   qsort(fs->samples, n, sizeof(uint64_t), _cmp);
+
+   dt = (now - fs->since) / 1e9;
+   fs->since = now;
+
+   if (fs->json) {
+      fprintf(fs->out, "{\"name\":\"%s\",\"time_s\":%.3f,\"frames\":%d,\"fps\":%.2f,"
+              "\"mean_ms\":%.3f,\"p50_ms\":%.3f,\"p95_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f,"
+              "\"jank\":%d,\"dropped\":%u,\"histogram\":[",
+              fs->name, (now - fs->start) / 1e9, n, dt > 0.0 ? (n + dropped) / dt : 0.0, mean,
+              n ? _percentile(fs->samples, n, 50) : 0.0,
+              n ? _percentile(fs->samples, n, 95) : 0.0,
+              n ? _percentile(fs->samples, n, 99) : 0.0,
+              n ? fs->samples[n - 1] / 1e6 : 0.0, jank, dropped);
+      for (b = 0; b < BUCKETS; b++)
+         fprintf(fs->out, "%s%u", b ? "," : "", hist[b]);
+      fprintf(fs->out, "]}\n");
+   }
+   else {
+      fprintf(fs->out, "%s,%.3f,%d,%.2f,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%u",
+              fs->name, (now - fs->start) / 1e9, n, dt > 0.0 ? (n + dropped) / dt : 0.0, mean,
+              n ? _percentile(fs->samples, n, 50) : 0.0,
+              n ? _percentile(fs->samples, n, 95) : 0.0,
+              n ? _percentile(fs->samples, n, 99) : 0.0,
+              n ? fs->samples[n - 1] / 1e6 : 0.0, jank, dropped);
+      for (b = 0; b < BUCKETS; b++)
+         fprintf(fs->out, ",%u", hist[b]);
+      fprintf(fs->out, "\n");
+   }
+   fflush(fs->out);
+}
+
+static Eina_Bool
+_timer(void *data)
+{
+   _export(data);
+   return ECORE_CALLBACK_RENEW;
+}
+
+uint64_t
+frame_stats_now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+Frame_Stats *
+frame_stats_new(const char *name)
+{
+   const char *period = getenv("FRAME_STATS");
+   const char *format = getenv("FRAME_STATS_FORMAT");
+   const char *path = getenv("FRAME_STATS_FILE");
+   Frame_Stats *fs;
+   unsigned int b;
+
+   if (!period || atof(period) <= 0.0)
+      return NULL;
+
+   fs = calloc(1, sizeof(Frame_Stats));
+   if (!fs)
+      return NULL;
+
+   fs->out = stdout;
+   if (path) {
+      fs->out = fopen(path, "w");
+      if (!fs->out) {
+         printf("frame_stats: cannot open %s, using stdout\n", path);
+         fs->out = stdout;
+      }
+   }
+   fs->json = format && !strcmp(format, "json");
+   fs->name = strdup(name);
+   fs->start = fs->since = frame_stats_now();
+   fs->timer = ecore_timer_add(atof(period), _timer, fs);
+
+   if (!fs->json) {
+      fprintf(fs->out, "name,time_s,frames,fps,mean_ms,p50_ms,p95_ms,p99_ms,max_ms,jank,dropped");
+      for (b = 0; b < BUCKETS - 1; b++)
+         fprintf(fs->out, ",lt%gms", buckets[b]);
+      fprintf(fs->out, ",ge%gms\n", buckets[BUCKETS - 2]);
+   }
+
+   return fs;
+}
+
+void
+frame_stats_frame(Frame_Stats *fs)
+{
+   uint64_t now;
+
+   if (!fs)
+      return;
+
+   now = frame_stats_now();
+   if (fs->last) {
+      fs->ring[fs->head & (RING_SIZE - 1)] = now - fs->last;
+      __atomic_store_n(&fs->head, fs->head + 1, __ATOMIC_RELEASE);
+   }
+   fs->last = now;
+}
+
+/* Exports what is left and closes the output. */
+void
+frame_stats_free(Frame_Stats *fs)
+{
+   if (!fs)
+      return;
+
+   ecore_timer_del(fs->timer);
+   _export(fs);
+   if (fs->out != stdout)
+      fclose(fs->out);
+   free(fs->name);
+   free(fs);
+}
@@ -0,0 +1,29 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <stdint.h>
+#include <Eina.h>
+
+/*
+ * Frame time statistics.
+ *
+ * frame_stats_frame() is called once per drawn frame and stores the time
+ * since the previous frame, taken from CLOCK_MONOTONIC in nanoseconds, in
+ * a single producer, single consumer ring.  The drawing side never locks,
+ * so it may run on the render thread while the main loop exports.
+ *
+ * FRAME_STATS=<seconds> turns it on and exports every <seconds> the frame
+ * count and rate, mean, p50/p95/p99 and max frame time, the jank count
+ * (frames over 1.5 animator frametimes) and a frame time histogram.
+ * FRAME_STATS_FORMAT=csv|json picks CSV (the default, with a header line)
+ * or one JSON object per line, FRAME_STATS_FILE=<path> a file to write
+ * to instead of stdout.
+ */
+typedef struct _Frame_Stats Frame_Stats;
+
+uint64_t     frame_stats_now(void);
+Frame_Stats *frame_stats_new(const char *name);
+void         frame_stats_frame(Frame_Stats *stats);
+void         frame_stats_free(Frame_Stats *stats);
+
+#endif
@@ -0,0 +1,221 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <Ecore.h>
+#include "frame_arena.h"
+#include "frame_writer.h"
+
+typedef struct _Frame_Writer_Item Frame_Writer_Item;
+
+struct _Frame_Writer_Item {
+   unsigned char *pixels;
+   int frame;
+};
+
+struct _Frame_Writer {
+   char *dir;
+   char *prefix;
+   int w, h;
+
+   Frame_Arena pool;
+   int buffers;
+
+   Eina_Lock lock;
+   Eina_Condition space, work;
+   Eina_Thread tid;
+   Eina_Bool quit;
+
+   /* buffers nobody holds */
+   unsigned char **idle;
+   int nidle;
+
+   /* submitted and not written yet, oldest first */
+   Frame_Writer_Item *queue;
+   int head, count;
+
+   /* writer thread only */
+   unsigned char *row;
+   int written, failed;
+   double busy;
+
+   int waits;
+};
+
+static Eina_Bool
+_write(Frame_Writer *fw, const Frame_Writer_Item *item)
+{
+   char path[4096];
+   FILE *f;
+   int x, y;
+
+   snprintf(path, sizeof(path), "%s/%s-%05d.ppm", fw->dir, fw->prefix, item->frame);
+   f = fopen(path, "wb");
+   if (!f)
+      return EINA_FALSE;
+
+   /* GL rows are bottom up */
+   fprintf(f, "P6\n%d %d\n255\n", fw->w, fw->h);
+   for (y = fw->h - 1; y >= 0; y--) {
+      const unsigned char *src = item->pixels + (size_t) y * fw->w * 4;
+
+      for (x = 0; x < fw->w; x++) {
+         fw->row[x * 3 + 0] = src[x * 4 + 0];
+         fw->row[x * 3 + 1] = src[x * 4 + 1];
+         fw->row[x * 3 + 2] = src[x * 4 + 2];
+      }
+      fwrite(fw->row, 3, fw->w, f);
+   }
+
+   return fclose(f) == 0;
+}
+
+static void *
+_writer(void *data, Eina_Thread t EINA_UNUSED)
+{
+   Frame_Writer *fw = data;
+   Frame_Writer_Item item;
+   double t0;
+
+   eina_lock_take(&fw->lock);
+   for (;;) {
+      while (!fw->count && !fw->quit)
+         eina_condition_wait(&fw->work);
+      if (!fw->count)
+         break;
+
+      item = fw->queue[fw->head];
+      fw->head = (fw->head + 1) % fw->buffers;
+      fw->count--;
+      eina_lock_release(&fw->lock);
+
+      t0 = ecore_time_get();
+      if (_write(fw, &item))
+         fw->written++;
+      else
+         fw->failed++;
+      fw->busy += ecore_time_get() - t0;
+
+      eina_lock_take(&fw->lock);
+      fw->idle[fw->nidle++] = item.pixels;
+      eina_condition_signal(&fw->space);
+   }
+   eina_lock_release(&fw->lock);
+
+   return NULL;
+}
+
+Frame_Writer *
+frame_writer_new(const char *dir, const char *prefix, int w, int h, int buffers)
+{
+   size_t size = (size_t) w * h * 4;
+   Frame_Writer *fw;
+   int i;
+
+   if (w <= 0 || h <= 0 || buffers < 1)
+      return NULL;
+
+   fw = calloc(1, sizeof(Frame_Writer));
+   if (!fw)
+      return NULL;
+
+   if (mkdir(dir, 0755) && errno != EEXIST)
+      printf("frame_writer: cannot create %s: %s\n", dir, strerror(errno));
+
+   fw->dir = strdup(dir);
+   fw->prefix = strdup(prefix);
+   fw->w = w;
+   fw->h = h;
+   fw->buffers = buffers;
+   fw->idle = calloc(buffers, sizeof(unsigned char *));
+   fw->queue = calloc(buffers, sizeof(Frame_Writer_Item));
+   fw->row = malloc((size_t) w * 3);
+   if (!fw->idle || !fw->queue || !fw->row ||
+       !frame_arena_reserve(&fw->pool, buffers * (size + FRAME_ARENA_ALIGN)))
+      goto fail;
+
+   for (i = 0; i < buffers; i++)
+      fw->idle[fw->nidle++] = frame_arena_alloc(&fw->pool, size);
+
+   eina_lock_new(&fw->lock);
+   eina_condition_new(&fw->space, &fw->lock);
+   eina_condition_new(&fw->work, &fw->lock);
+   if (!eina_thread_create(&fw->tid, EINA_THREAD_BACKGROUND, -1, _writer, fw)) {
+      eina_condition_free(&fw->space);
+      eina_condition_free(&fw->work);
+      eina_lock_free(&fw->lock);
+      goto fail;
+   }
+
+   return fw;
+
+fail:
+   frame_arena_release(&fw->pool);
+   free(fw->row);
+   free(fw->queue);
+   free(fw->idle);
+   free(fw->prefix);
+   free(fw->dir);
+   free(fw);
+   return NULL;
+}
+
+unsigned char *
+frame_writer_acquire(Frame_Writer *fw)
+{
+   unsigned char *pixels;
+
+   eina_lock_take(&fw->lock);
+   if (!fw->nidle)
+      fw->waits++;
+   while (!fw->nidle)
+      eina_condition_wait(&fw->space);
+   pixels = fw->idle[--fw->nidle];
+   eina_lock_release(&fw->lock);
+
+   return pixels;
+}
+
+void
+frame_writer_submit(Frame_Writer *fw, unsigned char *pixels, int frame)
+{
+   Frame_Writer_Item *item;
+
+   eina_lock_take(&fw->lock);
+   item = &fw->queue[(fw->head + fw->count) % fw->buffers];
+   item->pixels = pixels;
+   item->frame = frame;
+   fw->count++;
+   eina_condition_signal(&fw->work);
+   eina_lock_release(&fw->lock);
+}
+
+/* Writes out what is still queued, then stops the writer. */
+void
+frame_writer_free(Frame_Writer *fw)
+{
+   if (!fw)
+      return;
+
+   eina_lock_take(&fw->lock);
+   fw->quit = EINA_TRUE;
+   eina_condition_signal(&fw->work);
+   eina_lock_release(&fw->lock);
+   eina_thread_join(fw->tid);
+
+   printf("frame_writer: %d frames written to %s (%d failed), %.3f s writing, producers waited %d times\n",
+          fw->written, fw->dir, fw->failed, fw->busy, fw->waits);
+
+   eina_condition_free(&fw->space);
+   eina_condition_free(&fw->work);
+   eina_lock_free(&fw->lock);
+   frame_arena_release(&fw->pool);
+   free(fw->row);
+   free(fw->queue);
+   free(fw->idle);
+   free(fw->prefix);
+   free(fw->dir);
+   free(fw);
+}
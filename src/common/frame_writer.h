@@ -0,0 +1,23 @@
+#ifndef FRAME_WRITER_H
+#define FRAME_WRITER_H
+
+#include <Eina.h>
+
+/*
+ * Background writer for rendered frames.
+ *
+ * Owns a fixed pool of w x h RGBA8888 buffers.  Producers take a free
+ * buffer with frame_writer_acquire() (blocking while all of them are
+ * queued), read pixels into it and hand it back with frame_writer_submit();
+ * a writer thread saves it as dir/<prefix>-<frame>.ppm, flipped to top
+ * down, and returns the buffer to the pool.  Producers never wait on the
+ * disk unless the writer falls a whole pool behind.
+ */
+typedef struct _Frame_Writer Frame_Writer;
+
+Frame_Writer  *frame_writer_new(const char *dir, const char *prefix, int w, int h, int buffers);
+unsigned char *frame_writer_acquire(Frame_Writer *fw);
+void           frame_writer_submit(Frame_Writer *fw, unsigned char *pixels, int frame);
+void           frame_writer_free(Frame_Writer *fw);
+
+#endif
@@ -0,0 +1,37 @@
+#include <stddef.h>
+#include <Evas_GL.h>
+#include "gl_calls.h"
+
+#define NAME(name, params, args) #name,
+#define NAME_R(type, name, params, args) #name,
+#define NAME0(name) #name,
+#define NAME0_R(type, name) #name,
+
+const char *const gl_call_names[GL_CALL_LAST] = {
+   GL_CALLS(NAME, NAME_R, NAME0, NAME0_R)
+};
+
+static int claimed;
+static __thread int drawing;   /* 0 not asked yet, 1 yes, -1 no */
+
+int
+gl_calls_drawing_thread(void)
+{
+   int expected = 0;
+
+   if (!drawing)
+      drawing = __atomic_compare_exchange_n(&claimed, &expected, 1, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ? 1 : -1;
+
+   return drawing > 0;
+}
+
+Evas_GL_Context *
+gl_calls_context(void)
+{
+   Evas_GL_Context *ctx = NULL;
+
+   evas_gl_current_evas_gl_get(&ctx, NULL);
+
+   return ctx;
+}
@@ -0,0 +1,167 @@
+#ifndef GL_CALLS_H
+#define GL_CALLS_H
+
+#include <Evas_GL.h>
+
+/*
+ * The Evas_GL_API entry points the demos call, as an X-macro table for
+ * the layers that wrap the table (see gl_profile.h and gl_trace.h).
+ * Every entry is
+ *
+ *   XV(name, (parameters), (arguments))               returns void
+ *   XR(type, name, (parameters), (arguments))         returns type
+ *   XV0(name)                                         void, no arguments
+ *   XR0(type, name)                                   type, no arguments
+ *
+ * Entry points not listed keep their original function in a wrapped
+ * table; add them here when a demo starts calling them.  The order gives
+ * the Gl_Call numbers, which GL traces store, so a trace only replays
+ * with the table it was recorded with.
+ */
+#define GL_CALLS(XV, XR, XV0, XR0) \
+   XV(glActiveTexture, (GLenum texture), (texture)) \
+   XV(glAttachShader, (GLuint program, GLuint shader), (program, shader)) \
+   XV(glBeginQuery, (GLenum target, GLuint id), (target, id)) \
+   XV(glBeginTransformFeedback, (GLenum primitiveMode), (primitiveMode)) \
+   XV(glBindBuffer, (GLenum target, GLuint buffer), (target, buffer)) \
+   XV(glBindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer)) \
+   XV(glBindTexture, (GLenum target, GLuint texture), (target, texture)) \
+   XV(glBindTransformFeedback, (GLenum target, GLuint id), (target, id)) \
+   XV(glBindVertexArray, (GLuint array), (array)) \
+   XV(glBlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor)) \
+   XV(glBufferData, (GLenum target, GLsizeiptr size, const void *data, GLenum usage), (target, size, data, usage)) \
+   XV(glClear, (GLbitfield mask), (mask)) \
+   XV(glClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha)) \
+   XR(GLenum, glClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout)) \
+   XV(glColorPointer, (GLint size, GLenum type, GLsizei stride, const void *pointer), (size, type, stride, pointer)) \
+   XV(glCompileShader, (GLuint shader), (shader)) \
+   XV(glCompressedTexImage2D, (GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data), (target, level, internalformat, width, height, border, imageSize, data)) \
+   XR0(GLuint, glCreateProgram) \
+   XR(GLuint, glCreateShader, (GLenum type), (type)) \
+   XV(glCullFace, (GLenum mode), (mode)) \
+   XV(glDeleteBuffers, (GLsizei n, const GLuint *buffers), (n, buffers)) \
+   XV(glDeleteProgram, (GLuint program), (program)) \
+   XV(glDeleteShader, (GLuint shader), (shader)) \
+   XV(glDeleteSync, (GLsync sync), (sync)) \
+   XV(glDeleteTextures, (GLsizei n, const GLuint *textures), (n, textures)) \
+   XV(glDeleteVertexArrays, (GLsizei n, const GLuint *arrays), (n, arrays)) \
+   XV(glDepthFunc, (GLenum func), (func)) \
+   XV(glDisable, (GLenum cap), (cap)) \
+   XV(glDisableClientState, (GLenum array), (array)) \
+   XV(glDisableVertexAttribArray, (GLuint index), (index)) \
+   XV(glDrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count)) \
+   XV(glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void *indices), (mode, count, type, indices)) \
+   XV(glDrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount), (mode, count, type, indices, instancecount)) \
+   XV(glEnable, (GLenum cap), (cap)) \
+   XV(glEnableClientState, (GLenum array), (array)) \
+   XV(glEnableVertexAttribArray, (GLuint index), (index)) \
+   XV(glEndQuery, (GLenum target), (target)) \
+   XV0(glEndTransformFeedback) \
+   XR(GLsync, glFenceSync, (GLenum condition, GLbitfield flags), (condition, flags)) \
+   XV0(glFinish) \
+   XV0(glFlush) \
+   XV(glFrustumf, (GLfloat l, GLfloat r, GLfloat b, GLfloat t, GLfloat n, GLfloat f), (l, r, b, t, n, f)) \
+   XV(glGenBuffers, (GLsizei n, GLuint *buffers), (n, buffers)) \
+   XV(glGenQueries, (GLsizei n, GLuint *ids), (n, ids)) \
+   XV(glGenTextures, (GLsizei n, GLuint *textures), (n, textures)) \
+   XV(glGenTransformFeedbacks, (GLsizei n, GLuint *ids), (n, ids)) \
+   XV(glGenVertexArrays, (GLsizei n, GLuint *arrays), (n, arrays)) \
+   XR(GLint, glGetAttribLocation, (GLuint program, const GLchar *name), (program, name)) \
+   XR0(GLenum, glGetError) \
+   XV(glGetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog), (program, bufSize, length, infoLog)) \
+   XV(glGetProgramiv, (GLuint program, GLenum pname, GLint *params), (program, pname, params)) \
+   XV(glGetQueryObjectuiv, (GLuint id, GLenum pname, GLuint *params), (id, pname, params)) \
+   XV(glGetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog), (shader, bufSize, length, infoLog)) \
+   XV(glGetShaderiv, (GLuint shader, GLenum pname, GLint *params), (shader, pname, params)) \
+   XR(GLint, glGetUniformLocation, (GLuint program, const GLchar *name), (program, name)) \
+   XV(glLightfv, (GLenum light, GLenum pname, const GLfloat *params), (light, pname, params)) \
+   XV(glLinkProgram, (GLuint program), (program)) \
+   XV0(glLoadIdentity) \
+   XV(glLoadMatrixf, (const GLfloat *m), (m)) \
+   XR(void *, glMapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), (target, offset, length, access)) \
+   XV(glMaterialf, (GLenum face, GLenum pname, GLfloat param), (face, pname, param)) \
+   XV(glMaterialfv, (GLenum face, GLenum pname, const GLfloat *params), (face, pname, params)) \
+   XV(glMatrixMode, (GLenum mode), (mode)) \
+   XV(glNormal3f, (GLfloat nx, GLfloat ny, GLfloat nz), (nx, ny, nz)) \
+   XV(glNormalPointer, (GLenum type, GLsizei stride, const void *pointer), (type, stride, pointer)) \
+   XV(glPixelStorei, (GLenum pname, GLint param), (pname, param)) \
+   XV0(glPopMatrix) \
+   XV0(glPushMatrix) \
+   XV(glReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels), (x, y, width, height, format, type, pixels)) \
+   XV(glRotatef, (GLfloat angle, GLfloat x, GLfloat y, GLfloat z), (angle, x, y, z)) \
+   XV(glScalef, (GLfloat x, GLfloat y, GLfloat z), (x, y, z)) \
+   XV(glShadeModel, (GLenum mode), (mode)) \
+   XV(glShaderSource, (GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length), (shader, count, string, length)) \
+   XV(glTexCoordPointer, (GLint size, GLenum type, GLsizei stride, const void *pointer), (size, type, stride, pointer)) \
+   XV(glTexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels), (target, level, internalformat, width, height, border, format, type, pixels)) \
+   XV(glTexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param)) \
+   XV(glTexParameterx, (GLenum target, GLenum pname, GLfixed param), (target, pname, param)) \
+   XV(glTransformFeedbackVaryings, (GLuint program, GLsizei count, const GLchar *const *varyings, GLenum bufferMode), (program, count, varyings, bufferMode)) \
+   XV(glTranslatef, (GLfloat x, GLfloat y, GLfloat z), (x, y, z)) \
+   XV(glUniform1i, (GLint location, GLint v0), (location, v0)) \
+   XV(glUniform2f, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1)) \
+   XV(glUniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+   XR(GLboolean, glUnmapBuffer, (GLenum target), (target)) \
+   XV(glUseProgram, (GLuint program), (program)) \
+   XV(glVertexAttribDivisor, (GLuint index, GLuint divisor), (index, divisor)) \
+   XV(glVertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer), (index, size, type, normalized, stride, pointer)) \
+   XV(glVertexPointer, (GLint size, GLenum type, GLsizei stride, const void *pointer), (size, type, stride, pointer)) \
+   XV(glViewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height))
+
+#define GL_CALL_ENUM(name, params, args) GL_CALL_##name,
+#define GL_CALL_ENUM_R(type, name, params, args) GL_CALL_##name,
+#define GL_CALL_ENUM0(name) GL_CALL_##name,
+#define GL_CALL_ENUM0_R(type, name) GL_CALL_##name,
+
+typedef enum {
+   GL_CALLS(GL_CALL_ENUM, GL_CALL_ENUM_R, GL_CALL_ENUM0, GL_CALL_ENUM0_R)
+   GL_CALL_LAST
+} Gl_Call;
+
+extern const char *const gl_call_names[GL_CALL_LAST];
+
+/*
+ * For the layers that keep unlocked state about the calls they see:
+ * gl_calls_drawing_thread() is true in the first thread to ask, the one
+ * the demo draws in, and false in any other, such as pbuffer's farm
+ * workers.  gl_calls_context() is the Evas GL context current in the
+ * calling thread, NULL when there is none.
+ */
+int              gl_calls_drawing_thread(void);
+Evas_GL_Context *gl_calls_context(void);
+
+/*
+ * GL_FOR_EACH(X, a, b, ...) expands to X(a) X(b) ..., GL_FOR_EACH_COMMA
+ * to X(a), X(b), ...  Both take up to 9 items, enough for the longest
+ * parameter list above; GL_STRIP turns a (parameters) or (arguments) list
+ * into items.
+ */
+#define GL_STRIP(...) __VA_ARGS__
+#define GL_CAT(a, b) GL_CAT_(a, b)
+#define GL_CAT_(a, b) a##b
+#define GL_NARGS(...) GL_NARGS_(__VA_ARGS__, 9, 8, 7, 6, 5, 4, 3, 2, 1)
+#define GL_NARGS_(a1, a2, a3, a4, a5, a6, a7, a8, a9, n, ...) n
+
+#define GL_FOR_EACH(X, ...) GL_CAT(GL_EACH_, GL_NARGS(__VA_ARGS__))(X, __VA_ARGS__)
+#define GL_EACH_1(X, a) X(a)
+#define GL_EACH_2(X, a, ...) X(a) GL_EACH_1(X, __VA_ARGS__)
+#define GL_EACH_3(X, a, ...) X(a) GL_EACH_2(X, __VA_ARGS__)
+#define GL_EACH_4(X, a, ...) X(a) GL_EACH_3(X, __VA_ARGS__)
+#define GL_EACH_5(X, a, ...) X(a) GL_EACH_4(X, __VA_ARGS__)
+#define GL_EACH_6(X, a, ...) X(a) GL_EACH_5(X, __VA_ARGS__)
+#define GL_EACH_7(X, a, ...) X(a) GL_EACH_6(X, __VA_ARGS__)
+#define GL_EACH_8(X, a, ...) X(a) GL_EACH_7(X, __VA_ARGS__)
+#define GL_EACH_9(X, a, ...) X(a) GL_EACH_8(X, __VA_ARGS__)
+
+#define GL_FOR_EACH_COMMA(X, ...) GL_CAT(GL_EACH_COMMA_, GL_NARGS(__VA_ARGS__))(X, __VA_ARGS__)
+#define GL_EACH_COMMA_1(X, a) X(a)
+#define GL_EACH_COMMA_2(X, a, ...) X(a), GL_EACH_COMMA_1(X, __VA_ARGS__)
+#define GL_EACH_COMMA_3(X, a, ...) X(a), GL_EACH_COMMA_2(X, __VA_ARGS__)
+#define GL_EACH_COMMA_4(X, a, ...) X(a), GL_EACH_COMMA_3(X, __VA_ARGS__)
+#define GL_EACH_COMMA_5(X, a, ...) X(a), GL_EACH_COMMA_4(X, __VA_ARGS__)
+#define GL_EACH_COMMA_6(X, a, ...) X(a), GL_EACH_COMMA_5(X, __VA_ARGS__)
+#define GL_EACH_COMMA_7(X, a, ...) X(a), GL_EACH_COMMA_6(X, __VA_ARGS__)
+#define GL_EACH_COMMA_8(X, a, ...) X(a), GL_EACH_COMMA_7(X, __VA_ARGS__)
+#define GL_EACH_COMMA_9(X, a, ...) X(a), GL_EACH_COMMA_8(X, __VA_ARGS__)
+
+#endif
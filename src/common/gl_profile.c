@@ -0,0 +1,127 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "frame_stats.h"
+#include "gl_calls.h"
+#include "gl_profile.h"
+
+static int enabled = -1;   /* GL_PROFILE not read yet */
+static int report_frames, top;
+static Evas_GL_API *real, wrapped;
+
+static int frames;
+static unsigned long counts[GL_CALL_LAST];
+static uint64_t times[GL_CALL_LAST];
+
+/* taken out of counts and times for a report */
+static unsigned long report_counts[GL_CALL_LAST];
+static uint64_t report_times[GL_CALL_LAST];
+
+/* atomic, threads such as the pbuffer farm's draw through the table too */
+static inline void
+_account(Gl_Call call, uint64_t start)
+{
+   __atomic_fetch_add(&counts[call], 1, __ATOMIC_RELAXED);
+   __atomic_fetch_add(&times[call], frame_stats_now() - start, __ATOMIC_RELAXED);
+}
+
+#define WRAP_VOID(name, params, args) \
+   static void \
+   _##name params \
+   { \
+      uint64_t start = frame_stats_now(); \
+      real->name args; \
+      _account(GL_CALL_##name, start); \
+   }
+
+#define WRAP_RET(type, name, params, args) \
+   static type \
+   _##name params \
+   { \
+      uint64_t start = frame_stats_now(); \
+      type ret = real->name args; \
+      _account(GL_CALL_##name, start); \
+      return ret; \
+   }
+
+#define WRAP_VOID0(name) WRAP_VOID(name, (void), ())
+#define WRAP_RET0(type, name) WRAP_RET(type, name, (void), ())
+
+GL_CALLS(WRAP_VOID, WRAP_RET, WRAP_VOID0, WRAP_RET0)
+
+#define INSTALL(name, params, args) if (real->name) wrapped.name = _##name;
+#define INSTALL_R(type, name, params, args) INSTALL(name, params, args)
+#define INSTALL0(name) INSTALL(name, , )
+#define INSTALL0_R(type, name) INSTALL(name, , )
+
+static int
+_cmp(const void *a, const void *b)
+{
+   uint64_t x = report_times[*(const int *)a], y = report_times[*(const int *)b];
+
+   return x < y ? 1 : x > y ? -1 : 0;
+}
+
+Evas_GL_API *
+gl_profile_api(Evas_GL_API *api)
+{
+   const char *env;
+
+   if (!enabled || !api)
+      return api;
+   if (api == real)
+      return &wrapped;
+
+   if (enabled < 0) {
+      env = getenv("GL_PROFILE");
+      enabled = env && atoi(env) > 0;
+      if (!enabled)
+         return api;
+      report_frames = atoi(env);
+      env = getenv("GL_PROFILE_TOP");
+      top = env && atoi(env) > 0 ? atoi(env) : 10;
+   }
+
+   if (real) {
+      printf("gl profile: a second GL API table, left unprofiled\n");
+      return api;
+   }
+
+   real = api;
+   wrapped = *api;
+   GL_CALLS(INSTALL, INSTALL_R, INSTALL0, INSTALL0_R)
+
+   return &wrapped;
+}
+
+void
+gl_profile_frame(void)
+{
+   int order[GL_CALL_LAST];
+   unsigned long calls = 0;
+   uint64_t time = 0;
+   int i, n = 0;
+
+   if (enabled <= 0 || ++frames < report_frames)
+      return;
+
+   for (i = 0; i < GL_CALL_LAST; i++) {
+      report_counts[i] = __atomic_exchange_n(&counts[i], 0, __ATOMIC_RELAXED);
+      report_times[i] = __atomic_exchange_n(&times[i], 0, __ATOMIC_RELAXED);
+      calls += report_counts[i];
+      time += report_times[i];
+      if (report_counts[i])
+         order[n++] = i;
+   }
+   qsort(order, n, sizeof(int), _cmp);
+
+   printf("gl profile: %d frames, %.1f GL calls/frame, %.3f ms/frame in GL\n",
+          frames, (double)calls / frames, time / 1e6 / frames);
+   for (i = 0; i < n && i < top; i++)
+      printf("  %-28s %9.1f calls/frame %9.3f ms/frame %5.1f%% %9.3f us/call\n",
+             gl_call_names[order[i]], (double)report_counts[order[i]] / frames,
+             report_times[order[i]] / 1e6 / frames,
+             time ? report_times[order[i]] * 100.0 / time : 0.0,
+             report_times[order[i]] / 1e3 / report_counts[order[i]]);
+
+   frames = 0;
+}
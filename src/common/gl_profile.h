@@ -0,0 +1,24 @@
+#ifndef GL_PROFILE_H
+#define GL_PROFILE_H
+
+#include <Evas_GL.h>
+
+/*
+ * GL call profiler.
+ *
+ * GL_PROFILE=<frames> makes gl_profile_api() hand out an instrumented
+ * copy of the Evas GL API table, in which every entry point listed in
+ * gl_calls.h counts its calls and the wall clock time spent in it, which
+ * includes the time the driver makes the thread wait.  Every <frames>
+ * frames, as marked by gl_profile_frame(), it prints the GL calls and
+ * time per frame and the GL_PROFILE_TOP (default 10) entry points that
+ * took the most time.  Calls from all threads add up.  Without
+ * GL_PROFILE the table passes through untouched.
+ *
+ * Only one table is wrapped: a process drawing with GLES 1 and GLES 2
+ * contexts gets the second one back unprofiled.
+ */
+Evas_GL_API *gl_profile_api(Evas_GL_API *api);
+void         gl_profile_frame(void);
+
+#endif
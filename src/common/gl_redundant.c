@@ -0,0 +1,662 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <link.h>
+#include "gl_calls.h"
+#include "gl_redundant.h"
+
+/* powers of two */
+#define SHADOWS 4096
+#define SITES   1024
+
+#define SHADOW_MAX 64   /* bytes of state per key, a 4x4 matrix */
+
+typedef struct {
+   uint64_t key;   /* 0 for a free slot */
+   uint32_t size;
+   unsigned char value[SHADOW_MAX];
+} Shadow;
+
+typedef struct {
+   void *addr;
+   Gl_Call call;
+   unsigned long calls, redundant;
+   char *where;
+} Site;
+
+/* a GLES 1 matrix, as the hash of the load and operations building it */
+typedef struct {
+   uint64_t chain, last;
+   Site *site;   /* of the load that started the chain */
+   int valid, last_valid;
+} Matrix;
+
+/* the shadow of one context */
+typedef struct {
+   Evas_GL_Context *ctx;
+   Shadow shadows[SHADOWS];
+   Matrix matrices[3];
+
+   /* state the keys depend on */
+   GLenum unit, matrix_mode;
+   GLuint vao, program, array_buffer;
+} Context;
+
+#define CONTEXTS 8
+
+static int enabled = -1;   /* GL_REDUNDANT not read yet */
+static int report_frames, top, frames;
+static Evas_GL_API *real, checked, wrapped;
+static int warned_thread, warned_contexts;
+
+static Site sites[SITES];
+static Context *contexts[CONTEXTS];
+static Context *cur;   /* of the call being checked */
+static void *caller;   /* its return address, taken by the gate */
+
+#define SITE caller
+
+/* a piece of state: the call that sets it and up to two selectors */
+#define KEY(call, a, b) \
+   ((((uint64_t)(call) + 1) << 56) | (((uint64_t)(a) & 0xffffff) << 32) | (uint32_t)(b))
+
+static Site *
+_site(Gl_Call call, void *addr)
+{
+   unsigned int i, h = ((uintptr_t)addr * 2654435761u) >> 4;
+
+   for (i = 0; i < SITES; i++) {
+      Site *s = &sites[(h + i) & (SITES - 1)];
+
+      if (s->addr == addr && s->call == call)
+         return s;
+      if (!s->addr) {
+         s->addr = addr;
+         s->call = call;
+         return s;
+      }
+   }
+
+   return NULL;
+}
+
+/* Stores the value under key, returns whether it was there already. */
+static int
+_shadow(uint64_t key, const void *value, size_t size)
+{
+   unsigned int i, h = (key * 0x9e3779b97f4a7c15ull) >> 52;
+
+   if (!size || size > SHADOW_MAX)
+      return 0;
+
+   for (i = 0; i < SHADOWS; i++) {
+      Shadow *s = &cur->shadows[(h + i) & (SHADOWS - 1)];
+
+      if (s->key == key) {
+         if (s->size == size && !memcmp(s->value, value, size))
+            return 1;
+         s->size = size;
+         memcpy(s->value, value, size);
+         return 0;
+      }
+      if (!s->key) {
+         s->key = key;
+         s->size = size;
+         memcpy(s->value, value, size);
+         return 0;
+      }
+   }
+
+   return 0;
+}
+
+static void
+_check(Gl_Call call, void *addr, uint64_t key, const void *value, size_t size)
+{
+   Site *s = _site(call, addr);
+   int same = _shadow(key, value, size);
+
+   if (s) {
+      s->calls++;
+      s->redundant += same;
+   }
+}
+
+/* objects may be shared between the contexts, so all shadows go */
+static void
+_reset(void)
+{
+   int i;
+
+   for (i = 0; i < CONTEXTS && contexts[i]; i++)
+      memset(contexts[i]->shadows, 0, sizeof(contexts[i]->shadows));
+}
+
+#define PACK(x) memcpy(v + n, &x, sizeof(x)); n += sizeof(x);
+
+/* state set to values, a list of arguments, under a key of the group's
+ * call and selectors a and b */
+#define STATE(name, params, args, group, a, b, values) \
+   static void \
+   _##name params \
+   { \
+      unsigned char v[SHADOW_MAX]; \
+      size_t n = 0; \
+      GL_FOR_EACH(PACK, GL_STRIP values) \
+      _check(GL_CALL_##name, SITE, KEY(GL_CALL_##group, a, b), v, n); \
+      real->name args; \
+   }
+
+STATE(glBindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer),
+      glBindBufferBase, target, index, (buffer))
+STATE(glBindTexture, (GLenum target, GLuint texture), (target, texture),
+      glBindTexture, target, cur->unit, (texture))
+STATE(glBindTransformFeedback, (GLenum target, GLuint id), (target, id),
+      glBindTransformFeedback, target, 0, (id))
+STATE(glBlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor),
+      glBlendFunc, 0, 0, (sfactor, dfactor))
+STATE(glClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha),
+      glClearColor, 0, 0, (red, green, blue, alpha))
+STATE(glCullFace, (GLenum mode), (mode),
+      glCullFace, 0, 0, (mode))
+STATE(glDepthFunc, (GLenum func), (func),
+      glDepthFunc, 0, 0, (func))
+STATE(glMaterialf, (GLenum face, GLenum pname, GLfloat param), (face, pname, param),
+      glMaterialfv, face, pname, (param))
+STATE(glNormal3f, (GLfloat nx, GLfloat ny, GLfloat nz), (nx, ny, nz),
+      glNormal3f, 0, 0, (nx, ny, nz))
+STATE(glPixelStorei, (GLenum pname, GLint param), (pname, param),
+      glPixelStorei, pname, 0, (param))
+STATE(glShadeModel, (GLenum mode), (mode),
+      glShadeModel, 0, 0, (mode))
+STATE(glUniform1i, (GLint location, GLint v0), (location, v0),
+      glUniform1i, cur->program, location, (v0))
+STATE(glUniform2f, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1),
+      glUniform2f, cur->program, location, (v0, v1))
+STATE(glVertexAttribDivisor, (GLuint index, GLuint divisor), (index, divisor),
+      glVertexAttribDivisor, index, cur->vao, (divisor))
+STATE(glViewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height),
+      glViewport, 0, 0, (x, y, width, height))
+
+/* vertex array pointers, which also take the array buffer binding */
+STATE(glColorPointer, (GLint size, GLenum type, GLsizei stride, const void *pointer),
+      (size, type, stride, pointer),
+      glColorPointer, 0, cur->vao, (size, type, stride, pointer, cur->array_buffer))
+STATE(glNormalPointer, (GLenum type, GLsizei stride, const void *pointer), (type, stride, pointer),
+      glNormalPointer, 0, cur->vao, (type, stride, pointer, cur->array_buffer))
+STATE(glTexCoordPointer, (GLint size, GLenum type, GLsizei stride, const void *pointer),
+      (size, type, stride, pointer),
+      glTexCoordPointer, 0, cur->vao, (size, type, stride, pointer, cur->array_buffer))
+STATE(glVertexPointer, (GLint size, GLenum type, GLsizei stride, const void *pointer),
+      (size, type, stride, pointer),
+      glVertexPointer, 0, cur->vao, (size, type, stride, pointer, cur->array_buffer))
+STATE(glVertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized,
+                              GLsizei stride, const void *pointer),
+      (index, size, type, normalized, stride, pointer),
+      glVertexAttribPointer, index, cur->vao, (size, type, normalized, stride, pointer, cur->array_buffer))
+
+/* on and off switches sharing one piece of state */
+#define TOGGLE(name, type, group, b, on) \
+   static void \
+   _##name(type x) \
+   { \
+      GLboolean v = on; \
+      _check(GL_CALL_##name, SITE, KEY(GL_CALL_##group, x, b), &v, sizeof(v)); \
+      real->name(x); \
+   }
+
+TOGGLE(glEnable, GLenum, glEnable, 0, GL_TRUE)
+TOGGLE(glDisable, GLenum, glEnable, 0, GL_FALSE)
+TOGGLE(glEnableClientState, GLenum, glEnableClientState, 0, GL_TRUE)
+TOGGLE(glDisableClientState, GLenum, glEnableClientState, 0, GL_FALSE)
+TOGGLE(glEnableVertexAttribArray, GLuint, glEnableVertexAttribArray, cur->vao, GL_TRUE)
+TOGGLE(glDisableVertexAttribArray, GLuint, glEnableVertexAttribArray, cur->vao, GL_FALSE)
+
+/* state the keys of other state depend on */
+
+static void
+_glActiveTexture(GLenum texture)
+{
+   _check(GL_CALL_glActiveTexture, SITE, KEY(GL_CALL_glActiveTexture, 0, 0), &texture, sizeof(texture));
+   cur->unit = texture;
+   real->glActiveTexture(texture);
+}
+
+static void
+_glBindBuffer(GLenum target, GLuint buffer)
+{
+   /* the index buffer binding belongs to the vertex array object */
+   _check(GL_CALL_glBindBuffer, SITE,
+          KEY(GL_CALL_glBindBuffer, target, target == GL_ELEMENT_ARRAY_BUFFER ? cur->vao : 0),
+          &buffer, sizeof(buffer));
+   if (target == GL_ARRAY_BUFFER)
+      cur->array_buffer = buffer;
+   real->glBindBuffer(target, buffer);
+}
+
+static void
+_glBindVertexArray(GLuint array)
+{
+   _check(GL_CALL_glBindVertexArray, SITE, KEY(GL_CALL_glBindVertexArray, 0, 0), &array, sizeof(array));
+   cur->vao = array;
+   real->glBindVertexArray(array);
+}
+
+static void
+_glUseProgram(GLuint p)
+{
+   _check(GL_CALL_glUseProgram, SITE, KEY(GL_CALL_glUseProgram, 0, 0), &p, sizeof(p));
+   cur->program = p;
+   real->glUseProgram(p);
+}
+
+static void
+_glMatrixMode(GLenum mode)
+{
+   _check(GL_CALL_glMatrixMode, SITE, KEY(GL_CALL_glMatrixMode, 0, 0), &mode, sizeof(mode));
+   cur->matrix_mode = mode;
+   real->glMatrixMode(mode);
+}
+
+/* values passed by pointer */
+
+static size_t
+_light_values(GLenum pname)
+{
+   switch (pname) {
+   case GL_AMBIENT:
+   case GL_DIFFUSE:
+   case GL_SPECULAR:
+   case GL_POSITION:
+   case GL_EMISSION:
+   case GL_AMBIENT_AND_DIFFUSE:
+      return 4;
+   case GL_SPOT_DIRECTION:
+      return 3;
+   }
+
+   return 1;
+}
+
+static void
+_glLightfv(GLenum light, GLenum pname, const GLfloat *params)
+{
+   _check(GL_CALL_glLightfv, SITE, KEY(GL_CALL_glLightfv, light, pname),
+          params, _light_values(pname) * sizeof(GLfloat));
+   real->glLightfv(light, pname, params);
+}
+
+static void
+_glMaterialfv(GLenum face, GLenum pname, const GLfloat *params)
+{
+   _check(GL_CALL_glMaterialfv, SITE, KEY(GL_CALL_glMaterialfv, face, pname),
+          params, _light_values(pname) * sizeof(GLfloat));
+   real->glMaterialfv(face, pname, params);
+}
+
+static void
+_glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value)
+{
+   /* arrays of matrices are counted, not shadowed */
+   _check(GL_CALL_glUniformMatrix4fv, SITE, KEY(GL_CALL_glUniformMatrix4fv, cur->program, location),
+          value, count == 1 && !transpose ? 16 * sizeof(GLfloat) : 0);
+   real->glUniformMatrix4fv(location, count, transpose, value);
+}
+
+/* GLES 1 matrices */
+
+static Matrix *
+_matrix(void)
+{
+   switch (cur->matrix_mode) {
+   case GL_PROJECTION:
+      return &cur->matrices[1];
+   case GL_TEXTURE:
+      return &cur->matrices[2];
+   }
+
+   return &cur->matrices[0];
+}
+
+static uint64_t
+_hash(uint64_t h, Gl_Call call, const void *p, size_t n)
+{
+   const unsigned char *c = p;
+
+   h = (h ^ call) * 0x100000001b3ull;
+   while (n--)
+      h = (h ^ *c++) * 0x100000001b3ull;
+
+   return h;
+}
+
+static void
+_matrix_load(Gl_Call call, void *addr, const void *p, size_t n)
+{
+   Matrix *m = _matrix();
+   Site *s = _site(call, addr);
+
+   /* the previous chain is complete now */
+   if (m->valid && m->last_valid && m->chain == m->last && m->site)
+      m->site->redundant++;
+   m->last = m->chain;
+   m->last_valid = m->valid;
+
+   m->chain = _hash(0xcbf29ce484222325ull, call, p, n);
+   m->valid = 1;
+   m->site = s;
+   if (s)
+      s->calls++;
+}
+
+static void
+_matrix_op(Gl_Call call, const void *p, size_t n)
+{
+   Matrix *m = _matrix();
+
+   if (m->valid)
+      m->chain = _hash(m->chain, call, p, n);
+}
+
+static void
+_glLoadIdentity(void)
+{
+   _matrix_load(GL_CALL_glLoadIdentity, SITE, NULL, 0);
+   real->glLoadIdentity();
+}
+
+static void
+_glLoadMatrixf(const GLfloat *m)
+{
+   _matrix_load(GL_CALL_glLoadMatrixf, SITE, m, 16 * sizeof(GLfloat));
+   real->glLoadMatrixf(m);
+}
+
+#define MATRIX_OP(name, params, args) \
+   static void \
+   _##name params \
+   { \
+      unsigned char v[SHADOW_MAX]; \
+      size_t n = 0; \
+      GL_FOR_EACH(PACK, GL_STRIP args) \
+      _matrix_op(GL_CALL_##name, v, n); \
+      real->name args; \
+   }
+
+MATRIX_OP(glFrustumf, (GLfloat l, GLfloat r, GLfloat b, GLfloat t, GLfloat n_, GLfloat f),
+          (l, r, b, t, n_, f))
+MATRIX_OP(glRotatef, (GLfloat angle, GLfloat x, GLfloat y, GLfloat z), (angle, x, y, z))
+MATRIX_OP(glScalef, (GLfloat x, GLfloat y, GLfloat z), (x, y, z))
+MATRIX_OP(glTranslatef, (GLfloat x, GLfloat y, GLfloat z), (x, y, z))
+
+/* the stack hides what the current matrix was built from */
+static void
+_glPushMatrix(void)
+{
+   _matrix()->valid = _matrix()->last_valid = 0;
+   real->glPushMatrix();
+}
+
+static void
+_glPopMatrix(void)
+{
+   _matrix()->valid = _matrix()->last_valid = 0;
+   real->glPopMatrix();
+}
+
+/* calls after which the shadow no longer holds */
+#define RESET(name, params, args) \
+   static void \
+   _##name params \
+   { \
+      _reset(); \
+      real->name args; \
+   }
+
+RESET(glDeleteBuffers, (GLsizei n, const GLuint *buffers), (n, buffers))
+RESET(glDeleteProgram, (GLuint p), (p))
+RESET(glDeleteTextures, (GLsizei n, const GLuint *textures), (n, textures))
+RESET(glDeleteVertexArrays, (GLsizei n, const GLuint *arrays), (n, arrays))
+RESET(glLinkProgram, (GLuint p), (p))
+
+/* The sites and shadows belong to the drawing thread, calls from other
+ * threads go straight to GL.  Each context gets its own shadow. */
+static Evas_GL_API *
+_checker(void)
+{
+   Evas_GL_Context *ctx;
+   int i;
+
+   if (!gl_calls_drawing_thread()) {
+      if (!__atomic_exchange_n(&warned_thread, 1, __ATOMIC_RELAXED))
+         printf("gl redundant: calls from a second thread are not checked\n");
+      return real;
+   }
+
+   ctx = gl_calls_context();
+   if (cur && cur->ctx == ctx)
+      return &checked;
+
+   for (i = 0; i < CONTEXTS && contexts[i]; i++) {
+      if (contexts[i]->ctx == ctx) {
+         cur = contexts[i];
+         return &checked;
+      }
+   }
+   if (i == CONTEXTS || !(contexts[i] = calloc(1, sizeof(Context)))) {
+      if (!warned_contexts) {
+         printf("gl redundant: no room for another context, it is not checked\n");
+         warned_contexts = 1;
+      }
+      return real;
+   }
+
+   cur = contexts[i];
+   cur->ctx = ctx;
+   cur->unit = GL_TEXTURE0;
+   cur->matrix_mode = GL_MODELVIEW;
+
+   return &checked;
+}
+
+/* inline as only the entry points checked are installed */
+#define GATE_VOID(name, params, args) \
+   static inline void \
+   _gate_##name params \
+   { \
+      Evas_GL_API *api = _checker(); \
+      if (api == &checked) \
+         caller = __builtin_return_address(0); \
+      api->name args; \
+   }
+
+#define GATE_RET(type, name, params, args) \
+   static inline type \
+   _gate_##name params \
+   { \
+      Evas_GL_API *api = _checker(); \
+      if (api == &checked) \
+         caller = __builtin_return_address(0); \
+      return api->name args; \
+   }
+
+#define GATE_VOID0(name) GATE_VOID(name, (void), ())
+#define GATE_RET0(type, name) GATE_RET(type, name, (void), ())
+
+GL_CALLS(GATE_VOID, GATE_RET, GATE_VOID0, GATE_RET0)
+
+#define INSTALL(name) \
+   if (real->name) { \
+      checked.name = _##name; \
+      wrapped.name = _gate_##name; \
+   }
+
+/* Names a call site as function (file:line) through addr2line, or as
+ * binary+offset. */
+static const char *
+_where(Site *s)
+{
+   char cmd[4096], func[256], line[512];
+   const ElfW(Ehdr) *elf;
+   const char *file;
+   uintptr_t addr;
+   Dl_info info;
+   FILE *p;
+
+   if (s->where)
+      return s->where;
+
+   if (!dladdr(s->addr, &info) || !info.dli_fbase)
+      return "?";
+
+   /* the return address is past the call */
+   addr = (uintptr_t)s->addr - 1;
+   elf = info.dli_fbase;
+   if (elf->e_type == ET_DYN)
+      addr -= (uintptr_t)info.dli_fbase;
+   file = info.dli_fname;
+   if (!file || !*file || access(file, R_OK))
+      file = "/proc/self/exe";
+
+   snprintf(cmd, sizeof(cmd), "addr2line -f -s -e '%s' %#lx 2>/dev/null", file, (unsigned long)addr);
+   p = popen(cmd, "r");
+   if (p) {
+      if (fgets(func, sizeof(func), p) && fgets(line, sizeof(line), p) && line[0] != '?') {
+         func[strcspn(func, "\n")] = 0;
+         line[strcspn(line, "\n")] = 0;
+         if (asprintf(&s->where, "%s (%s)", func, line) < 0)
+            s->where = NULL;
+      }
+      pclose(p);
+   }
+   if (!s->where && asprintf(&s->where, "%s+%#lx", info.dli_fname, (unsigned long)addr) < 0)
+      s->where = NULL;
+
+   return s->where ? s->where : "?";
+}
+
+static int
+_cmp(const void *a, const void *b)
+{
+   unsigned long x = sites[*(const int *)a].redundant, y = sites[*(const int *)b].redundant;
+
+   return x < y ? 1 : x > y ? -1 : 0;
+}
+
+Evas_GL_API *
+gl_redundant_api(Evas_GL_API *api)
+{
+   const char *env;
+
+   if (!enabled || !api)
+      return api;
+   if (api == real)
+      return &wrapped;
+
+   if (enabled < 0) {
+      env = getenv("GL_REDUNDANT");
+      enabled = env && atoi(env) > 0;
+      if (!enabled)
+         return api;
+      report_frames = atoi(env);
+      env = getenv("GL_REDUNDANT_TOP");
+      top = env && atoi(env) > 0 ? atoi(env) : 20;
+   }
+
+   if (real) {
+      printf("gl redundant: a second GL API table, left unchecked\n");
+      return api;
+   }
+
+   real = api;
+   checked = *api;
+   wrapped = *api;
+
+   INSTALL(glActiveTexture)
+   INSTALL(glBindBuffer)
+   INSTALL(glBindBufferBase)
+   INSTALL(glBindTexture)
+   INSTALL(glBindTransformFeedback)
+   INSTALL(glBindVertexArray)
+   INSTALL(glBlendFunc)
+   INSTALL(glClearColor)
+   INSTALL(glColorPointer)
+   INSTALL(glCullFace)
+   INSTALL(glDeleteBuffers)
+   INSTALL(glDeleteProgram)
+   INSTALL(glDeleteTextures)
+   INSTALL(glDeleteVertexArrays)
+   INSTALL(glDepthFunc)
+   INSTALL(glDisable)
+   INSTALL(glDisableClientState)
+   INSTALL(glDisableVertexAttribArray)
+   INSTALL(glEnable)
+   INSTALL(glEnableClientState)
+   INSTALL(glEnableVertexAttribArray)
+   INSTALL(glFrustumf)
+   INSTALL(glLightfv)
+   INSTALL(glLinkProgram)
+   INSTALL(glLoadIdentity)
+   INSTALL(glLoadMatrixf)
+   INSTALL(glMaterialf)
+   INSTALL(glMaterialfv)
+   INSTALL(glMatrixMode)
+   INSTALL(glNormal3f)
+   INSTALL(glNormalPointer)
+   INSTALL(glPixelStorei)
+   INSTALL(glPopMatrix)
+   INSTALL(glPushMatrix)
+   INSTALL(glRotatef)
+   INSTALL(glScalef)
+   INSTALL(glShadeModel)
+   INSTALL(glTexCoordPointer)
+   INSTALL(glTranslatef)
+   INSTALL(glUniform1i)
+   INSTALL(glUniform2f)
+   INSTALL(glUniformMatrix4fv)
+   INSTALL(glUseProgram)
+   INSTALL(glVertexAttribDivisor)
+   INSTALL(glVertexAttribPointer)
+   INSTALL(glVertexPointer)
+   INSTALL(glViewport)
+
+   return &wrapped;
+}
+
+void
+gl_redundant_frame(void)
+{
+   int order[SITES];
+   unsigned long calls = 0, redundant = 0;
+   int i, n = 0;
+
+   if (enabled <= 0 || !gl_calls_drawing_thread() || ++frames < report_frames)
+      return;
+
+   for (i = 0; i < SITES; i++) {
+      if (!sites[i].calls)
+         continue;
+      calls += sites[i].calls;
+      redundant += sites[i].redundant;
+      if (sites[i].redundant)
+         order[n++] = i;
+   }
+   qsort(order, n, sizeof(int), _cmp);
+
+   printf("gl redundant: %d frames, %.1f of %.1f state calls/frame redundant (%.1f%%)\n",
+          frames, (double)redundant / frames, (double)calls / frames,
+          calls ? redundant * 100.0 / calls : 0.0);
+   for (i = 0; i < n && i < top; i++) {
+      Site *s = &sites[order[i]];
+
+      printf("  %-24s %9.1f of %9.1f/frame  %s\n", gl_call_names[s->call],
+             (double)s->redundant / frames, (double)s->calls / frames, _where(s));
+   }
+
+   frames = 0;
+   for (i = 0; i < SITES; i++)
+      sites[i].calls = sites[i].redundant = 0;
+}
@@ -0,0 +1,35 @@
+#ifndef GL_REDUNDANT_H
+#define GL_REDUNDANT_H
+
+#include <Evas_GL.h>
+
+/*
+ * Redundant GL state call detector.
+ *
+ * GL_REDUNDANT=<frames> makes gl_redundant_api() hand out a copy of the
+ * Evas GL API table that shadows the state the demos set: capabilities,
+ * bindings, blend/depth/cull state, the viewport, uniforms, vertex array
+ * setup, GLES 1 lights, materials and matrices.  A call that leaves its
+ * state as it was is counted against its call site, the return address
+ * of the wrapper.  Every <frames> frames, as marked by
+ * gl_redundant_frame(), it prints the GL_REDUNDANT_TOP (default 20) call
+ * sites with the most redundant calls per frame, as function (file:line)
+ * when addr2line finds debug information, as binary+offset otherwise.
+ *
+ * A matrix counts as redundant when glLoadIdentity() or glLoadMatrixf()
+ * and the operations up to the next load rebuild the matrix already
+ * current; the load's call site gets the blame.
+ *
+ * Wrap this table last, around gl_profile_api() and the like, so that the
+ * return addresses are the demo's.  Each context, up to 8, gets its own
+ * shadow, found through the context current at each call; the call sites
+ * and counts are shared.  Only the drawing thread is checked: calls from
+ * other threads, such as pbuffer's PBUFFER_FARM workers, pass through
+ * with a notice.  The shadow assumes nobody else changes a context's
+ * state: Evas GL's own changes, under direct rendering mostly, go unseen.
+ * Deleting objects or linking a program starts every shadow over.
+ */
+Evas_GL_API *gl_redundant_api(Evas_GL_API *api);
+void         gl_redundant_frame(void);
+
+#endif
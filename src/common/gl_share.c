@@ -0,0 +1,258 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <Ecore.h>
+#include "gl_share.h"
+
+#define GL_SHARE_MAX_CONTEXTS 32
+
+typedef struct _Gl_Share_Resource Gl_Share_Resource;
+
+struct _Gl_Share_Resource {
+   char *name;
+   GLuint id;
+   Eina_Bool texture;
+   size_t bytes;
+   double upload;   /* seconds, including the glFinish() */
+   int reuses;
+};
+
+struct _Gl_Share {
+   Evas_GL *evas_gl;
+   Evas_GL_Context *root;
+   Evas_GL_Context_Version version;
+
+   Evas_GL_Context *loader;
+   Evas_GL_Surface *loader_surface;
+
+   Evas_GL_Context *contexts[GL_SHARE_MAX_CONTEXTS];
+   int count;
+
+   Gl_Share_Resource *res;
+   int nres, size;
+
+   /* restored after an upload */
+   Evas_GL_Context *saved_context;
+   Evas_GL_Surface *saved_surface;
+};
+
+Gl_Share *
+gl_share_new(Evas_GL *evas_gl, Evas_GL_Context *root, Evas_GL_Context_Version version)
+{
+   Evas_GL_Config *config;
+   Gl_Share *share;
+
+   if (!evas_gl || !root)
+      return NULL;
+
+   share = calloc(1, sizeof(Gl_Share));
+   if (!share)
+      return NULL;
+
+   share->evas_gl = evas_gl;
+   share->root = root;
+   share->version = version;
+
+   config = evas_gl_config_new();
+   config->color_format = EVAS_GL_RGBA_8888;
+   config->depth_bits = EVAS_GL_DEPTH_NONE;
+   config->stencil_bits = EVAS_GL_STENCIL_NONE;
+   config->options_bits = EVAS_GL_OPTIONS_NONE;
+   share->loader_surface = evas_gl_pbuffer_surface_create(evas_gl, config, 1, 1, NULL);
+   evas_gl_config_free(config);
+
+   if (share->loader_surface)
+      share->loader = evas_gl_context_version_create(evas_gl, root, version);
+   if (!share->loader)
+      printf("gl_share: no loader context, uploading on the current context\n");
+
+   return share;
+}
+
+Evas_GL_Context *
+gl_share_context_add(Gl_Share *share)
+{
+   Evas_GL_Context *ctx;
+
+   if (share->count == GL_SHARE_MAX_CONTEXTS)
+      return NULL;
+
+   ctx = evas_gl_context_version_create(share->evas_gl, share->root, share->version);
+   if (ctx)
+      share->contexts[share->count++] = ctx;
+
+   return ctx;
+}
+
+static Evas_GL_API *
+_upload_begin(Gl_Share *share)
+{
+   share->saved_context = evas_gl_current_context_get(share->evas_gl);
+   share->saved_surface = evas_gl_current_surface_get(share->evas_gl);
+
+   if (share->loader &&
+       evas_gl_make_current(share->evas_gl, share->loader_surface, share->loader))
+      return evas_gl_context_api_get(share->evas_gl, share->loader);
+
+   return evas_gl_context_api_get(share->evas_gl, share->root);
+}
+
+static void
+_upload_end(Gl_Share *share, Evas_GL_API *gl)
+{
+   /* other contexts may only use the object once the upload completed */
+   gl->glFinish();
+
+   if (share->loader)
+      evas_gl_make_current(share->evas_gl, share->saved_surface, share->saved_context);
+}
+
+static Gl_Share_Resource *
+_resource_add(Gl_Share *share, const char *name)
+{
+   Gl_Share_Resource *r;
+
+   if (share->nres == share->size) {
+      int size = share->size ? share->size * 2 : 8;
+
+      r = realloc(share->res, size * sizeof(Gl_Share_Resource));
+      if (!r)
+         return NULL;
+      share->res = r;
+      share->size = size;
+   }
+
+   r = &share->res[share->nres++];
+   memset(r, 0, sizeof(Gl_Share_Resource));
+   r->name = strdup(name);
+
+   return r;
+}
+
+GLuint
+gl_share_get(Gl_Share *share, const char *name)
+{
+   int i;
+
+   for (i = 0; i < share->nres; i++) {
+      if (!strcmp(share->res[i].name, name)) {
+         share->res[i].reuses++;
+         return share->res[i].id;
+      }
+   }
+
+   return 0;
+}
+
+GLuint
+gl_share_texture(Gl_Share *share, const char *name, int w, int h,
+                 const void *rgba, GLint filter, GLint wrap)
+{
+   Gl_Share_Resource *r;
+   Evas_GL_API *gl;
+   double t;
+
+   r = _resource_add(share, name);
+   if (!r)
+      return 0;
+
+   t = ecore_time_get();
+   gl = _upload_begin(share);
+   gl->glGenTextures(1, &r->id);
+   gl->glBindTexture(GL_TEXTURE_2D, r->id);
+   gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+   gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+   gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+   gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+   gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+   gl->glBindTexture(GL_TEXTURE_2D, 0);
+   _upload_end(share, gl);
+
+   r->texture = EINA_TRUE;
+   r->bytes = (size_t) w * h * 4;
+   r->upload = ecore_time_get() - t;
+
+   return r->id;
+}
+
+GLuint
+gl_share_buffer(Gl_Share *share, const char *name, GLenum target,
+                size_t size, const void *data)
+{
+   Gl_Share_Resource *r;
+   Evas_GL_API *gl;
+   double t;
+
+   r = _resource_add(share, name);
+   if (!r)
+      return 0;
+
+   t = ecore_time_get();
+   gl = _upload_begin(share);
+   gl->glGenBuffers(1, &r->id);
+   gl->glBindBuffer(target, r->id);
+   gl->glBufferData(target, size, data, GL_STATIC_DRAW);
+   gl->glBindBuffer(target, 0);
+   _upload_end(share, gl);
+
+   r->bytes = size;
+   r->upload = ecore_time_get() - t;
+
+   return r->id;
+}
+
+void
+gl_share_report(const Gl_Share *share)
+{
+   size_t saved = 0;
+   double avoided = 0.0;
+   int i;
+
+   printf("gl_share: %d contexts share %d objects%s\n",
+          share->count + 1, share->nres, share->loader ? " (uploaded on a loader context)" : "");
+   for (i = 0; i < share->nres; i++) {
+      const Gl_Share_Resource *r = &share->res[i];
+
+      printf("  %-16s %s %7zu bytes, upload %.3f ms, reused %d times\n",
+             r->name, r->texture ? "texture" : "buffer ", r->bytes,
+             r->upload * 1000.0, r->reuses);
+      saved += r->bytes * r->reuses;
+      avoided += r->upload * r->reuses;
+   }
+   printf("gl_share: %zu bytes of GL memory saved, %.3f ms of uploads avoided\n",
+          saved, avoided * 1000.0);
+}
+
+void
+gl_share_free(Gl_Share *share)
+{
+   Evas_GL_API *gl;
+   int i;
+
+   if (!share)
+      return;
+
+   if (share->nres) {
+      gl = _upload_begin(share);
+      for (i = 0; i < share->nres; i++) {
+         if (share->res[i].texture)
+            gl->glDeleteTextures(1, &share->res[i].id);
+         else
+            gl->glDeleteBuffers(1, &share->res[i].id);
+      }
+      _upload_end(share, gl);
+   }
+
+   for (i = 0; i < share->nres; i++)
+      free(share->res[i].name);
+   free(share->res);
+
+   for (i = 0; i < share->count; i++)
+      evas_gl_context_destroy(share->evas_gl, share->contexts[i]);
+   if (share->loader)
+      evas_gl_context_destroy(share->evas_gl, share->loader);
+   if (share->loader_surface)
+      evas_gl_surface_destroy(share->evas_gl, share->loader_surface);
+
+   free(share);
+}
@@ -0,0 +1,29 @@
+#ifndef GL_SHARE_H
+#define GL_SHARE_H
+
+#include <stddef.h>
+#include <Evas_GL.h>
+
+/*
+ * Textures and buffers shared between the contexts of one Evas_GL.
+ *
+ * Every context made by gl_share_context_add() shares objects with the
+ * root context, so a texture or mesh only has to be uploaded once.  The
+ * uploads go through a private loader context on a 1x1 pbuffer, which
+ * leaves the state of the rendering contexts alone.  Resources are looked
+ * up by name: gl_share_get() hands out the object another context already
+ * uploaded and counts the copy it saved, gl_share_report() prints the
+ * memory and upload time those copies would have cost.
+ */
+typedef struct _Gl_Share Gl_Share;
+
+Gl_Share        *gl_share_new(Evas_GL *evas_gl, Evas_GL_Context *root, Evas_GL_Context_Version version);
+void             gl_share_free(Gl_Share *share);
+Evas_GL_Context *gl_share_context_add(Gl_Share *share);
+
+GLuint           gl_share_get(Gl_Share *share, const char *name);
+GLuint           gl_share_texture(Gl_Share *share, const char *name, int w, int h, const void *rgba, GLint filter, GLint wrap);
+GLuint           gl_share_buffer(Gl_Share *share, const char *name, GLenum target, size_t size, const void *data);
+void             gl_share_report(const Gl_Share *share);
+
+#endif
@@ -0,0 +1,1036 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gl_calls.h"
+#include "gl_trace.h"
+
+#define ATTRIBS 16   /* generic attributes followed for client arrays */
+#define VAOS    64   /* vertex array objects whose index buffer is followed */
+#define MAPS    4    /* buffer ranges mapped at the same time */
+
+typedef struct {
+   int enabled, client;
+   GLint size;
+   GLenum type;
+   GLsizei stride;
+   GLboolean normalized;
+   const void *pointer;
+} Client_Array;
+
+typedef struct {
+   GLenum target;
+   GLsizeiptr length;
+   GLbitfield access;
+   void *ptr;
+} Map;
+
+static int enabled = -1;   /* GL_TRACE not read yet */
+static int recording, max_frames, frames;
+static Evas_GL_API *real, traced, wrapped;
+static Evas_GL_Context *context;   /* the one recorded */
+static int warned_thread, warned_context;
+static const char *path;
+static FILE *out;
+
+/* the frame being recorded */
+static unsigned char *buf;
+static size_t len, cap, rec;
+static unsigned long calls, bytes;
+
+/* GL state the recorder needs to know what memory a call reads */
+static GLuint array_buffer, pack_buffer, unpack_buffer, vao;
+static GLuint vao_elements[VAOS];
+static int unpack_alignment = 4;
+static Client_Array attribs[ATTRIBS], arrays[GL_TRACE_TEXCOORD];
+static Map maps[MAPS];
+static int warned;
+
+uint32_t
+gl_trace_calls_hash(void)
+{
+   uint32_t h = 2166136261u;
+   const char *s;
+   int i;
+
+   /* FNV-1a over the names, NUL separated */
+   for (i = 0; i < GL_CALL_LAST; i++) {
+      for (s = gl_call_names[i]; ; s++) {
+         h = (h ^ (unsigned char)*s) * 16777619u;
+         if (!*s)
+            break;
+      }
+   }
+
+   return h;
+}
+
+size_t
+gl_trace_pixels_size(int w, int h, GLenum format, GLenum type, int alignment)
+{
+   size_t pixel, row;
+   int components;
+
+   if (w <= 0 || h <= 0)
+      return 0;
+
+   switch (format) {
+   case GL_RGBA:
+      components = 4;
+      break;
+   case GL_RGB:
+      components = 3;
+      break;
+   case GL_LUMINANCE_ALPHA:
+      components = 2;
+      break;
+   default:
+      components = 1;
+      break;
+   }
+
+   switch (type) {
+   case GL_UNSIGNED_SHORT_5_6_5:
+   case GL_UNSIGNED_SHORT_4_4_4_4:
+   case GL_UNSIGNED_SHORT_5_5_5_1:
+      pixel = 2;
+      break;
+   case GL_UNSIGNED_SHORT:
+   case GL_HALF_FLOAT:
+      pixel = 2 * components;
+      break;
+   case GL_FLOAT:
+   case GL_UNSIGNED_INT:
+      pixel = 4 * components;
+      break;
+   default:
+      pixel = components;
+      break;
+   }
+
+   if (alignment < 1)
+      alignment = 1;
+   row = ((size_t)w * pixel + alignment - 1) / alignment * alignment;
+
+   return row * (h - 1) + (size_t)w * pixel;
+}
+
+static void *
+_reserve(size_t n)
+{
+   void *p;
+
+   if (len + n > cap) {
+      while (len + n > cap)
+         cap = cap ? cap * 2 : 65536;
+      p = realloc(buf, cap);
+      if (!p) {
+         fprintf(stderr, "gl trace: out of memory\n");
+         exit(1);
+      }
+      buf = p;
+   }
+   p = buf + len;
+   len += n;
+
+   return p;
+}
+
+static void
+_put(const void *p, size_t n)
+{
+   memcpy(_reserve(n), p, n);
+}
+
+static void
+_align(void)
+{
+   if (len % 4)
+      memset(_reserve(4 - len % 4), 0, 4 - len % 4);
+}
+
+static void
+_begin(unsigned int call, unsigned int flags)
+{
+   Gl_Trace_Record r;
+
+   r.call = call;
+   r.flags = flags;
+   r.size = 0;
+   rec = len;
+   _put(&r, sizeof(r));
+   calls++;
+}
+
+static void
+_blob(const void *p, size_t n)
+{
+   uint32_t l = n;
+
+   _align();
+   _put(&l, sizeof(l));
+   if (n)
+      _put(p, n);
+}
+
+static void
+_end(void)
+{
+   _align();
+   ((Gl_Trace_Record *)(buf + rec))->size = len - rec - sizeof(Gl_Trace_Record);
+}
+
+#define PUT(x) _put(&x, sizeof(x));
+
+/* Every call gets a wrapper recording its arguments and return value,
+ * and an argument writer for the wrappers further down that record more.
+ * They are inline as the entry points with their own wrapper leave the
+ * generated one unused. */
+#define TRACE_VOID(name, params, args) \
+   static inline void \
+   _put_##name params \
+   { \
+      GL_FOR_EACH(PUT, GL_STRIP args) \
+   } \
+   static inline void \
+   _##name params \
+   { \
+      real->name args; \
+      if (recording) { \
+         _begin(GL_CALL_##name, 0); \
+         _put_##name args; \
+         _end(); \
+      } \
+   }
+
+#define TRACE_RET(type, name, params, args) \
+   static inline void \
+   _put_##name params \
+   { \
+      GL_FOR_EACH(PUT, GL_STRIP args) \
+   } \
+   static inline type \
+   _##name params \
+   { \
+      type ret = real->name args; \
+      if (recording) { \
+         _begin(GL_CALL_##name, 0); \
+         _put_##name args; \
+         PUT(ret) \
+         _end(); \
+      } \
+      return ret; \
+   }
+
+#define TRACE_VOID0(name) \
+   static inline void \
+   _##name(void) \
+   { \
+      real->name(); \
+      if (recording) { \
+         _begin(GL_CALL_##name, 0); \
+         _end(); \
+      } \
+   }
+
+#define TRACE_RET0(type, name) \
+   static inline type \
+   _##name(void) \
+   { \
+      type ret = real->name(); \
+      if (recording) { \
+         _begin(GL_CALL_##name, 0); \
+         PUT(ret) \
+         _end(); \
+      } \
+      return ret; \
+   }
+
+GL_CALLS(TRACE_VOID, TRACE_RET, TRACE_VOID0, TRACE_RET0)
+
+/* buffer bindings and pixel store state */
+
+static GLuint *
+_binding(GLenum target)
+{
+   static GLuint unknown;
+
+   switch (target) {
+   case GL_ARRAY_BUFFER:
+      return &array_buffer;
+   case GL_ELEMENT_ARRAY_BUFFER:
+      if (vao < VAOS)
+         return &vao_elements[vao];
+      break;
+   case GL_PIXEL_PACK_BUFFER:
+      return &pack_buffer;
+   case GL_PIXEL_UNPACK_BUFFER:
+      return &unpack_buffer;
+   }
+
+   return &unknown;
+}
+
+static GLuint
+_element_buffer(void)
+{
+   /* a VAO out of range is taken to have an index buffer */
+   return vao < VAOS ? vao_elements[vao] : 1;
+}
+
+static void
+_trace_glBindBuffer(GLenum target, GLuint buffer)
+{
+   *_binding(target) = buffer;
+   _glBindBuffer(target, buffer);
+}
+
+static void
+_trace_glBindVertexArray(GLuint array)
+{
+   vao = array;
+   _glBindVertexArray(array);
+}
+
+static void
+_trace_glPixelStorei(GLenum pname, GLint param)
+{
+   if (pname == GL_UNPACK_ALIGNMENT)
+      unpack_alignment = param;
+   _glPixelStorei(pname, param);
+}
+
+/* Forgets the bindings of deleted buffers and vertex arrays. */
+static void
+_forget(Gl_Call call, GLsizei n, const GLuint *ids)
+{
+   GLuint *b[] = { &array_buffer, &pack_buffer, &unpack_buffer };
+   int i, j;
+
+   for (i = 0; i < n; i++) {
+      if (!ids[i])
+         continue;
+      if (call == GL_CALL_glDeleteBuffers) {
+         for (j = 0; j < (int)(sizeof(b) / sizeof(b[0])); j++)
+            if (*b[j] == ids[i])
+               *b[j] = 0;
+         if (vao < VAOS && vao_elements[vao] == ids[i])
+            vao_elements[vao] = 0;
+      }
+      else if (call == GL_CALL_glDeleteVertexArrays) {
+         if (ids[i] < VAOS)
+            vao_elements[ids[i]] = 0;
+         if (vao == ids[i])
+            vao = 0;
+      }
+   }
+}
+
+/* glGen* and glDelete*: the names go with the record, written by GL for
+ * the former */
+#define TRACE_IDS(name, type) \
+   static void \
+   _trace_##name(GLsizei n, type *ids) \
+   { \
+      if (GL_CALL_##name == GL_CALL_glDeleteBuffers || \
+          GL_CALL_##name == GL_CALL_glDeleteVertexArrays) \
+         _forget(GL_CALL_##name, n, ids); \
+      real->name(n, ids); \
+      if (recording) { \
+         _begin(GL_CALL_##name, 0); \
+         _put_##name(n, ids); \
+         _blob(ids, n > 0 ? n * sizeof(GLuint) : 0); \
+         _end(); \
+      } \
+   }
+
+TRACE_IDS(glDeleteBuffers, const GLuint)
+TRACE_IDS(glDeleteTextures, const GLuint)
+TRACE_IDS(glDeleteVertexArrays, const GLuint)
+TRACE_IDS(glGenBuffers, GLuint)
+TRACE_IDS(glGenQueries, GLuint)
+TRACE_IDS(glGenTextures, GLuint)
+TRACE_IDS(glGenTransformFeedbacks, GLuint)
+TRACE_IDS(glGenVertexArrays, GLuint)
+
+/* vertex arrays in client memory */
+
+static Client_Array *
+_client_array(int kind, GLuint index)
+{
+   if (kind == GL_TRACE_ATTRIB)
+      return index < ATTRIBS ? &attribs[index] : NULL;
+   return &arrays[kind - 1];
+}
+
+static int
+_client_state_kind(GLenum array)
+{
+   switch (array) {
+   case GL_VERTEX_ARRAY:
+      return GL_TRACE_VERTEX;
+   case GL_COLOR_ARRAY:
+      return GL_TRACE_COLOR;
+   case GL_NORMAL_ARRAY:
+      return GL_TRACE_NORMAL;
+   case GL_TEXTURE_COORD_ARRAY:
+      return GL_TRACE_TEXCOORD;
+   }
+
+   return -1;
+}
+
+static void
+_enable(int kind, GLuint index, int enable)
+{
+   Client_Array *a;
+
+   /* client arrays only exist outside vertex array objects */
+   if (kind < 0 || vao || !(a = _client_array(kind, index)))
+      return;
+   a->enabled = enable;
+}
+
+static void
+_trace_glEnableClientState(GLenum array)
+{
+   _enable(_client_state_kind(array), 0, 1);
+   _glEnableClientState(array);
+}
+
+static void
+_trace_glDisableClientState(GLenum array)
+{
+   _enable(_client_state_kind(array), 0, 0);
+   _glDisableClientState(array);
+}
+
+static void
+_trace_glEnableVertexAttribArray(GLuint index)
+{
+   _enable(GL_TRACE_ATTRIB, index, 1);
+   _glEnableVertexAttribArray(index);
+}
+
+static void
+_trace_glDisableVertexAttribArray(GLuint index)
+{
+   _enable(GL_TRACE_ATTRIB, index, 0);
+   _glDisableVertexAttribArray(index);
+}
+
+/* Follows a vertex array pointer, returns GL_TRACE_CLIENT when it points
+ * to client memory rather than into a buffer. */
+static unsigned int
+_pointer(int kind, GLuint index, GLint size, GLenum type, GLboolean normalized,
+         GLsizei stride, const void *pointer)
+{
+   Client_Array *a = _client_array(kind, index);
+
+   if (!a || vao)
+      return 0;
+
+   a->client = !array_buffer && pointer;
+   a->size = size;
+   a->type = type;
+   a->normalized = normalized;
+   a->stride = stride;
+   a->pointer = pointer;
+
+   return a->client ? GL_TRACE_CLIENT : 0;
+}
+
+#define TRACE_POINTER(name, kind) \
+   static void \
+   _trace_##name(GLint size, GLenum type, GLsizei stride, const void *pointer) \
+   { \
+      unsigned int flags = _pointer(kind, 0, size, type, GL_FALSE, stride, pointer); \
+      real->name(size, type, stride, pointer); \
+      if (recording) { \
+         _begin(GL_CALL_##name, flags); \
+         _put_##name(size, type, stride, pointer); \
+         _end(); \
+      } \
+   }
+
+TRACE_POINTER(glColorPointer, GL_TRACE_COLOR)
+TRACE_POINTER(glTexCoordPointer, GL_TRACE_TEXCOORD)
+TRACE_POINTER(glVertexPointer, GL_TRACE_VERTEX)
+
+static void
+_trace_glNormalPointer(GLenum type, GLsizei stride, const void *pointer)
+{
+   unsigned int flags = _pointer(GL_TRACE_NORMAL, 0, 3, type, GL_FALSE, stride, pointer);
+
+   real->glNormalPointer(type, stride, pointer);
+   if (recording) {
+      _begin(GL_CALL_glNormalPointer, flags);
+      _put_glNormalPointer(type, stride, pointer);
+      _end();
+   }
+}
+
+static void
+_trace_glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                             GLsizei stride, const void *pointer)
+{
+   unsigned int flags = _pointer(GL_TRACE_ATTRIB, index, size, type, normalized, stride, pointer);
+
+   real->glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+   if (recording) {
+      _begin(GL_CALL_glVertexAttribPointer, flags);
+      _put_glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+      _end();
+   }
+}
+
+static size_t
+_type_size(GLenum type)
+{
+   switch (type) {
+   case GL_BYTE:
+   case GL_UNSIGNED_BYTE:
+      return 1;
+   case GL_SHORT:
+   case GL_UNSIGNED_SHORT:
+   case GL_HALF_FLOAT:
+      return 2;
+   }
+
+   return 4;
+}
+
+static void
+_client_array_record(int kind, GLuint index, const Client_Array *a, GLsizei vertices)
+{
+   Gl_Trace_Client_Array ca;
+   size_t element = a->size * _type_size(a->type);
+   size_t stride = a->stride ? (size_t)a->stride : element;
+
+   ca.kind = kind;
+   ca.index = index;
+   ca.size = a->size;
+   ca.type = a->type;
+   ca.stride = a->stride;
+   ca.normalized = a->normalized;
+
+   _begin(GL_TRACE_CLIENT_ARRAY, 0);
+   _put(&ca, sizeof(ca));
+   _blob(a->pointer, (vertices - 1) * stride + element);
+   _end();
+}
+
+static int
+_client_arrays_enabled(void)
+{
+   int i;
+
+   if (vao)
+      return 0;
+   for (i = 0; i < ATTRIBS; i++)
+      if (attribs[i].enabled && attribs[i].client)
+         return 1;
+   for (i = 0; i < GL_TRACE_TEXCOORD; i++)
+      if (arrays[i].enabled && arrays[i].client)
+         return 1;
+
+   return 0;
+}
+
+/* Records the client arrays a draw reads, vertices 0 to vertices - 1. */
+static void
+_client_arrays(GLsizei vertices)
+{
+   int i;
+
+   if (!_client_arrays_enabled() || vertices <= 0)
+      return;
+
+   for (i = 0; i < ATTRIBS; i++)
+      if (attribs[i].enabled && attribs[i].client)
+         _client_array_record(GL_TRACE_ATTRIB, i, &attribs[i], vertices);
+   for (i = 0; i < GL_TRACE_TEXCOORD; i++)
+      if (arrays[i].enabled && arrays[i].client)
+         _client_array_record(i + 1, 0, &arrays[i], vertices);
+}
+
+static size_t
+_index_size(GLenum type)
+{
+   return type == GL_UNSIGNED_BYTE ? 1 : type == GL_UNSIGNED_SHORT ? 2 : 4;
+}
+
+/* Before an indexed draw: records the client arrays up to the highest
+ * index and returns GL_TRACE_CLIENT when the indices are client memory. */
+static unsigned int
+_indices(GLsizei count, GLenum type, const void *indices)
+{
+   GLuint max = 0, v;
+   GLsizei i;
+
+   if (_element_buffer()) {
+      if (_client_arrays_enabled() && !warned) {
+         printf("gl trace: client arrays drawn with an index buffer are not recorded\n");
+         warned = 1;
+      }
+      return 0;
+   }
+
+   for (i = 0; i < count; i++) {
+      if (type == GL_UNSIGNED_BYTE)
+         v = ((const GLubyte *)indices)[i];
+      else if (type == GL_UNSIGNED_SHORT)
+         v = ((const GLushort *)indices)[i];
+      else
+         v = ((const GLuint *)indices)[i];
+      if (v > max)
+         max = v;
+   }
+   if (count > 0)
+      _client_arrays(max + 1);
+
+   return GL_TRACE_CLIENT;
+}
+
+static void
+_trace_glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+   if (recording)
+      _client_arrays(first + count);
+   _glDrawArrays(mode, first, count);
+}
+
+static void
+_trace_glDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices)
+{
+   unsigned int flags = recording ? _indices(count, type, indices) : 0;
+
+   real->glDrawElements(mode, count, type, indices);
+   if (recording) {
+      _begin(GL_CALL_glDrawElements, flags);
+      _put_glDrawElements(mode, count, type, indices);
+      if (flags)
+         _blob(indices, count * _index_size(type));
+      _end();
+   }
+}
+
+static void
+_trace_glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void *indices,
+                               GLsizei instancecount)
+{
+   unsigned int flags = recording ? _indices(count, type, indices) : 0;
+
+   real->glDrawElementsInstanced(mode, count, type, indices, instancecount);
+   if (recording) {
+      _begin(GL_CALL_glDrawElementsInstanced, flags);
+      _put_glDrawElementsInstanced(mode, count, type, indices, instancecount);
+      if (flags)
+         _blob(indices, count * _index_size(type));
+      _end();
+   }
+}
+
+/* data uploads and client memory reads */
+
+static void
+_trace_glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+{
+   real->glBufferData(target, size, data, usage);
+   if (recording) {
+      _begin(GL_CALL_glBufferData, data ? GL_TRACE_CLIENT : 0);
+      _put_glBufferData(target, size, data, usage);
+      if (data)
+         _blob(data, size);
+      _end();
+   }
+}
+
+static void
+_trace_glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width,
+                    GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels)
+{
+   int client = pixels && !unpack_buffer;
+
+   real->glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+   if (recording) {
+      _begin(GL_CALL_glTexImage2D, client ? GL_TRACE_CLIENT : 0);
+      _put_glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+      if (client)
+         _blob(pixels, gl_trace_pixels_size(width, height, format, type, unpack_alignment));
+      _end();
+   }
+}
+
+static void
+_trace_glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width,
+                              GLsizei height, GLint border, GLsizei imageSize, const void *data)
+{
+   int client = data && !unpack_buffer;
+
+   real->glCompressedTexImage2D(target, level, internalformat, width, height, border, imageSize, data);
+   if (recording) {
+      _begin(GL_CALL_glCompressedTexImage2D, client ? GL_TRACE_CLIENT : 0);
+      _put_glCompressedTexImage2D(target, level, internalformat, width, height, border, imageSize, data);
+      if (client)
+         _blob(data, imageSize);
+      _end();
+   }
+}
+
+static void
+_trace_glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format,
+                    GLenum type, void *pixels)
+{
+   /* the pixels read are not recorded, only where they went */
+   int client = !pack_buffer;
+
+   real->glReadPixels(x, y, width, height, format, type, pixels);
+   if (recording) {
+      _begin(GL_CALL_glReadPixels, client ? GL_TRACE_CLIENT : 0);
+      _put_glReadPixels(x, y, width, height, format, type, pixels);
+      _end();
+   }
+}
+
+static void *
+_trace_glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+   void *ptr = _glMapBufferRange(target, offset, length, access);
+   int i;
+
+   for (i = 0; i < MAPS; i++) {
+      if (!maps[i].ptr || maps[i].target == target) {
+         maps[i].target = target;
+         maps[i].length = length;
+         maps[i].access = access;
+         maps[i].ptr = ptr;
+         break;
+      }
+   }
+
+   return ptr;
+}
+
+static GLboolean
+_trace_glUnmapBuffer(GLenum target)
+{
+   uint32_t t = target;
+   int i;
+
+   /* what was written through the mapping goes before the unmap */
+   for (i = 0; i < MAPS; i++) {
+      if (maps[i].target != target || !maps[i].ptr)
+         continue;
+      if (recording && (maps[i].access & GL_MAP_WRITE_BIT)) {
+         _begin(GL_TRACE_MAP_DATA, 0);
+         _put(&t, sizeof(t));
+         _blob(maps[i].ptr, maps[i].length);
+         _end();
+      }
+      maps[i].ptr = NULL;
+   }
+
+   return _glUnmapBuffer(target);
+}
+
+/* values passed by pointer */
+
+static void
+_trace_glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value)
+{
+   real->glUniformMatrix4fv(location, count, transpose, value);
+   if (recording) {
+      _begin(GL_CALL_glUniformMatrix4fv, 0);
+      _put_glUniformMatrix4fv(location, count, transpose, value);
+      _blob(value, count > 0 ? count * 16 * sizeof(GLfloat) : 0);
+      _end();
+   }
+}
+
+static void
+_trace_glLoadMatrixf(const GLfloat *m)
+{
+   real->glLoadMatrixf(m);
+   if (recording) {
+      _begin(GL_CALL_glLoadMatrixf, 0);
+      _put_glLoadMatrixf(m);
+      _blob(m, 16 * sizeof(GLfloat));
+      _end();
+   }
+}
+
+static size_t
+_light_values(GLenum pname)
+{
+   switch (pname) {
+   case GL_AMBIENT:
+   case GL_DIFFUSE:
+   case GL_SPECULAR:
+   case GL_POSITION:
+   case GL_EMISSION:
+   case GL_AMBIENT_AND_DIFFUSE:
+      return 4;
+   case GL_SPOT_DIRECTION:
+      return 3;
+   }
+
+   return 1;
+}
+
+static void
+_trace_glLightfv(GLenum light, GLenum pname, const GLfloat *params)
+{
+   real->glLightfv(light, pname, params);
+   if (recording) {
+      _begin(GL_CALL_glLightfv, 0);
+      _put_glLightfv(light, pname, params);
+      _blob(params, _light_values(pname) * sizeof(GLfloat));
+      _end();
+   }
+}
+
+static void
+_trace_glMaterialfv(GLenum face, GLenum pname, const GLfloat *params)
+{
+   real->glMaterialfv(face, pname, params);
+   if (recording) {
+      _begin(GL_CALL_glMaterialfv, 0);
+      _put_glMaterialfv(face, pname, params);
+      _blob(params, _light_values(pname) * sizeof(GLfloat));
+      _end();
+   }
+}
+
+static void
+_trace_glShaderSource(GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length)
+{
+   int i;
+
+   real->glShaderSource(shader, count, string, length);
+   if (recording) {
+      _begin(GL_CALL_glShaderSource, 0);
+      _put_glShaderSource(shader, count, string, length);
+      for (i = 0; i < count; i++)
+         _blob(string[i], length && length[i] >= 0 ? (size_t)length[i] : strlen(string[i]));
+      _end();
+   }
+}
+
+static void
+_trace_glTransformFeedbackVaryings(GLuint program, GLsizei count, const GLchar *const *varyings,
+                                   GLenum bufferMode)
+{
+   int i;
+
+   real->glTransformFeedbackVaryings(program, count, varyings, bufferMode);
+   if (recording) {
+      _begin(GL_CALL_glTransformFeedbackVaryings, 0);
+      _put_glTransformFeedbackVaryings(program, count, varyings, bufferMode);
+      for (i = 0; i < count; i++)
+         _blob(varyings[i], strlen(varyings[i]) + 1);
+      _end();
+   }
+}
+
+#define TRACE_LOCATION(name) \
+   static GLint \
+   _trace_##name(GLuint program, const GLchar *name_) \
+   { \
+      GLint ret = real->name(program, name_); \
+      if (recording) { \
+         _begin(GL_CALL_##name, 0); \
+         _put_##name(program, name_); \
+         PUT(ret) \
+         _blob(name_, strlen(name_) + 1); \
+         _end(); \
+      } \
+      return ret; \
+   }
+
+TRACE_LOCATION(glGetAttribLocation)
+TRACE_LOCATION(glGetUniformLocation)
+
+/* The buffer and the bindings above belong to the drawing thread, and a
+ * trace replays in one context: calls from other threads or in a second
+ * context go straight to GL. */
+static Evas_GL_API *
+_recorder(void)
+{
+   Evas_GL_Context *ctx;
+
+   if (!gl_calls_drawing_thread()) {
+      if (!__atomic_exchange_n(&warned_thread, 1, __ATOMIC_RELAXED))
+         printf("gl trace: calls from a second thread are not recorded\n");
+      return real;
+   }
+   if (!recording)
+      return real;
+
+   ctx = gl_calls_context();
+   if (!context)
+      context = ctx;
+   if (ctx && ctx != context) {
+      if (!warned_context) {
+         printf("gl trace: calls in a second context are not recorded\n");
+         warned_context = 1;
+      }
+      return real;
+   }
+
+   return &traced;
+}
+
+#define GATE_VOID(name, params, args) \
+   static void \
+   _gate_##name params \
+   { \
+      _recorder()->name args; \
+   }
+
+#define GATE_RET(type, name, params, args) \
+   static type \
+   _gate_##name params \
+   { \
+      return _recorder()->name args; \
+   }
+
+#define GATE_VOID0(name) GATE_VOID(name, (void), ())
+#define GATE_RET0(type, name) GATE_RET(type, name, (void), ())
+
+GL_CALLS(GATE_VOID, GATE_RET, GATE_VOID0, GATE_RET0)
+
+#define INSTALL(name, params, args) if (real->name) traced.name = _##name;
+#define INSTALL_R(type, name, params, args) INSTALL(name, params, args)
+#define INSTALL0(name) INSTALL(name, , )
+#define INSTALL0_R(type, name) INSTALL(name, , )
+#define INSTALL_TRACE(name) if (real->name) traced.name = _trace_##name;
+
+#define GATE(name, params, args) if (real->name) wrapped.name = _gate_##name;
+#define GATE_R(type, name, params, args) GATE(name, params, args)
+#define GATE0(name) GATE(name, , )
+#define GATE0_R(type, name) GATE(name, , )
+
+static void
+_stop(void)
+{
+   recording = 0;
+   if (fclose(out))
+      printf("gl trace: cannot write %s\n", path);
+   else
+      printf("gl trace: %d frames, %lu calls, %.1f KiB written to %s\n",
+             frames, calls, bytes / 1024.0, path);
+   out = NULL;
+   free(buf);
+   buf = NULL;
+   len = cap = 0;
+}
+
+Evas_GL_API *
+gl_trace_api(Evas_GL_API *api)
+{
+   Gl_Trace_Header header;
+   const char *env;
+
+   if (!enabled || !api)
+      return api;
+   if (api == real)
+      return &wrapped;
+
+   if (enabled < 0) {
+      path = getenv("GL_TRACE");
+      enabled = path && *path;
+      if (!enabled)
+         return api;
+      env = getenv("GL_TRACE_FRAMES");
+      max_frames = env && atoi(env) > 0 ? atoi(env) : 10;
+   }
+
+   if (real) {
+      printf("gl trace: a second GL API table, left unrecorded\n");
+      return api;
+   }
+
+   out = fopen(path, "wb");
+   if (!out) {
+      printf("gl trace: cannot write %s\n", path);
+      enabled = 0;
+      return api;
+   }
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, GL_TRACE_MAGIC, 8);
+   header.endianness = GL_TRACE_ENDIANNESS;
+   header.pointer_size = sizeof(void *);
+   header.calls = GL_CALL_LAST;
+   header.calls_hash = gl_trace_calls_hash();
+   fwrite(&header, sizeof(header), 1, out);
+   bytes = sizeof(header);
+
+   real = api;
+   traced = *api;
+   GL_CALLS(INSTALL, INSTALL_R, INSTALL0, INSTALL0_R)
+
+   INSTALL_TRACE(glBindBuffer)
+   INSTALL_TRACE(glBindVertexArray)
+   INSTALL_TRACE(glBufferData)
+   INSTALL_TRACE(glColorPointer)
+   INSTALL_TRACE(glCompressedTexImage2D)
+   INSTALL_TRACE(glDeleteBuffers)
+   INSTALL_TRACE(glDeleteTextures)
+   INSTALL_TRACE(glDeleteVertexArrays)
+   INSTALL_TRACE(glDisableClientState)
+   INSTALL_TRACE(glDisableVertexAttribArray)
+   INSTALL_TRACE(glDrawArrays)
+   INSTALL_TRACE(glDrawElements)
+   INSTALL_TRACE(glDrawElementsInstanced)
+   INSTALL_TRACE(glEnableClientState)
+   INSTALL_TRACE(glEnableVertexAttribArray)
+   INSTALL_TRACE(glGenBuffers)
+   INSTALL_TRACE(glGenQueries)
+   INSTALL_TRACE(glGenTextures)
+   INSTALL_TRACE(glGenTransformFeedbacks)
+   INSTALL_TRACE(glGenVertexArrays)
+   INSTALL_TRACE(glGetAttribLocation)
+   INSTALL_TRACE(glGetUniformLocation)
+   INSTALL_TRACE(glLightfv)
+   INSTALL_TRACE(glLoadMatrixf)
+   INSTALL_TRACE(glMapBufferRange)
+   INSTALL_TRACE(glMaterialfv)
+   INSTALL_TRACE(glNormalPointer)
+   INSTALL_TRACE(glPixelStorei)
+   INSTALL_TRACE(glReadPixels)
+   INSTALL_TRACE(glShaderSource)
+   INSTALL_TRACE(glTexCoordPointer)
+   INSTALL_TRACE(glTexImage2D)
+   INSTALL_TRACE(glTransformFeedbackVaryings)
+   INSTALL_TRACE(glUniformMatrix4fv)
+   INSTALL_TRACE(glUnmapBuffer)
+   INSTALL_TRACE(glVertexAttribPointer)
+   INSTALL_TRACE(glVertexPointer)
+
+   wrapped = *api;
+   GL_CALLS(GATE, GATE_R, GATE0, GATE0_R)
+
+   recording = 1;
+   return &wrapped;
+}
+
+void
+gl_trace_frame(void)
+{
+   if (!recording || !gl_calls_drawing_thread())
+      return;
+
+   _begin(GL_TRACE_FRAME, 0);
+   _end();
+   calls--;
+
+   /* one write per frame */
+   if (fwrite(buf, 1, len, out) != len)
+      printf("gl trace: cannot write %s\n", path);
+   bytes += len;
+   len = 0;
+
+   if (++frames >= max_frames)
+      _stop();
+}
@@ -0,0 +1,91 @@
+#ifndef GL_TRACE_H
+#define GL_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Evas_GL.h>
+
+/*
+ * GL command stream recorder.
+ *
+ * GL_TRACE=<file> makes gl_trace_api() hand out a copy of the Evas GL API
+ * table that appends every call of the entry points in gl_calls.h to
+ * <file>, together with the client memory the call reads: buffer and
+ * texture data, uniform and matrix values, shader sources, vertex arrays
+ * and indices drawn from client memory, and what was written through
+ * mapped buffer ranges.  Recording starts with the first call and stops
+ * after GL_TRACE_FRAMES (default 10) frames, as marked by gl_trace_frame();
+ * the first frame holds the setup as well.  glreplay plays a trace back.
+ *
+ * Like gl_profile_api(), only one table is wrapped.  Calls outside the
+ * table, Evas GL surface switches included, are not recorded.  Only the
+ * drawing thread's first context is: calls from other threads, such as
+ * pbuffer's PBUFFER_FARM workers, and calls in other contexts, such as
+ * those of INSTANCES beyond the first or pbuffer's offscreen one, pass
+ * through unrecorded with a notice.  A trace of a demo drawing in more
+ * than one context therefore replays only part of the picture.
+ *
+ * The file is a Gl_Trace_Header followed by records: a Gl_Trace_Record,
+ * the call's arguments packed back to back in declaration order, its
+ * return value, then the call's blobs.  A blob is a 32 bit byte count
+ * and the bytes, 4 byte aligned and padded to 4; every record is padded
+ * to 4 as well.  Pointer arguments are stored as they were passed:
+ * buffer offsets stay valid, and GL_TRACE_CLIENT marks the records whose
+ * pointer was client memory and comes as a blob instead, or for vertex
+ * array pointers, as GL_TRACE_CLIENT_ARRAY records before each draw.
+ * Everything is in the recording machine's byte order and pointer size.
+ */
+#define GL_TRACE_MAGIC      "EGLTRC01"
+#define GL_TRACE_ENDIANNESS 0x04030201
+
+/* record flags */
+#define GL_TRACE_CLIENT 0x0001
+
+/* record calls beyond the Gl_Call numbers */
+#define GL_TRACE_FRAME        0xffff   /* end of frame, no payload */
+#define GL_TRACE_CLIENT_ARRAY 0xfffe   /* Gl_Trace_Client_Array, blob */
+#define GL_TRACE_MAP_DATA     0xfffd   /* uint32 target, blob of the range */
+
+/* Gl_Trace_Client_Array kinds */
+#define GL_TRACE_ATTRIB   0   /* glVertexAttribPointer(index, ...) */
+#define GL_TRACE_VERTEX   1
+#define GL_TRACE_COLOR    2
+#define GL_TRACE_NORMAL   3
+#define GL_TRACE_TEXCOORD 4
+
+typedef struct _Gl_Trace_Header Gl_Trace_Header;
+typedef struct _Gl_Trace_Record Gl_Trace_Record;
+typedef struct _Gl_Trace_Client_Array Gl_Trace_Client_Array;
+
+struct _Gl_Trace_Header {
+   char     magic[8];
+   uint32_t endianness;
+   uint32_t pointer_size;
+   uint32_t calls;          /* GL_CALL_LAST */
+   uint32_t calls_hash;     /* of gl_call_names, see gl_trace_calls_hash() */
+};
+
+struct _Gl_Trace_Record {
+   uint16_t call;
+   uint16_t flags;
+   uint32_t size;           /* bytes following the record header */
+};
+
+/* the vertex array state of a draw, the blob holding its elements 0 up to
+ * the highest one drawn */
+struct _Gl_Trace_Client_Array {
+   uint16_t kind;
+   uint16_t index;
+   int32_t  size;
+   uint32_t type;
+   int32_t  stride;
+   uint32_t normalized;
+};
+
+Evas_GL_API *gl_trace_api(Evas_GL_API *api);
+void         gl_trace_frame(void);
+
+uint32_t     gl_trace_calls_hash(void);
+size_t       gl_trace_pixels_size(int w, int h, GLenum format, GLenum type, int alignment);
+
+#endif
@@ -0,0 +1,1024 @@
+/*
+ * glreplay - plays back a GL trace recorded with GL_TRACE (see gl_trace.h).
+ *
+ *   glreplay [-e] [-n loops] [-s WxH] [-v 1|2|3] <trace>
+ *
+ * The first frame, which holds the setup, plays once from the glview's
+ * init callback; the other frames then loop, 100 times by default.
+ * Without -e all loops run back to back inside one render callback, each
+ * ended by glFinish(): that times the GL driver behind Evas GL's per-call
+ * wrapping, with no application logic and no canvas.  -e plays one frame
+ * per canvas render instead, kicked from an idler, which adds the glview
+ * surface handling, composition and the swap; the difference between the
+ * two is what Evas GL costs per frame.
+ *
+ * The context version is guessed from the calls in the trace and the
+ * size is that of the largest viewport set, unless -v and -s say
+ * otherwise.  DIRECT=1 asks for direct rendering.
+ *
+ * Object names are remapped to the ones the replaying context hands out.
+ * Uniform and attribute locations are not, they are only checked against
+ * the recorded ones.  Traces only play on machines of the recorder's byte
+ * order and pointer size.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <Elementary.h>
+#include "frame_stats.h"
+#include "gl_calls.h"
+#include "gl_trace.h"
+
+#define SYNCS 16
+#define MAPS  4
+
+typedef struct {
+   const unsigned char *p, *end;
+} Reader;
+
+typedef struct {
+   GLuint *map;
+   GLuint size;
+} Names;
+
+static Evas_GL_API *gl;
+static void (*replay[GL_CALL_LAST])(Reader *in, unsigned int flags);
+static Eina_Bool present[GL_CALL_LAST], missing[GL_CALL_LAST];
+
+/* the trace, and where each frame starts in it; frame n ends where
+ * frame n + 1 starts */
+static const unsigned char *trace;
+static size_t trace_size;
+static const unsigned char **frame_start;
+static int frames;
+
+static int version, width, height, loops = 100;
+static Eina_Bool evas_mode;
+
+/* replay state */
+static Names buffers, textures, vaos, programs, queries, feedbacks;
+static struct {
+   GLsync recorded, sync;
+} syncs[SYNCS];
+static struct {
+   GLenum target;
+   void *ptr;
+} maps[MAPS];
+static GLuint array_buffer;
+static unsigned char *scratch;
+static size_t scratch_size;
+static Eina_Bool location_warned;
+
+static int played;
+static uint64_t start, replaying;
+
+static void
+_get(Reader *in, void *p, size_t n)
+{
+   if (n > (size_t)(in->end - in->p)) {
+      memset(p, 0, n);
+      in->p = in->end;
+      return;
+   }
+   memcpy(p, in->p, n);
+   in->p += n;
+}
+
+static const void *
+_blob(Reader *in, uint32_t *len)
+{
+   const void *data;
+   uint32_t l = 0;
+
+   in->p += (4 - (uintptr_t)in->p % 4) % 4;
+   if (in->p > in->end)
+      in->p = in->end;
+   _get(in, &l, sizeof(l));
+   if (l > (size_t)(in->end - in->p))
+      l = in->end - in->p;
+   data = in->p;
+   in->p += (l + 3) & ~3u;
+   if (in->p > in->end)
+      in->p = in->end;
+   if (len)
+      *len = l;
+
+   return data;
+}
+
+static void *
+_scratch(size_t n)
+{
+   void *p;
+
+   if (n > scratch_size) {
+      p = realloc(scratch, n);
+      if (!p) {
+         fprintf(stderr, "glreplay: out of memory\n");
+         exit(1);
+      }
+      scratch = p;
+      scratch_size = n;
+   }
+
+   return scratch;
+}
+
+/* recorded object names to the replayed ones */
+
+static GLuint
+_name(const Names *names, GLuint id)
+{
+   return id < names->size && names->map[id] ? names->map[id] : id;
+}
+
+static void
+_name_set(Names *names, GLuint id, GLuint name)
+{
+   GLuint size = names->size;
+   GLuint *map;
+
+   /* names are small in practice, bigger ones play unmapped */
+   if (id >= 1u << 20)
+      return;
+   if (id >= size) {
+      while (id >= size)
+         size = size ? size * 2 : 64;
+      map = realloc(names->map, size * sizeof(GLuint));
+      if (!map)
+         return;
+      memset(map + names->size, 0, (size - names->size) * sizeof(GLuint));
+      names->map = map;
+      names->size = size;
+   }
+   names->map[id] = name;
+}
+
+/* Every call gets an argument struct and reader, a call through the
+ * struct, and a replay that does both; entry points with their own replay
+ * below leave the last one unused, hence inline. */
+#define FIELD(p) p;
+#define GET(x) _get(in, &a->x, sizeof(a->x));
+#define ARG(x) a->x
+
+#define REPLAY_VOID(name, params, args) \
+   typedef struct { GL_FOR_EACH(FIELD, GL_STRIP params) } Args_##name; \
+   static inline void \
+   _get_##name(Reader *in, Args_##name *a) \
+   { \
+      GL_FOR_EACH(GET, GL_STRIP args) \
+   } \
+   static inline void \
+   _call_##name(const Args_##name *a) \
+   { \
+      gl->name(GL_FOR_EACH_COMMA(ARG, GL_STRIP args)); \
+   } \
+   static inline void \
+   _##name(Reader *in, unsigned int flags) \
+   { \
+      Args_##name a; \
+      _get_##name(in, &a); \
+      _call_##name(&a); \
+   }
+
+#define REPLAY_RET(type, name, params, args) \
+   typedef struct { GL_FOR_EACH(FIELD, GL_STRIP params) } Args_##name; \
+   static inline void \
+   _get_##name(Reader *in, Args_##name *a) \
+   { \
+      GL_FOR_EACH(GET, GL_STRIP args) \
+   } \
+   static inline type \
+   _call_##name(const Args_##name *a) \
+   { \
+      return gl->name(GL_FOR_EACH_COMMA(ARG, GL_STRIP args)); \
+   } \
+   static inline void \
+   _##name(Reader *in, unsigned int flags) \
+   { \
+      Args_##name a; \
+      _get_##name(in, &a); \
+      _call_##name(&a); \
+   }
+
+#define REPLAY_VOID0(name) \
+   static inline void \
+   _##name(Reader *in, unsigned int flags) \
+   { \
+      gl->name(); \
+   }
+
+#define REPLAY_RET0(type, name) REPLAY_VOID0(name)
+
+GL_CALLS(REPLAY_VOID, REPLAY_RET, REPLAY_VOID0, REPLAY_RET0)
+
+/* calls taking an object name */
+#define REPLAY_NAME(name, field, names) \
+   static void \
+   _replay_##name(Reader *in, unsigned int flags) \
+   { \
+      Args_##name a; \
+      _get_##name(in, &a); \
+      a.field = _name(&names, a.field); \
+      _call_##name(&a); \
+   }
+
+REPLAY_NAME(glBeginQuery, id, queries)
+REPLAY_NAME(glBindBufferBase, buffer, buffers)
+REPLAY_NAME(glBindTexture, texture, textures)
+REPLAY_NAME(glBindTransformFeedback, id, feedbacks)
+REPLAY_NAME(glBindVertexArray, array, vaos)
+REPLAY_NAME(glCompileShader, shader, programs)
+REPLAY_NAME(glDeleteProgram, program, programs)
+REPLAY_NAME(glDeleteShader, shader, programs)
+REPLAY_NAME(glLinkProgram, program, programs)
+REPLAY_NAME(glUseProgram, program, programs)
+
+static void
+_replay_glAttachShader(Reader *in, unsigned int flags)
+{
+   Args_glAttachShader a;
+
+   _get_glAttachShader(in, &a);
+   a.program = _name(&programs, a.program);
+   a.shader = _name(&programs, a.shader);
+   _call_glAttachShader(&a);
+}
+
+static void
+_replay_glBindBuffer(Reader *in, unsigned int flags)
+{
+   Args_glBindBuffer a;
+
+   _get_glBindBuffer(in, &a);
+   a.buffer = _name(&buffers, a.buffer);
+   if (a.target == GL_ARRAY_BUFFER)
+      array_buffer = a.buffer;
+   _call_glBindBuffer(&a);
+}
+
+/* glGen* and glDelete*, the recorded names come as a blob */
+#define REPLAY_GEN(name, names) \
+   static void \
+   _replay_##name(Reader *in, unsigned int flags) \
+   { \
+      Args_##name a; \
+      const GLuint *ids; \
+      GLuint *got; \
+      uint32_t len; \
+      int i; \
+      _get_##name(in, &a); \
+      ids = _blob(in, &len); \
+      if (a.n > (GLsizei)(len / sizeof(GLuint))) \
+         a.n = len / sizeof(GLuint); \
+      got = _scratch(a.n * sizeof(GLuint)); \
+      gl->name(a.n, got); \
+      for (i = 0; i < a.n; i++) \
+         _name_set(&names, ids[i], got[i]); \
+   }
+
+#define REPLAY_DELETE(name, names) \
+   static void \
+   _replay_##name(Reader *in, unsigned int flags) \
+   { \
+      Args_##name a; \
+      const GLuint *ids; \
+      GLuint *got; \
+      uint32_t len; \
+      int i; \
+      _get_##name(in, &a); \
+      ids = _blob(in, &len); \
+      if (a.n > (GLsizei)(len / sizeof(GLuint))) \
+         a.n = len / sizeof(GLuint); \
+      got = _scratch(a.n * sizeof(GLuint)); \
+      for (i = 0; i < a.n; i++) { \
+         got[i] = _name(&names, ids[i]); \
+         _name_set(&names, ids[i], 0); \
+      } \
+      gl->name(a.n, got); \
+   }
+
+REPLAY_GEN(glGenBuffers, buffers)
+REPLAY_GEN(glGenQueries, queries)
+REPLAY_GEN(glGenTextures, textures)
+REPLAY_GEN(glGenTransformFeedbacks, feedbacks)
+REPLAY_GEN(glGenVertexArrays, vaos)
+REPLAY_DELETE(glDeleteBuffers, buffers)
+REPLAY_DELETE(glDeleteTextures, textures)
+REPLAY_DELETE(glDeleteVertexArrays, vaos)
+
+static void
+_replay_glCreateProgram(Reader *in, unsigned int flags)
+{
+   GLuint id;
+
+   _get(in, &id, sizeof(id));
+   _name_set(&programs, id, gl->glCreateProgram());
+}
+
+static void
+_replay_glCreateShader(Reader *in, unsigned int flags)
+{
+   Args_glCreateShader a;
+   GLuint id;
+
+   _get_glCreateShader(in, &a);
+   _get(in, &id, sizeof(id));
+   _name_set(&programs, id, _call_glCreateShader(&a));
+}
+
+/* sync objects are pointers, matched in a small table */
+
+static GLsync *
+_sync(GLsync recorded)
+{
+   int i;
+
+   for (i = 0; i < SYNCS; i++)
+      if (syncs[i].recorded == recorded)
+         return &syncs[i].sync;
+
+   return NULL;
+}
+
+static void
+_replay_glFenceSync(Reader *in, unsigned int flags)
+{
+   Args_glFenceSync a;
+   GLsync recorded, *s;
+
+   _get_glFenceSync(in, &a);
+   _get(in, &recorded, sizeof(recorded));
+   s = _sync(recorded);
+   if (!s && (s = _sync(NULL)))
+      syncs[s - &syncs[0].sync].recorded = recorded;
+   if (s)
+      *s = _call_glFenceSync(&a);
+   else
+      gl->glDeleteSync(_call_glFenceSync(&a));
+}
+
+static void
+_replay_glClientWaitSync(Reader *in, unsigned int flags)
+{
+   Args_glClientWaitSync a;
+   GLsync *s;
+
+   _get_glClientWaitSync(in, &a);
+   if ((s = _sync(a.sync)))
+      a.sync = *s;
+   _call_glClientWaitSync(&a);
+}
+
+static void
+_replay_glDeleteSync(Reader *in, unsigned int flags)
+{
+   Args_glDeleteSync a;
+   GLsync *s;
+
+   _get_glDeleteSync(in, &a);
+   if (!(s = _sync(a.sync)))
+      return;
+   a.sync = *s;
+   syncs[s - &syncs[0].sync].recorded = NULL;
+   *s = NULL;
+   _call_glDeleteSync(&a);
+}
+
+/* vertex array pointers into client memory are set from the
+ * GL_TRACE_CLIENT_ARRAY records before each draw instead */
+#define REPLAY_POINTER(name) \
+   static void \
+   _replay_##name(Reader *in, unsigned int flags) \
+   { \
+      if (!(flags & GL_TRACE_CLIENT)) \
+         _##name(in, flags); \
+   }
+
+REPLAY_POINTER(glColorPointer)
+REPLAY_POINTER(glNormalPointer)
+REPLAY_POINTER(glTexCoordPointer)
+REPLAY_POINTER(glVertexAttribPointer)
+REPLAY_POINTER(glVertexPointer)
+
+/* pointer arguments that come as a blob, always or for client memory */
+#define REPLAY_BLOB(name, field) \
+   static void \
+   _replay_##name(Reader *in, unsigned int flags) \
+   { \
+      Args_##name a; \
+      _get_##name(in, &a); \
+      a.field = _blob(in, NULL); \
+      _call_##name(&a); \
+   }
+
+#define REPLAY_CLIENT(name, field) \
+   static void \
+   _replay_##name(Reader *in, unsigned int flags) \
+   { \
+      Args_##name a; \
+      _get_##name(in, &a); \
+      if (flags & GL_TRACE_CLIENT) \
+         a.field = _blob(in, NULL); \
+      _call_##name(&a); \
+   }
+
+REPLAY_BLOB(glLightfv, params)
+REPLAY_BLOB(glLoadMatrixf, m)
+REPLAY_BLOB(glMaterialfv, params)
+REPLAY_BLOB(glUniformMatrix4fv, value)
+REPLAY_CLIENT(glBufferData, data)
+REPLAY_CLIENT(glCompressedTexImage2D, data)
+REPLAY_CLIENT(glDrawElements, indices)
+REPLAY_CLIENT(glDrawElementsInstanced, indices)
+REPLAY_CLIENT(glTexImage2D, pixels)
+
+static void
+_replay_glReadPixels(Reader *in, unsigned int flags)
+{
+   Args_glReadPixels a;
+
+   _get_glReadPixels(in, &a);
+   /* 8 covers any pack alignment */
+   if (flags & GL_TRACE_CLIENT)
+      a.pixels = _scratch(gl_trace_pixels_size(a.width, a.height, a.format, a.type, 8));
+   _call_glReadPixels(&a);
+}
+
+/* queries, their results land in scratch memory */
+
+static void
+_replay_glGetProgramiv(Reader *in, unsigned int flags)
+{
+   Args_glGetProgramiv a;
+
+   _get_glGetProgramiv(in, &a);
+   a.program = _name(&programs, a.program);
+   a.params = _scratch(16 * sizeof(GLint));
+   _call_glGetProgramiv(&a);
+}
+
+static void
+_replay_glGetShaderiv(Reader *in, unsigned int flags)
+{
+   Args_glGetShaderiv a;
+
+   _get_glGetShaderiv(in, &a);
+   a.shader = _name(&programs, a.shader);
+   a.params = _scratch(16 * sizeof(GLint));
+   _call_glGetShaderiv(&a);
+}
+
+static void
+_replay_glGetQueryObjectuiv(Reader *in, unsigned int flags)
+{
+   Args_glGetQueryObjectuiv a;
+
+   _get_glGetQueryObjectuiv(in, &a);
+   a.id = _name(&queries, a.id);
+   a.params = _scratch(16 * sizeof(GLuint));
+   _call_glGetQueryObjectuiv(&a);
+}
+
+static void
+_replay_glGetProgramInfoLog(Reader *in, unsigned int flags)
+{
+   Args_glGetProgramInfoLog a;
+
+   _get_glGetProgramInfoLog(in, &a);
+   a.program = _name(&programs, a.program);
+   a.length = NULL;
+   a.infoLog = _scratch(a.bufSize > 0 ? a.bufSize : 1);
+   _call_glGetProgramInfoLog(&a);
+}
+
+static void
+_replay_glGetShaderInfoLog(Reader *in, unsigned int flags)
+{
+   Args_glGetShaderInfoLog a;
+
+   _get_glGetShaderInfoLog(in, &a);
+   a.shader = _name(&programs, a.shader);
+   a.length = NULL;
+   a.infoLog = _scratch(a.bufSize > 0 ? a.bufSize : 1);
+   _call_glGetShaderInfoLog(&a);
+}
+
+static void
+_location(const char *name, GLint recorded, GLint got)
+{
+   if (recorded == got || location_warned)
+      return;
+   printf("glreplay: %s is at %d, was at %d when recorded; locations are not remapped\n",
+          name, got, recorded);
+   location_warned = EINA_TRUE;
+}
+
+static void
+_replay_glGetAttribLocation(Reader *in, unsigned int flags)
+{
+   Args_glGetAttribLocation a;
+   GLint recorded;
+
+   _get_glGetAttribLocation(in, &a);
+   _get(in, &recorded, sizeof(recorded));
+   a.program = _name(&programs, a.program);
+   a.name = _blob(in, NULL);
+   _location(a.name, recorded, _call_glGetAttribLocation(&a));
+}
+
+static void
+_replay_glGetUniformLocation(Reader *in, unsigned int flags)
+{
+   Args_glGetUniformLocation a;
+   GLint recorded;
+
+   _get_glGetUniformLocation(in, &a);
+   _get(in, &recorded, sizeof(recorded));
+   a.program = _name(&programs, a.program);
+   a.name = _blob(in, NULL);
+   _location(a.name, recorded, _call_glGetUniformLocation(&a));
+}
+
+/* strings */
+
+static void
+_replay_glShaderSource(Reader *in, unsigned int flags)
+{
+   Args_glShaderSource a;
+   const GLchar **string;
+   GLint *length;
+   uint32_t len;
+   int i;
+
+   _get_glShaderSource(in, &a);
+   if (a.count <= 0)
+      return;
+   string = malloc(a.count * sizeof(*string));
+   length = malloc(a.count * sizeof(*length));
+   if (string && length) {
+      for (i = 0; i < a.count; i++) {
+         string[i] = _blob(in, &len);
+         length[i] = len;
+      }
+      a.shader = _name(&programs, a.shader);
+      a.string = string;
+      a.length = length;
+      _call_glShaderSource(&a);
+   }
+   free(string);
+   free(length);
+}
+
+static void
+_replay_glTransformFeedbackVaryings(Reader *in, unsigned int flags)
+{
+   Args_glTransformFeedbackVaryings a;
+   const GLchar **varyings;
+   int i;
+
+   _get_glTransformFeedbackVaryings(in, &a);
+   if (a.count <= 0)
+      return;
+   varyings = malloc(a.count * sizeof(*varyings));
+   if (!varyings)
+      return;
+   for (i = 0; i < a.count; i++)
+      varyings[i] = _blob(in, NULL);
+   a.program = _name(&programs, a.program);
+   a.varyings = varyings;
+   _call_glTransformFeedbackVaryings(&a);
+   free(varyings);
+}
+
+/* mapped buffer ranges, the data written through them follows as
+ * GL_TRACE_MAP_DATA records */
+
+static void
+_replay_glMapBufferRange(Reader *in, unsigned int flags)
+{
+   Args_glMapBufferRange a;
+   void *ptr;
+   int i;
+
+   _get_glMapBufferRange(in, &a);
+   ptr = _call_glMapBufferRange(&a);
+   for (i = 0; i < MAPS; i++) {
+      if (!maps[i].ptr || maps[i].target == a.target) {
+         maps[i].target = a.target;
+         maps[i].ptr = ptr;
+         break;
+      }
+   }
+}
+
+static void
+_replay_glUnmapBuffer(Reader *in, unsigned int flags)
+{
+   Args_glUnmapBuffer a;
+   int i;
+
+   _get_glUnmapBuffer(in, &a);
+   for (i = 0; i < MAPS; i++)
+      if (maps[i].target == a.target)
+         maps[i].ptr = NULL;
+   _call_glUnmapBuffer(&a);
+}
+
+static void
+_map_data(Reader *in)
+{
+   const void *data;
+   uint32_t target, len;
+   int i;
+
+   _get(in, &target, sizeof(target));
+   data = _blob(in, &len);
+   for (i = 0; i < MAPS; i++)
+      if (maps[i].target == target && maps[i].ptr)
+         memcpy(maps[i].ptr, data, len);
+}
+
+static void
+_client_array(Reader *in)
+{
+   Gl_Trace_Client_Array ca;
+   const void *data;
+
+   _get(in, &ca, sizeof(ca));
+   data = _blob(in, NULL);
+
+   /* client pointers need the array buffer unbound */
+   if (array_buffer)
+      gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
+   switch (ca.kind) {
+   case GL_TRACE_ATTRIB:
+      gl->glVertexAttribPointer(ca.index, ca.size, ca.type, ca.normalized, ca.stride, data);
+      break;
+   case GL_TRACE_VERTEX:
+      gl->glVertexPointer(ca.size, ca.type, ca.stride, data);
+      break;
+   case GL_TRACE_COLOR:
+      gl->glColorPointer(ca.size, ca.type, ca.stride, data);
+      break;
+   case GL_TRACE_NORMAL:
+      gl->glNormalPointer(ca.type, ca.stride, data);
+      break;
+   case GL_TRACE_TEXCOORD:
+      gl->glTexCoordPointer(ca.size, ca.type, ca.stride, data);
+      break;
+   }
+   if (array_buffer)
+      gl->glBindBuffer(GL_ARRAY_BUFFER, array_buffer);
+}
+
+#define INSTALL(name, params, args) \
+   replay[GL_CALL_##name] = _##name; present[GL_CALL_##name] = gl->name != NULL;
+#define INSTALL_R(type, name, params, args) INSTALL(name, params, args)
+#define INSTALL0(name) INSTALL(name, , )
+#define INSTALL0_R(type, name) INSTALL(name, , )
+#define INSTALL_REPLAY(name) replay[GL_CALL_##name] = _replay_##name;
+
+static void
+_install(void)
+{
+   GL_CALLS(INSTALL, INSTALL_R, INSTALL0, INSTALL0_R)
+
+   INSTALL_REPLAY(glAttachShader)
+   INSTALL_REPLAY(glBeginQuery)
+   INSTALL_REPLAY(glBindBuffer)
+   INSTALL_REPLAY(glBindBufferBase)
+   INSTALL_REPLAY(glBindTexture)
+   INSTALL_REPLAY(glBindTransformFeedback)
+   INSTALL_REPLAY(glBindVertexArray)
+   INSTALL_REPLAY(glBufferData)
+   INSTALL_REPLAY(glClientWaitSync)
+   INSTALL_REPLAY(glColorPointer)
+   INSTALL_REPLAY(glCompileShader)
+   INSTALL_REPLAY(glCompressedTexImage2D)
+   INSTALL_REPLAY(glCreateProgram)
+   INSTALL_REPLAY(glCreateShader)
+   INSTALL_REPLAY(glDeleteBuffers)
+   INSTALL_REPLAY(glDeleteProgram)
+   INSTALL_REPLAY(glDeleteShader)
+   INSTALL_REPLAY(glDeleteSync)
+   INSTALL_REPLAY(glDeleteTextures)
+   INSTALL_REPLAY(glDeleteVertexArrays)
+   INSTALL_REPLAY(glDrawElements)
+   INSTALL_REPLAY(glDrawElementsInstanced)
+   INSTALL_REPLAY(glFenceSync)
+   INSTALL_REPLAY(glGenBuffers)
+   INSTALL_REPLAY(glGenQueries)
+   INSTALL_REPLAY(glGenTextures)
+   INSTALL_REPLAY(glGenTransformFeedbacks)
+   INSTALL_REPLAY(glGenVertexArrays)
+   INSTALL_REPLAY(glGetAttribLocation)
+   INSTALL_REPLAY(glGetProgramInfoLog)
+   INSTALL_REPLAY(glGetProgramiv)
+   INSTALL_REPLAY(glGetQueryObjectuiv)
+   INSTALL_REPLAY(glGetShaderInfoLog)
+   INSTALL_REPLAY(glGetShaderiv)
+   INSTALL_REPLAY(glGetUniformLocation)
+   INSTALL_REPLAY(glLightfv)
+   INSTALL_REPLAY(glLinkProgram)
+   INSTALL_REPLAY(glLoadMatrixf)
+   INSTALL_REPLAY(glMapBufferRange)
+   INSTALL_REPLAY(glMaterialfv)
+   INSTALL_REPLAY(glNormalPointer)
+   INSTALL_REPLAY(glReadPixels)
+   INSTALL_REPLAY(glShaderSource)
+   INSTALL_REPLAY(glTexCoordPointer)
+   INSTALL_REPLAY(glTexImage2D)
+   INSTALL_REPLAY(glTransformFeedbackVaryings)
+   INSTALL_REPLAY(glUniformMatrix4fv)
+   INSTALL_REPLAY(glUnmapBuffer)
+   INSTALL_REPLAY(glUseProgram)
+   INSTALL_REPLAY(glVertexAttribPointer)
+   INSTALL_REPLAY(glVertexPointer)
+}
+
+static void
+_play(int frame)
+{
+   const unsigned char *p = frame_start[frame], *end = frame_start[frame + 1];
+   Gl_Trace_Record r;
+   Reader in;
+
+   while (p < end) {
+      memcpy(&r, p, sizeof(r));
+      in.p = p + sizeof(r);
+      in.end = in.p + r.size;
+
+      if (r.call == GL_TRACE_CLIENT_ARRAY)
+         _client_array(&in);
+      else if (r.call == GL_TRACE_MAP_DATA)
+         _map_data(&in);
+      else if (r.call < GL_CALL_LAST && present[r.call])
+         replay[r.call](&in, r.flags);
+      else if (r.call < GL_CALL_LAST && !missing[r.call]) {
+         printf("glreplay: %s is not in this context's API, skipped\n", gl_call_names[r.call]);
+         missing[r.call] = EINA_TRUE;
+      }
+
+      p = in.end;
+   }
+}
+
+/* Checks the header and splits the records into frames, guessing the
+ * context version and the size on the way. */
+static Eina_Bool
+_index(const char *path)
+{
+   const Gl_Trace_Header *h = (const Gl_Trace_Header *)trace;
+   const unsigned char *p, *end = trace + trace_size;
+   Eina_Bool gles1 = EINA_FALSE, gles3 = EINA_FALSE;
+   Args_glViewport v;
+   Gl_Trace_Record r;
+   Reader in;
+   int n = 0;
+
+   if (trace_size < sizeof(Gl_Trace_Header) || memcmp(h->magic, GL_TRACE_MAGIC, 8)) {
+      printf("glreplay: %s is not a GL trace\n", path);
+      return EINA_FALSE;
+   }
+   if (h->endianness != GL_TRACE_ENDIANNESS || h->pointer_size != sizeof(void *)) {
+      printf("glreplay: %s was recorded with another byte order or pointer size\n", path);
+      return EINA_FALSE;
+   }
+   if (h->calls != GL_CALL_LAST || h->calls_hash != gl_trace_calls_hash()) {
+      printf("glreplay: %s was recorded with another gl_calls.h\n", path);
+      return EINA_FALSE;
+   }
+
+   frame_start = malloc((trace_size / sizeof(Gl_Trace_Record) + 2) * sizeof(*frame_start));
+   if (!frame_start)
+      return EINA_FALSE;
+   frame_start[0] = trace + sizeof(Gl_Trace_Header);
+
+   for (p = frame_start[0]; p + sizeof(r) <= end; p += sizeof(r) + r.size) {
+      memcpy(&r, p, sizeof(r));
+      if (r.size > (size_t)(end - p) - sizeof(r))
+         break;
+
+      switch (r.call) {
+      case GL_TRACE_FRAME:
+         frame_start[++n] = p + sizeof(r) + r.size;
+         break;
+      case GL_CALL_glViewport:
+         in.p = p + sizeof(r);
+         in.end = in.p + r.size;
+         _get_glViewport(&in, &v);
+         if (v.width * v.height > width * height) {
+            width = v.width;
+            height = v.height;
+         }
+         break;
+      case GL_CALL_glLoadIdentity:
+      case GL_CALL_glMatrixMode:
+      case GL_CALL_glShadeModel:
+      case GL_CALL_glVertexPointer:
+         gles1 = EINA_TRUE;
+         break;
+      case GL_CALL_glBeginQuery:
+      case GL_CALL_glBeginTransformFeedback:
+      case GL_CALL_glBindVertexArray:
+      case GL_CALL_glDrawElementsInstanced:
+      case GL_CALL_glFenceSync:
+      case GL_CALL_glMapBufferRange:
+      case GL_CALL_glVertexAttribDivisor:
+         gles3 = EINA_TRUE;
+         break;
+      }
+   }
+
+   /* a frame cut short by the end of the recording is dropped */
+   frames = n;
+   if (frames < 2) {
+      printf("glreplay: %s holds %d frames, needs the setup and one more\n", path, frames);
+      return EINA_FALSE;
+   }
+
+   if (!version)
+      version = gles1 ? 1 : gles3 ? 3 : 2;
+
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_open(const char *path)
+{
+   struct stat st;
+   void *map;
+   int fd;
+
+   fd = open(path, O_RDONLY);
+   if (fd < 0) {
+      printf("glreplay: cannot open %s\n", path);
+      return EINA_FALSE;
+   }
+   if (fstat(fd, &st) < 0) {
+      close(fd);
+      return EINA_FALSE;
+   }
+
+   /* blobs are handed to GL straight from the mapping */
+   map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (map == MAP_FAILED) {
+      printf("glreplay: cannot map %s\n", path);
+      return EINA_FALSE;
+   }
+   trace = map;
+   trace_size = st.st_size;
+
+   return _index(path);
+}
+
+static void
+_init_gl(Evas_Object *obj)
+{
+   gl = elm_glview_gl_api_get(obj);
+   _install();
+   _play(0);
+}
+
+static void
+_draw_gl(Evas_Object *obj)
+{
+   uint64_t t, submit = 0;
+   int i, f;
+
+   if (played >= loops * (frames - 1))
+      return;
+
+   if (evas_mode) {
+      if (!played)
+         start = frame_stats_now();
+      t = frame_stats_now();
+      _play(1 + played % (frames - 1));
+      replaying += frame_stats_now() - t;
+      if (++played < loops * (frames - 1))
+         return;
+
+      t = frame_stats_now() - start;
+      printf("glreplay: %d frames through the canvas, %.3f ms/frame, %.3f ms/frame replaying\n",
+             played, t / 1e6 / played, replaying / 1e6 / played);
+      elm_exit();
+      return;
+   }
+
+   played = loops * (frames - 1);
+   start = frame_stats_now();
+   for (i = 0; i < loops; i++) {
+      t = frame_stats_now();
+      for (f = 1; f < frames; f++)
+         _play(f);
+      submit += frame_stats_now() - t;
+      gl->glFinish();
+   }
+   t = frame_stats_now() - start;
+
+   printf("glreplay: %d frames back to back, %.3f ms/frame submitted, %.3f ms/frame with glFinish\n",
+          played, submit / 1e6 / played, t / 1e6 / played);
+   elm_exit();
+}
+
+static Eina_Bool
+_idle(void *data)
+{
+   elm_glview_changed_set(data);
+   return ECORE_CALLBACK_RENEW;
+}
+
+static void
+usage(void)
+{
+   fprintf(stderr, "usage: glreplay [-e] [-n loops] [-s WxH] [-v 1|2|3] <trace>\n");
+   exit(2);
+}
+
+EAPI_MAIN int
+elm_main(int argc, char **argv)
+{
+   Evas_Object *win, *glview;
+   Ecore_Idler *idler = NULL;
+   const char *direct = getenv("DIRECT");
+   int i, w = 0, h = 0;
+
+   for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+      if (!strcmp(argv[i], "-e"))
+         evas_mode = EINA_TRUE;
+      else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+         loops = atoi(argv[++i]);
+      else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+         if (sscanf(argv[++i], "%dx%d", &w, &h) != 2 || w < 1 || h < 1)
+            usage();
+      }
+      else if (!strcmp(argv[i], "-v") && i + 1 < argc) {
+         version = atoi(argv[++i]);
+         if (version < 1 || version > 3)
+            usage();
+      }
+      else
+         usage();
+   }
+   if (argc - i != 1 || loops < 1)
+      usage();
+
+   if (!_open(argv[i]))
+      return 1;
+   if (w) {
+      width = w;
+      height = h;
+   }
+   if (width < 1 || height < 1) {
+      width = 720;
+      height = 1280;
+   }
+   printf("glreplay: %s, %d frames, GLES %d, %dx%d\n", argv[i], frames, version, width, height);
+
+   win = elm_win_util_standard_add("glreplay", "glreplay");
+   elm_win_autodel_set(win, EINA_TRUE);
+
+   if (version == 1)
+      glview = elm_glview_version_add(win, EVAS_GL_GLES_1_X);
+   else if (version == 3)
+      glview = elm_glview_version_add(win, EVAS_GL_GLES_3_X);
+   else
+      glview = elm_glview_add(win);
+   if (!glview) {
+      printf("glreplay: cannot create a GLES %d glview\n", version);
+      return 1;
+   }
+
+   elm_glview_mode_set(glview, ELM_GLVIEW_DEPTH | ELM_GLVIEW_STENCIL |
+                       (direct && atoi(direct) ? ELM_GLVIEW_DIRECT : 0));
+   elm_glview_resize_policy_set(glview, ELM_GLVIEW_RESIZE_POLICY_RECREATE);
+   elm_glview_render_policy_set(glview, ELM_GLVIEW_RENDER_POLICY_ON_DEMAND);
+   elm_glview_init_func_set(glview, _init_gl);
+   elm_glview_render_func_set(glview, _draw_gl);
+   evas_object_size_hint_weight_set(glview, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+   elm_win_resize_object_add(win, glview);
+   evas_object_show(glview);
+
+   evas_object_resize(win, width, height);
+   evas_object_show(win);
+
+   elm_glview_changed_set(glview);
+   if (evas_mode)
+      idler = ecore_idler_add(_idle, glview);
+
+   elm_run();
+
+   if (idler)
+      ecore_idler_del(idler);
+   elm_shutdown();
+   return 0;
+}
+ELM_MAIN()
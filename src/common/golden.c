@@ -0,0 +1,440 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <Ecore.h>
+#include "golden.h"
+#include "image_diff.h"
+
+typedef struct _Golden_Entry Golden_Entry;
+
+struct _Golden_Entry {
+   int w, h;
+   unsigned long long hash;
+};
+
+struct _Golden {
+   char *name;
+   char *dir;
+   Eina_Bool record;
+   int tolerance;
+   int limit;   /* 0: run until the window closes */
+
+   /* record: written as we go; check: loaded by golden_new() */
+   FILE *index;
+   Golden_Entry *entries;
+   int count, size;
+
+   /* grow-only scratch for glReadPixels and the stored frame */
+   unsigned char *pixels, *expected;
+   size_t pixels_size, expected_size;
+
+   Image_Diff *differ;
+
+   int frame;
+   int matched, tolerated, failed, missing, stored;
+   double hash_time;
+};
+
+/* XXH64, reading the input in host byte order */
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+static inline unsigned long long
+_rotl64(unsigned long long x, int r)
+{
+   return (x << r) | (x >> (64 - r));
+}
+
+static inline unsigned long long
+_read64(const unsigned char *p)
+{
+   unsigned long long v;
+
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+static inline unsigned int
+_read32(const unsigned char *p)
+{
+   unsigned int v;
+
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+static inline unsigned long long
+_round(unsigned long long acc, unsigned long long input)
+{
+   acc += input * PRIME64_2;
+   acc = _rotl64(acc, 31);
+   return acc * PRIME64_1;
+}
+
+static inline unsigned long long
+_merge(unsigned long long acc, unsigned long long val)
+{
+   acc ^= _round(0, val);
+   return acc * PRIME64_1 + PRIME64_4;
+}
+
+unsigned long long
+golden_hash(const void *data, size_t len, unsigned long long seed)
+{
+   const unsigned char *p = data;
+   const unsigned char *end = p + len;
+   unsigned long long h;
+
+   if (len >= 32) {
+      const unsigned char *limit = end - 32;
+      unsigned long long v1 = seed + PRIME64_1 + PRIME64_2;
+      unsigned long long v2 = seed + PRIME64_2;
+      unsigned long long v3 = seed;
+      unsigned long long v4 = seed - PRIME64_1;
+
+      do {
+         v1 = _round(v1, _read64(p));
+         v2 = _round(v2, _read64(p + 8));
+         v3 = _round(v3, _read64(p + 16));
+         v4 = _round(v4, _read64(p + 24));
+         p += 32;
+      } while (p <= limit);
+
+      h = _rotl64(v1, 1) + _rotl64(v2, 7) + _rotl64(v3, 12) + _rotl64(v4, 18);
+      h = _merge(h, v1);
+      h = _merge(h, v2);
+      h = _merge(h, v3);
+      h = _merge(h, v4);
+   }
+   else {
+      h = seed + PRIME64_5;
+   }
+
+   h += len;
+
+   for (; p + 8 <= end; p += 8) {
+      h ^= _round(0, _read64(p));
+      h = _rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+   }
+   if (p + 4 <= end) {
+      h ^= (unsigned long long) _read32(p) * PRIME64_1;
+      h = _rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+      p += 4;
+   }
+   for (; p < end; p++) {
+      h ^= *p * PRIME64_5;
+      h = _rotl64(h, 11) * PRIME64_1;
+   }
+
+   h ^= h >> 33;
+   h *= PRIME64_2;
+   h ^= h >> 29;
+   h *= PRIME64_3;
+   h ^= h >> 32;
+
+   return h;
+}
+
+static Eina_Bool
+_grow(unsigned char **buf, size_t *size, size_t need)
+{
+   unsigned char *p;
+
+   if (need <= *size)
+      return EINA_TRUE;
+
+   p = realloc(*buf, need);
+   if (!p)
+      return EINA_FALSE;
+   *buf = p;
+   *size = need;
+   return EINA_TRUE;
+}
+
+static Eina_Bool
+_pam_write(const char *path, const void *pixels, int w, int h)
+{
+   FILE *f = fopen(path, "wb");
+
+   if (!f)
+      return EINA_FALSE;
+
+   fprintf(f, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", w, h);
+   fwrite(pixels, 4, (size_t) w * h, f);
+
+   return fclose(f) == 0;
+}
+
+static Eina_Bool
+_pam_read(Golden *g, const char *path, int w, int h)
+{
+   FILE *f = fopen(path, "rb");
+   size_t len = (size_t) w * h * 4;
+   int fw = 0, fh = 0;
+   Eina_Bool ok = EINA_FALSE;
+
+   if (!f)
+      return EINA_FALSE;
+
+   if (fscanf(f, "P7 WIDTH %d HEIGHT %d DEPTH 4 MAXVAL 255 TUPLTYPE RGB_ALPHA ENDHDR", &fw, &fh) == 2 &&
+       fgetc(f) == '\n' && fw == w && fh == h &&
+       _grow(&g->expected, &g->expected_size, len))
+      ok = fread(g->expected, 1, len, f) == len;
+
+   fclose(f);
+   return ok;
+}
+
+static char *
+_path(const Golden *g, const char *fmt, ...)
+{
+   char buf[4096];
+   int n;
+   va_list ap;
+
+   n = snprintf(buf, sizeof(buf), "%s/", g->dir);
+   va_start(ap, fmt);
+   vsnprintf(buf + n, sizeof(buf) - n, fmt, ap);
+   va_end(ap);
+
+   return strdup(buf);
+}
+
+static Eina_Bool
+_index_load(Golden *g, const char *path)
+{
+   FILE *f = fopen(path, "r");
+   Golden_Entry e;
+   int frame;
+
+   if (!f)
+      return EINA_FALSE;
+
+   while (fscanf(f, "%d %dx%d %llx", &frame, &e.w, &e.h, &e.hash) == 4) {
+      if (g->count == g->size) {
+         Golden_Entry *p;
+
+         g->size = g->size ? g->size * 2 : 256;
+         p = realloc(g->entries, g->size * sizeof(Golden_Entry));
+         if (!p)
+            break;
+         g->entries = p;
+      }
+      g->entries[g->count++] = e;
+   }
+
+   fclose(f);
+   return EINA_TRUE;
+}
+
+Golden *
+golden_new(const char *name)
+{
+   const char *mode = getenv("GOLDEN");
+   const char *dir = getenv("GOLDEN_DIR");
+   const char *frames = getenv("GOLDEN_FRAMES");
+   const char *tolerance = getenv("GOLDEN_TOLERANCE");
+   Golden *g;
+   char *index;
+
+   if (!mode)
+      return NULL;
+   if (strcmp(mode, "record") && strcmp(mode, "check")) {
+      printf("golden: GOLDEN must be \"record\" or \"check\", not \"%s\"\n", mode);
+      return NULL;
+   }
+
+   g = calloc(1, sizeof(Golden));
+   if (!g)
+      return NULL;
+
+   g->name = strdup(name);
+   g->dir = strdup(dir ? dir : "golden");
+   g->record = !strcmp(mode, "record");
+   g->tolerance = tolerance ? atoi(tolerance) : 0;
+   g->limit = frames ? atoi(frames) : 0;
+
+   index = _path(g, "%s.golden", name);
+
+   if (g->record) {
+      if (mkdir(g->dir, 0755) && errno != EEXIST)
+         printf("golden: cannot create %s: %s\n", g->dir, strerror(errno));
+      g->index = fopen(index, "w");
+      if (!g->index) {
+         printf("golden: cannot write %s\n", index);
+         free(index);
+         golden_finish(g);
+         return NULL;
+      }
+      printf("golden: recording %s\n", index);
+   }
+   else {
+      /* a check without a store still runs, and fails on its first frame */
+      if (!_index_load(g, index))
+         printf("golden: cannot read %s, record it first with GOLDEN=record\n", index);
+      if (!g->limit && !g->count)
+         g->limit = 1;
+      else if (!g->limit)
+         g->limit = g->count;
+      printf("golden: checking %d frames against %s\n", g->limit, index);
+   }
+
+   free(index);
+   return g;
+}
+
+static void
+_mismatch(Golden *g, const Golden_Entry *e, const void *pixels, int w, int h)
+{
+   const Image_Diff_Result *res = NULL;
+   char *path;
+
+   path = _path(g, "%016llx.pam", e->hash);
+   if (!_pam_read(g, path, w, h)) {
+      printf("golden: frame %d: stored frame %s is missing or unreadable\n", g->frame, path);
+      free(path);
+      g->failed++;
+      return;
+   }
+   free(path);
+
+   if (!g->differ) {
+      int t = g->tolerance > 255 ? 255 : (g->tolerance < 0 ? 0 : g->tolerance);
+
+      g->differ = image_diff_new(0);
+      if (g->differ)
+         image_diff_tolerance_set(g->differ, t, t, t, t);
+   }
+   if (g->differ)
+      res = image_diff_run(g->differ, g->expected, pixels, w, h);
+   if (!res) {
+      g->failed++;
+      return;
+   }
+
+   if (!res->mismatches) {
+      g->tolerated++;
+      return;
+   }
+
+   g->failed++;
+   printf("golden: frame %d: %lu pixels differ, max error %u, PSNR %.2f dB\n",
+          g->frame, res->mismatches, res->max_error, res->psnr);
+
+   path = _path(g, "%s-%d.pam", g->name, g->frame);
+   _pam_write(path, pixels, w, h);
+   free(path);
+   path = _path(g, "%s-%d-diff.ppm", g->name, g->frame);
+   image_diff_heatmap_save(g->differ, path);
+   free(path);
+}
+
+Eina_Bool
+golden_check(Golden *g, const void *pixels, int w, int h)
+{
+   Golden_Entry e;
+   double t;
+
+   if (!g)
+      return EINA_TRUE;
+   if (g->limit && g->frame >= g->limit)
+      return EINA_FALSE;
+
+   t = ecore_time_get();
+   e.w = w;
+   e.h = h;
+   e.hash = golden_hash(pixels, (size_t) w * h * 4, 0);
+   g->hash_time += ecore_time_get() - t;
+
+   if (g->record) {
+      char *path = _path(g, "%016llx.pam", e.hash);
+
+      fprintf(g->index, "%d %dx%d %016llx\n", g->frame, w, h, e.hash);
+      if (access(path, F_OK) && _pam_write(path, pixels, w, h))
+         g->stored++;
+      free(path);
+   }
+   else if (g->frame >= g->count) {
+      g->missing++;
+   }
+   else {
+      const Golden_Entry *ref = &g->entries[g->frame];
+
+      if (ref->w != w || ref->h != h) {
+         printf("golden: frame %d is %dx%d, recorded as %dx%d\n",
+                g->frame, w, h, ref->w, ref->h);
+         g->failed++;
+      }
+      else if (ref->hash == e.hash) {
+         g->matched++;
+      }
+      else {
+         _mismatch(g, ref, pixels, w, h);
+      }
+   }
+
+   g->frame++;
+   return !g->limit || g->frame < g->limit;
+}
+
+/* Reads back the framebuffer bound on the current context. */
+Eina_Bool
+golden_frame(Golden *g, Evas_GL_API *gl, int w, int h)
+{
+   if (!g)
+      return EINA_TRUE;
+
+   if (!_grow(&g->pixels, &g->pixels_size, (size_t) w * h * 4))
+      return EINA_TRUE;
+
+   gl->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+   gl->glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, g->pixels);
+
+   return golden_check(g, g->pixels, w, h);
+}
+
+/* Prints the run summary and frees the store.  Returns the exit status
+ * for the demo: non-zero when a checked frame failed or was missing. */
+int
+golden_finish(Golden *g)
+{
+   int status;
+
+   if (!g)
+      return 0;
+
+   if (g->record) {
+      if (g->index)
+         printf("golden: recorded %d frames, %d distinct frames stored (%.3f ms hashing per frame)\n",
+                g->frame, g->stored, g->frame ? g->hash_time * 1000.0 / g->frame : 0.0);
+   }
+   else if (g->frame) {
+      printf("golden: %d frames: %d matched by hash, %d within tolerance, %d failed, %d not recorded (%.3f ms hashing per frame)\n",
+             g->frame, g->matched, g->tolerated, g->failed, g->missing,
+             g->hash_time * 1000.0 / g->frame);
+   }
+
+   status = g->failed || g->missing || (!g->record && g->frame < g->limit);
+   if (!g->record && g->frame < g->limit)
+      printf("golden: stopped after %d of %d frames\n", g->frame, g->limit);
+
+   if (g->index)
+      fclose(g->index);
+   image_diff_free(g->differ);
+   free(g->entries);
+   free(g->pixels);
+   free(g->expected);
+   free(g->name);
+   free(g->dir);
+   free(g);
+
+   return status;
+}
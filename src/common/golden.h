@@ -0,0 +1,31 @@
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+#include <stddef.h>
+#include <Eina.h>
+#include <Evas_GL.h>
+
+/*
+ * Golden image regression store.
+ *
+ * GOLDEN=record hashes every frame a demo hands in and saves the hash
+ * list as GOLDEN_DIR/<name>.golden, plus each distinct frame once as
+ * GOLDEN_DIR/<hash>.pam.  GOLDEN=check hashes the frames of a later run
+ * against that list; only frames whose hash differs are loaded back and
+ * run through the image comparator, so a matching run costs one hash per
+ * frame.  A frame fails when a channel differs by more than
+ * GOLDEN_TOLERANCE (default 0); the failing frame and its tile heatmap
+ * are written next to the store.
+ *
+ * GOLDEN_DIR defaults to "golden".  GOLDEN_FRAMES=<n> stops the run after
+ * n frames; in check mode it defaults to the number of recorded frames.
+ */
+typedef struct _Golden Golden;
+
+Golden            *golden_new(const char *name);
+int                golden_finish(Golden *golden);
+Eina_Bool          golden_check(Golden *golden, const void *pixels, int w, int h);
+Eina_Bool          golden_frame(Golden *golden, Evas_GL_API *gl, int w, int h);
+unsigned long long golden_hash(const void *data, size_t len, unsigned long long seed);
+
+#endif
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <Ecore.h>
+#include "gpu_fence.h"
+
+Eina_Bool
+gpu_fence_supported(Evas_GL_API *gl)
+{
+   if (gl->glFenceSync && gl->glClientWaitSync && gl->glDeleteSync)
+      return EINA_TRUE;
+
+   return gl->evasglCreateSync && gl->evasglClientWaitSync && gl->evasglDestroySync;
+}
+
+Eina_Bool
+gpu_fence_insert(Gpu_Fence *fence, Evas_GL *evas_gl, Evas_GL_API *gl)
+{
+   fence->evas_gl = evas_gl;
+   fence->gl = gl;
+
+   if (gl->glFenceSync) {
+      fence->egl = EINA_FALSE;
+      fence->sync = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+   }
+   else if (gl->evasglCreateSync) {
+      fence->egl = EINA_TRUE;
+      fence->sync = gl->evasglCreateSync(evas_gl, EVAS_GL_SYNC_FENCE, NULL);
+   }
+   else {
+      fence->sync = NULL;
+   }
+
+   /* get the queued commands going while the caller does other work */
+   gl->glFlush();
+
+   return fence->sync != NULL;
+}
+
+/* Blocks until the commands before the fence completed, then deletes it.
+ * Returns the time spent blocked. */
+double
+gpu_fence_wait(Gpu_Fence *fence)
+{
+   Evas_GL_API *gl = fence->gl;
+   double t;
+
+   if (!fence->sync)
+      return 0.0;
+
+   t = ecore_time_get();
+   if (fence->egl) {
+      gl->evasglClientWaitSync(fence->evas_gl, fence->sync,
+                               EVAS_GL_SYNC_FLUSH_COMMANDS_BIT, EVAS_GL_FOREVER);
+      gl->evasglDestroySync(fence->evas_gl, fence->sync);
+   }
+   else {
+      GLenum status;
+
+      status = gl->glClientWaitSync(fence->sync, GL_SYNC_FLUSH_COMMANDS_BIT, ~0ull);
+      if (status == GL_WAIT_FAILED)
+         printf("gpu_fence: glClientWaitSync failed\n");
+      gl->glDeleteSync(fence->sync);
+   }
+   t = ecore_time_get() - t;
+
+   fence->sync = NULL;
+   return t;
+}
@@ -0,0 +1,29 @@
+#ifndef GPU_FENCE_H
+#define GPU_FENCE_H
+
+#include <Eina.h>
+#include <Evas_GL.h>
+
+/*
+ * Frame completion fences.
+ *
+ * Uses GLES 3.x sync objects when the context has them and
+ * EGL_KHR_fence_sync through the Evas GL extension table otherwise.  A
+ * fence only covers the commands issued before it, so unlike glFinish()
+ * the caller can queue more work first and wait later, when it actually
+ * needs the results.
+ */
+typedef struct _Gpu_Fence Gpu_Fence;
+
+struct _Gpu_Fence {
+   Evas_GL *evas_gl;
+   Evas_GL_API *gl;
+   void *sync;
+   Eina_Bool egl;
+};
+
+Eina_Bool gpu_fence_supported(Evas_GL_API *gl);
+Eina_Bool gpu_fence_insert(Gpu_Fence *fence, Evas_GL *evas_gl, Evas_GL_API *gl);
+double    gpu_fence_wait(Gpu_Fence *fence);
+
+#endif
@@ -0,0 +1,389 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <Ecore.h>
+#include "image_diff.h"
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define IMAGE_DIFF_NEON 1
+#endif
+
+#define MAX_THREADS 8
+
+typedef struct _Image_Diff_Job Image_Diff_Job;
+
+struct _Image_Diff_Job {
+   Image_Diff *diff;
+   Eina_Thread tid;
+   int index;
+
+   /* per thread totals, summed up by image_diff_run() */
+   unsigned long mismatches;
+   int first;
+   unsigned int max;
+   unsigned long long sumsq;
+};
+
+struct _Image_Diff {
+   int threads;
+   Image_Diff_Job jobs[MAX_THREADS];
+
+   Eina_Lock lock;
+   Eina_Condition go, done;
+   unsigned int generation;
+   int pending;
+   Eina_Bool quit;
+
+   /* current comparison */
+   const unsigned char *a, *b;
+   int w, h;
+   unsigned char tol[4];
+
+   Image_Diff_Result result;
+   unsigned char *tile_max;
+   unsigned int *tile_mismatches;
+   int tiles_size;
+};
+
+static inline void
+_mismatch(Image_Diff_Job *job, unsigned int *tile_count, unsigned int bits, int index)
+{
+   int n = __builtin_popcount(bits);
+
+   job->mismatches += n;
+   *tile_count += n;
+   index += __builtin_ctz(bits);
+   if (job->first < 0 || index < job->first)
+      job->first = index;
+}
+
+static void
+_tile_diff(Image_Diff_Job *job, int tx, int ty)
+{
+   const Image_Diff *diff = job->diff;
+   const int w = diff->w;
+   const int x0 = tx * IMAGE_DIFF_TILE, y0 = ty * IMAGE_DIFF_TILE;
+   const int tw = (w - x0 < IMAGE_DIFF_TILE) ? w - x0 : IMAGE_DIFF_TILE;
+   const int th = (diff->h - y0 < IMAGE_DIFF_TILE) ? diff->h - y0 : IMAGE_DIFF_TILE;
+   const int tile = ty * diff->result.tiles_w + tx;
+   unsigned int count = 0, max = 0;
+   int x, y, start = 0;
+#if defined(__SSE2__)
+   const __m128i zero = _mm_setzero_si128();
+   __m128i vmax = zero, vtol;
+   unsigned int tol32;
+
+   memcpy(&tol32, diff->tol, 4);
+   vtol = _mm_set1_epi32((int) tol32);
+   start = tw & ~3;
+#elif defined(IMAGE_DIFF_NEON)
+   uint8x16_t vmax = vdupq_n_u8(0);
+   uint8x16_t vtol = vreinterpretq_u8_u32(vld1q_dup_u32((const uint32_t *) diff->tol));
+
+   start = tw & ~3;
+#endif
+
+   for (y = y0; y < y0 + th; y++) {
+      const size_t row = (size_t) y * w + x0;
+      const unsigned char *pa = diff->a + row * 4;
+      const unsigned char *pb = diff->b + row * 4;
+
+#if defined(__SSE2__)
+      __m128i vsq = zero;
+
+      for (x = 0; x < start; x += 4) {
+         __m128i va = _mm_loadu_si128((const __m128i *) (pa + x * 4));
+         __m128i vb = _mm_loadu_si128((const __m128i *) (pb + x * 4));
+         __m128i d = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+         __m128i over = _mm_subs_epu8(d, vtol);
+         __m128i lo = _mm_unpacklo_epi8(d, zero);
+         __m128i hi = _mm_unpackhi_epi8(d, zero);
+         int ok = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(over, zero)));
+
+         if (ok != 0xf)
+            _mismatch(job, &count, ~ok & 0xf, row + x);
+         vmax = _mm_max_epu8(vmax, d);
+         vsq = _mm_add_epi32(vsq, _mm_add_epi32(_mm_madd_epi16(lo, lo),
+                                                _mm_madd_epi16(hi, hi)));
+      }
+      vsq = _mm_add_epi32(vsq, _mm_shuffle_epi32(vsq, _MM_SHUFFLE(1, 0, 3, 2)));
+      vsq = _mm_add_epi32(vsq, _mm_shuffle_epi32(vsq, _MM_SHUFFLE(2, 3, 0, 1)));
+      job->sumsq += (unsigned int) _mm_cvtsi128_si32(vsq);
+#elif defined(IMAGE_DIFF_NEON)
+      uint32x4_t vsq = vdupq_n_u32(0);
+
+      for (x = 0; x < start; x += 4) {
+         uint8x16_t d = vabdq_u8(vld1q_u8(pa + x * 4), vld1q_u8(pb + x * 4));
+         uint32x4_t over = vreinterpretq_u32_u8(vqsubq_u8(d, vtol));
+         uint32x4_t bad = vtstq_u32(over, over);
+         unsigned int bits = (vgetq_lane_u32(bad, 0) & 1) | (vgetq_lane_u32(bad, 1) & 2) |
+                             (vgetq_lane_u32(bad, 2) & 4) | (vgetq_lane_u32(bad, 3) & 8);
+
+         if (bits)
+            _mismatch(job, &count, bits, row + x);
+         vmax = vmaxq_u8(vmax, d);
+         vsq = vpadalq_u16(vsq, vmull_u8(vget_low_u8(d), vget_low_u8(d)));
+         vsq = vpadalq_u16(vsq, vmull_u8(vget_high_u8(d), vget_high_u8(d)));
+      }
+      {
+         uint64x2_t s = vpaddlq_u32(vsq);
+         job->sumsq += vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1);
+      }
+#endif
+
+      /* scalar tail, or the whole row without SIMD */
+      for (x = start; x < tw; x++) {
+         const unsigned char *ca = pa + x * 4, *cb = pb + x * 4;
+         int c, bad = 0;
+
+         for (c = 0; c < 4; c++) {
+            unsigned int d = (ca[c] > cb[c]) ? ca[c] - cb[c] : cb[c] - ca[c];
+            if (d > diff->tol[c])
+               bad = 1;
+            if (d > max)
+               max = d;
+            job->sumsq += d * d;
+         }
+         if (bad)
+            _mismatch(job, &count, 1, row + x);
+      }
+   }
+
+#if defined(__SSE2__)
+   vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 8));
+   vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 4));
+   vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 2));
+   vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 1));
+   if ((unsigned int) (_mm_cvtsi128_si32(vmax) & 0xff) > max)
+      max = _mm_cvtsi128_si32(vmax) & 0xff;
+#elif defined(IMAGE_DIFF_NEON)
+   {
+      uint8x8_t m = vpmax_u8(vget_low_u8(vmax), vget_high_u8(vmax));
+      m = vpmax_u8(m, m);
+      m = vpmax_u8(m, m);
+      m = vpmax_u8(m, m);
+      if (vget_lane_u8(m, 0) > max)
+         max = vget_lane_u8(m, 0);
+   }
+#endif
+
+   diff->tile_max[tile] = max;
+   diff->tile_mismatches[tile] = count;
+   if (max > job->max)
+      job->max = max;
+}
+
+static void
+_job_run(Image_Diff_Job *job)
+{
+   const Image_Diff *diff = job->diff;
+   const int rows = diff->result.tiles_h;
+   int ty0 = rows * job->index / diff->threads;
+   int ty1 = rows * (job->index + 1) / diff->threads;
+   int tx, ty;
+
+   job->mismatches = 0;
+   job->first = -1;
+   job->max = 0;
+   job->sumsq = 0;
+
+   for (ty = ty0; ty < ty1; ty++)
+      for (tx = 0; tx < diff->result.tiles_w; tx++)
+         _tile_diff(job, tx, ty);
+}
+
+static void *
+_worker(void *data, Eina_Thread t EINA_UNUSED)
+{
+   Image_Diff_Job *job = data;
+   Image_Diff *diff = job->diff;
+   unsigned int seen = 0;
+
+   eina_lock_take(&diff->lock);
+   for (;;) {
+      while (diff->generation == seen && !diff->quit)
+         eina_condition_wait(&diff->go);
+      if (diff->quit)
+         break;
+      seen = diff->generation;
+      eina_lock_release(&diff->lock);
+
+      _job_run(job);
+
+      eina_lock_take(&diff->lock);
+      if (--diff->pending == 0)
+         eina_condition_signal(&diff->done);
+   }
+   eina_lock_release(&diff->lock);
+
+   return NULL;
+}
+
+Image_Diff *
+image_diff_new(int threads)
+{
+   Image_Diff *diff;
+   int i;
+
+   if (threads <= 0)
+      threads = eina_cpu_count();
+   if (threads > MAX_THREADS)
+      threads = MAX_THREADS;
+   if (threads < 1)
+      threads = 1;
+
+   diff = calloc(1, sizeof(Image_Diff));
+   if (!diff)
+      return NULL;
+
+   eina_lock_new(&diff->lock);
+   eina_condition_new(&diff->go, &diff->lock);
+   eina_condition_new(&diff->done, &diff->lock);
+
+   /* job 0 runs on the calling thread */
+   diff->threads = 1;
+   diff->jobs[0].diff = diff;
+   for (i = 1; i < threads; i++) {
+      Image_Diff_Job *job = &diff->jobs[i];
+
+      job->diff = diff;
+      job->index = i;
+      if (!eina_thread_create(&job->tid, EINA_THREAD_NORMAL, -1, _worker, job))
+         break;
+      diff->threads++;
+   }
+
+   return diff;
+}
+
+void
+image_diff_free(Image_Diff *diff)
+{
+   int i;
+
+   if (!diff)
+      return;
+
+   eina_lock_take(&diff->lock);
+   diff->quit = EINA_TRUE;
+   eina_condition_broadcast(&diff->go);
+   eina_lock_release(&diff->lock);
+
+   for (i = 1; i < diff->threads; i++)
+      eina_thread_join(diff->jobs[i].tid);
+
+   eina_condition_free(&diff->go);
+   eina_condition_free(&diff->done);
+   eina_lock_free(&diff->lock);
+   free(diff->tile_max);
+   free(diff->tile_mismatches);
+   free(diff);
+}
+
+void
+image_diff_tolerance_set(Image_Diff *diff, unsigned char r, unsigned char g,
+                         unsigned char b, unsigned char a)
+{
+   diff->tol[0] = r;
+   diff->tol[1] = g;
+   diff->tol[2] = b;
+   diff->tol[3] = a;
+}
+
+const Image_Diff_Result *
+image_diff_run(Image_Diff *diff, const void *a, const void *b, int w, int h)
+{
+   Image_Diff_Result *res = &diff->result;
+   unsigned long long sumsq = 0;
+   double t = ecore_time_get();
+   int i, tiles;
+
+   res->tiles_w = (w + IMAGE_DIFF_TILE - 1) / IMAGE_DIFF_TILE;
+   res->tiles_h = (h + IMAGE_DIFF_TILE - 1) / IMAGE_DIFF_TILE;
+   tiles = res->tiles_w * res->tiles_h;
+   if (tiles > diff->tiles_size) {
+      free(diff->tile_max);
+      free(diff->tile_mismatches);
+      diff->tile_max = malloc(tiles);
+      diff->tile_mismatches = malloc(tiles * sizeof(unsigned int));
+      if (!diff->tile_max || !diff->tile_mismatches) {
+         diff->tiles_size = 0;
+         return NULL;
+      }
+      diff->tiles_size = tiles;
+   }
+   res->tile_max = diff->tile_max;
+   res->tile_mismatches = diff->tile_mismatches;
+
+   diff->a = a;
+   diff->b = b;
+   diff->w = w;
+   diff->h = h;
+
+   eina_lock_take(&diff->lock);
+   diff->generation++;
+   diff->pending = diff->threads - 1;
+   eina_condition_broadcast(&diff->go);
+   eina_lock_release(&diff->lock);
+
+   _job_run(&diff->jobs[0]);
+
+   eina_lock_take(&diff->lock);
+   while (diff->pending)
+      eina_condition_wait(&diff->done);
+   eina_lock_release(&diff->lock);
+
+   res->mismatches = 0;
+   res->first_mismatch = -1;
+   res->max_error = 0;
+   for (i = 0; i < diff->threads; i++) {
+      const Image_Diff_Job *job = &diff->jobs[i];
+
+      res->mismatches += job->mismatches;
+      if (job->first >= 0 && (res->first_mismatch < 0 || job->first < res->first_mismatch))
+         res->first_mismatch = job->first;
+      if (job->max > res->max_error)
+         res->max_error = job->max;
+      sumsq += job->sumsq;
+   }
+
+   if (sumsq)
+      res->psnr = 10.0 * log10(255.0 * 255.0 * w * h * 4 / (double) sumsq);
+   else
+      res->psnr = INFINITY;
+
+   res->seconds = ecore_time_get() - t;
+
+   return res;
+}
+
+/* Writes the per tile maximum error as a binary PPM, one pixel per tile,
+ * black for a match ramping through red and yellow up to white. */
+Eina_Bool
+image_diff_heatmap_save(const Image_Diff *diff, const char *path)
+{
+   const Image_Diff_Result *res = &diff->result;
+   FILE *f;
+   int i;
+
+   f = fopen(path, "wb");
+   if (!f)
+      return EINA_FALSE;
+
+   fprintf(f, "P6\n%d %d\n255\n", res->tiles_w, res->tiles_h);
+   for (i = 0; i < res->tiles_w * res->tiles_h; i++) {
+      unsigned int v = res->tile_max[i] * 3;
+      unsigned char rgb[3];
+
+      rgb[0] = v > 255 ? 255 : v;
+      rgb[1] = v > 510 ? 255 : (v > 255 ? v - 255 : 0);
+      rgb[2] = v > 510 ? v - 510 : 0;
+      fwrite(rgb, 1, 3, f);
+   }
+
+   return fclose(f) == 0;
+}
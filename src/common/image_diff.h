@@ -0,0 +1,40 @@
+#ifndef IMAGE_DIFF_H
+#define IMAGE_DIFF_H
+
+#include <Eina.h>
+
+/*
+ * RGBA8888 image comparator.
+ *
+ * Compares two tightly packed images with a per channel tolerance and
+ * reports how many pixels exceed it, the largest channel error, the PSNR
+ * over all channels and, per IMAGE_DIFF_TILE x IMAGE_DIFF_TILE tile, the
+ * largest error and the number of mismatching pixels.  The inner loops are
+ * SSE2 or NEON when the compiler targets them, and the tile rows are split
+ * over a pool of worker threads that lives as long as the comparator, so
+ * a comparison does no heap allocation once the tile arrays are sized.
+ */
+#define IMAGE_DIFF_TILE 16
+
+typedef struct _Image_Diff Image_Diff;
+typedef struct _Image_Diff_Result Image_Diff_Result;
+
+struct _Image_Diff_Result {
+   unsigned long mismatches;  /* pixels with a channel over tolerance */
+   int first_mismatch;        /* pixel index in raster order, -1 if none */
+   unsigned int max_error;    /* largest channel difference */
+   double psnr;               /* dB over all channels, INFINITY if equal */
+   double seconds;            /* time spent in image_diff_run() */
+
+   int tiles_w, tiles_h;
+   const unsigned char *tile_max;        /* tiles_w * tiles_h */
+   const unsigned int *tile_mismatches;  /* tiles_w * tiles_h */
+};
+
+Image_Diff              *image_diff_new(int threads);
+void                     image_diff_free(Image_Diff *diff);
+void                     image_diff_tolerance_set(Image_Diff *diff, unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+const Image_Diff_Result *image_diff_run(Image_Diff *diff, const void *a, const void *b, int w, int h);
+Eina_Bool                image_diff_heatmap_save(const Image_Diff *diff, const char *path);
+
+#endif
@@ -0,0 +1,250 @@
+#include <math.h>
+#include <string.h>
+#include "mat4.h"
+
+#if defined(__SSE__) && !defined(MAT4_SCALAR)
+# include <xmmintrin.h>
+# define MAT4_SSE 1
+#elif defined(__ARM_NEON) && !defined(MAT4_SCALAR)
+# include <arm_neon.h>
+# define MAT4_NEON 1
+#endif
+
+void
+mat4_identity(float *m)
+{
+   memset(m, 0, sizeof(float) * 16);
+   m[0] = m[5] = m[10] = m[15] = 1.0f;
+}
+
+void
+mat4_multiply_scalar(float *r, const float *a, const float *b)
+{
+   float tmp[16];
+   int i, j, k;
+
+   for (j = 0; j < 4; j++) {
+      for (i = 0; i < 4; i++) {
+         tmp[j * 4 + i] = 0.0f;
+         for (k = 0; k < 4; k++)
+            tmp[j * 4 + i] += a[k * 4 + i] * b[j * 4 + k];
+      }
+   }
+   memcpy(r, tmp, sizeof(tmp));
+}
+
+/* r may be a or b: every column of r is a combination of a's columns,
+ * so all of a and b is read before r is written. */
+void
+mat4_multiply(float *r, const float *a, const float *b)
+{
+#if defined(MAT4_SSE)
+   __m128 a0 = _mm_loadu_ps(a), a1 = _mm_loadu_ps(a + 4);
+   __m128 a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+   __m128 c[4];
+   int j;
+
+   for (j = 0; j < 4; j++)
+      c[j] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(b[j * 4])),
+                                   _mm_mul_ps(a1, _mm_set1_ps(b[j * 4 + 1]))),
+                        _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(b[j * 4 + 2])),
+                                   _mm_mul_ps(a3, _mm_set1_ps(b[j * 4 + 3]))));
+   for (j = 0; j < 4; j++)
+      _mm_storeu_ps(r + j * 4, c[j]);
+#elif defined(MAT4_NEON)
+   float32x4_t a0 = vld1q_f32(a), a1 = vld1q_f32(a + 4);
+   float32x4_t a2 = vld1q_f32(a + 8), a3 = vld1q_f32(a + 12);
+   float32x4_t c[4];
+   int j;
+
+   for (j = 0; j < 4; j++) {
+      c[j] = vmulq_n_f32(a0, b[j * 4]);
+      c[j] = vmlaq_n_f32(c[j], a1, b[j * 4 + 1]);
+      c[j] = vmlaq_n_f32(c[j], a2, b[j * 4 + 2]);
+      c[j] = vmlaq_n_f32(c[j], a3, b[j * 4 + 3]);
+   }
+   for (j = 0; j < 4; j++)
+      vst1q_f32(r + j * 4, c[j]);
+#else
+   mat4_multiply_scalar(r, a, b);
+#endif
+}
+
+void
+mat4_translate(float *m, float x, float y, float z)
+{
+   int i;
+
+   for (i = 0; i < 4; i++)
+      m[12 + i] += m[i] * x + m[4 + i] * y + m[8 + i] * z;
+}
+
+void
+mat4_scale(float *m, float x, float y, float z)
+{
+   int i;
+
+   for (i = 0; i < 4; i++) {
+      m[i] *= x;
+      m[4 + i] *= y;
+      m[8 + i] *= z;
+   }
+}
+
+/* glRotatef(): angle around the axis (x, y, z), which need not be unit */
+void
+mat4_rotate(float *m, float angle, float x, float y, float z)
+{
+   float rot[16];
+   float c = cosf(angle * M_PI / 180.0f);
+   float s = sinf(angle * M_PI / 180.0f);
+   float c1 = 1.0f - c;
+   float len = sqrtf(x * x + y * y + z * z);
+
+   if (len == 0.0f)
+      return;
+   x /= len;
+   y /= len;
+   z /= len;
+
+   mat4_identity(rot);
+   rot[0] = x * x * c1 + c;
+   rot[1] = y * x * c1 + z * s;
+   rot[2] = x * z * c1 - y * s;
+   rot[4] = x * y * c1 - z * s;
+   rot[5] = y * y * c1 + c;
+   rot[6] = y * z * c1 + x * s;
+   rot[8] = x * z * c1 + y * s;
+   rot[9] = y * z * c1 - x * s;
+   rot[10] = z * z * c1 + c;
+   mat4_multiply(m, m, rot);
+}
+
+/* The combined x, y, z rotation glviewcube20 turns its cube with */
+void
+mat4_rotate_xyz(float *m, float anglex, float angley, float anglez)
+{
+   float rot[16];
+   float rx = anglex * M_PI / 180.0f;
+   float ry = angley * M_PI / 180.0f;
+   float rz = anglez * M_PI / 180.0f;
+   float sx = sinf(rx), cx = cosf(rx);
+   float sy = sinf(ry), cy = cosf(ry);
+   float sz = sinf(rz), cz = cosf(rz);
+
+   mat4_identity(rot);
+   rot[0] = cy * cz - sx * sy * sz;
+   rot[1] = cz * sx * sy + cy * sz;
+   rot[2] = -cx * sy;
+   rot[4] = -cx * sz;
+   rot[5] = cx * cz;
+   rot[6] = sx;
+   rot[8] = cz * sy + cy * sx * sz;
+   rot[9] = -cy * cz * sx + sy * sz;
+   rot[10] = cx * cy;
+   mat4_multiply(m, m, rot);
+}
+
+/* glFrustumf(), m is left alone for an empty or inverted volume */
+void
+mat4_frustum(float *m, float left, float right, float bottom, float top,
+             float near, float far)
+{
+   float dx = right - left, dy = top - bottom, dz = far - near;
+
+   if (near <= 0.0f || far <= 0.0f || dx <= 0.0f || dy <= 0.0f || dz <= 0.0f)
+      return;
+
+   memset(m, 0, sizeof(float) * 16);
+   m[0] = 2.0f * near / dx;
+   m[5] = 2.0f * near / dy;
+   m[8] = (right + left) / dx;
+   m[9] = (top + bottom) / dy;
+   m[10] = -(far + near) / dz;
+   m[11] = -1.0f;
+   m[14] = -2.0f * far * near / dz;
+}
+
+void
+mat4_perspective(float *m, float fovy, float aspect, float near, float far)
+{
+   float top = tanf(fovy * M_PI / 360.0f) * near;
+   float right = top * aspect;
+
+   mat4_frustum(m, -right, right, -top, top, near, far);
+}
+
+void
+mat4_transform_points_scalar(const float *m, const float *in, int in_stride,
+                             float *out, int out_stride, int count)
+{
+   float x, y, z;
+   int i;
+
+   for (i = 0; i < count; i++, in += in_stride, out += out_stride) {
+      x = in[0];
+      y = in[1];
+      z = in[2];
+      out[0] = m[0] * x + m[4] * y + m[8] * z + m[12];
+      out[1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+      out[2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+   }
+}
+
+void
+mat4_transform_points(const float *m, const float *in, int in_stride,
+                      float *out, int out_stride, int count)
+{
+#if defined(MAT4_SSE)
+   __m128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4);
+   __m128 c2 = _mm_loadu_ps(m + 8), c3 = _mm_loadu_ps(m + 12);
+   __m128 p;
+   int i;
+
+   for (i = 0; i < count; i++, in += in_stride, out += out_stride) {
+      p = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(in[0])),
+                                _mm_mul_ps(c1, _mm_set1_ps(in[1]))),
+                     _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(in[2])), c3));
+      /* three floats only, out may be followed by other attributes */
+      _mm_storel_pi((__m64 *)out, p);
+      _mm_store_ss(out + 2, _mm_movehl_ps(p, p));
+   }
+#elif defined(MAT4_NEON)
+   float32x4_t c0 = vld1q_f32(m), c1 = vld1q_f32(m + 4);
+   float32x4_t c2 = vld1q_f32(m + 8), c3 = vld1q_f32(m + 12);
+   float32x4_t p;
+   int i;
+
+   for (i = 0; i < count; i++, in += in_stride, out += out_stride) {
+      p = vmlaq_n_f32(c3, c0, in[0]);
+      p = vmlaq_n_f32(p, c1, in[1]);
+      p = vmlaq_n_f32(p, c2, in[2]);
+      vst1_f32(out, vget_low_f32(p));
+      vst1q_lane_f32(out + 2, p, 2);
+   }
+#else
+   mat4_transform_points_scalar(m, in, in_stride, out, out_stride, count);
+#endif
+}
+
+void
+mat3_transform(const float *m, const float *v, float *out)
+{
+   float x = v[0], y = v[1], z = v[2];
+   int i;
+
+   for (i = 0; i < 3; i++)
+      out[i] = m[i] * x + m[3 + i] * y + m[6 + i] * z;
+}
+
+const char *
+mat4_simd(void)
+{
+#if defined(MAT4_SSE)
+   return "SSE";
+#elif defined(MAT4_NEON)
+   return "NEON";
+#else
+   return "scalar";
+#endif
+}
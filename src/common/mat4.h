@@ -0,0 +1,39 @@
+#ifndef MAT4_H
+#define MAT4_H
+
+/*
+ * 4x4 matrix math shared by the demos.
+ *
+ * Matrices are 16 floats, column major as GL expects them.  Like the GLES
+ * 1.x matrix stack, translate, rotate and scale multiply on the right:
+ * mat4_translate(m, ...) makes m = m * T.  Angles are in degrees.
+ *
+ * mat4_multiply() and mat4_transform_points() use SSE on x86 and NEON on
+ * ARM, the _scalar variants are the plain C reference they are checked
+ * against (see mat4bench).
+ */
+
+void mat4_identity(float *m);
+void mat4_multiply(float *r, const float *a, const float *b);
+void mat4_multiply_scalar(float *r, const float *a, const float *b);
+void mat4_translate(float *m, float x, float y, float z);
+void mat4_scale(float *m, float x, float y, float z);
+void mat4_rotate(float *m, float angle, float x, float y, float z);
+void mat4_rotate_xyz(float *m, float anglex, float angley, float anglez);
+void mat4_frustum(float *m, float left, float right, float bottom, float top,
+                  float near, float far);
+void mat4_perspective(float *m, float fovy, float aspect, float near, float far);
+
+/* Transforms count points (x, y, z, 1) by m and stores x, y, z.  The
+ * strides are in floats, so points can sit in interleaved vertices. */
+void mat4_transform_points(const float *m, const float *in, int in_stride,
+                           float *out, int out_stride, int count);
+void mat4_transform_points_scalar(const float *m, const float *in, int in_stride,
+                                  float *out, int out_stride, int count);
+
+/* out = m * v for a column major 3x3 m, as in GLSL */
+void mat3_transform(const float *m, const float *v, float *out);
+
+const char *mat4_simd(void);
+
+#endif
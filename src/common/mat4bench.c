@@ -0,0 +1,192 @@
+/*
+ * mat4bench - checks the SIMD matrix code in mat4.c against its scalar
+ * reference and times both.
+ *
+ *   mat4bench [iterations]
+ *
+ * The iterations default to MAT4BENCH_ITERATIONS, which make check sets
+ * low, or 10000000.  Exits with 1 when a result is off by more than
+ * rounding.  The point
+ * transform is timed on 100000 cubes of 24 interleaved vertices, the
+ * biggest glviewcube20 CUBE_SCENE.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "mat4.h"
+
+#define POINTS (100000 * 24)
+#define STRIDE 7     /* position and color, as in glviewcube20's batches */
+
+static volatile float sink;
+
+static double
+now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+random_matrix(float *m)
+{
+   int i;
+
+   for (i = 0; i < 16; i++)
+      m[i] = (float)drand48() * 4.0f - 2.0f;
+}
+
+static float
+max_error(const float *a, const float *b, int n, int stride)
+{
+   float e, max = 0.0f;
+   int i;
+
+   for (i = 0; i < n; i++) {
+      e = fabsf(a[(i / 3) * stride + i % 3] - b[(i / 3) * stride + i % 3]);
+      if (e > max)
+         max = e;
+   }
+   return max;
+}
+
+static int
+check(void)
+{
+   static const float m3[9] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+   static const float v3[3] = { 1, 10, 100 };
+   float a[16], b[16], r[16], ref[16], rot[16], p[4 * 3], q[4 * 3];
+   float e, worst = 0.0f;
+   int i, j, fail = 0;
+
+   for (i = 0; i < 10000; i++) {
+      random_matrix(a);
+      random_matrix(b);
+      mat4_multiply(r, a, b);
+      mat4_multiply_scalar(ref, a, b);
+      e = max_error(r, ref, 16, 3);
+      if (e > worst)
+         worst = e;
+      /* in place, as the rotations use it */
+      mat4_multiply(a, a, b);
+      e = max_error(a, ref, 16, 3);
+      if (e > worst)
+         worst = e;
+   }
+   printf("multiply: max error %g\n", worst);
+   fail |= worst > 1e-5f;
+
+   worst = 0.0f;
+   for (i = 0; i < 1000; i++) {
+      random_matrix(a);
+      for (j = 0; j < 12; j++)
+         p[j] = (float)drand48() * 10.0f - 5.0f;
+      /* stride 4 with a sentinel after every point */
+      q[3] = q[7] = q[11] = 42.0f;
+      mat4_transform_points(a, p, 3, q, 4, 3);
+      mat4_transform_points_scalar(a, p, 3, r, 4, 3);
+      e = max_error(q, r, 9, 4);
+      if (e > worst)
+         worst = e;
+      fail |= q[3] != 42.0f || q[7] != 42.0f || q[11] != 42.0f;
+   }
+   printf("transform: max error %g\n", worst);
+   fail |= worst > 1e-5f;
+
+   /* the rotation axis is normalized, its length does not matter */
+   mat4_identity(rot);
+   mat4_rotate(rot, 90.0f, 0.0f, 0.0f, 2.0f);
+   mat4_identity(ref);
+   mat4_rotate(ref, 90.0f, 0.0f, 0.0f, 1.0f);
+   e = max_error(rot, ref, 16, 3);
+   printf("rotate: unnormalized axis error %g\n", e);
+   fail |= e > 1e-6f;
+
+   /* column major: x scales the first three values */
+   mat3_transform(m3, v3, p);
+   printf("mat3 transform: %g %g %g\n", p[0], p[1], p[2]);
+   fail |= p[0] != 741.0f || p[1] != 852.0f || p[2] != 963.0f;
+
+   return fail;
+}
+
+static void
+bench(int iterations)
+{
+   float a[16], b[16];
+   float *in, *out;
+   double t, scalar, simd;
+   int i;
+
+   /* chained through a rotation, so the values neither grow nor vanish */
+   mat4_identity(b);
+   mat4_rotate(b, 1.0f, 1.0f, 2.0f, 3.0f);
+
+   random_matrix(a);
+   t = now();
+   for (i = 0; i < iterations; i++)
+      mat4_multiply_scalar(a, a, b);
+   scalar = now() - t;
+   sink = a[0];
+
+   random_matrix(a);
+   t = now();
+   for (i = 0; i < iterations; i++)
+      mat4_multiply(a, a, b);
+   simd = now() - t;
+   sink = a[0];
+
+   printf("multiply: scalar %.2f ns, %s %.2f ns, %.2fx\n",
+          scalar * 1e9 / iterations, mat4_simd(), simd * 1e9 / iterations, scalar / simd);
+
+   in = malloc(POINTS * STRIDE * sizeof(float));
+   out = malloc(POINTS * STRIDE * sizeof(float));
+   if (!in || !out) {
+      free(in);
+      free(out);
+      return;
+   }
+   /* out is touched first, the page faults are not the code's */
+   for (i = 0; i < POINTS * STRIDE; i++) {
+      in[i] = (float)drand48();
+      out[i] = 0.0f;
+   }
+   random_matrix(a);
+
+   t = now();
+   mat4_transform_points_scalar(a, in, STRIDE, out, STRIDE, POINTS);
+   scalar = now() - t;
+   sink = out[POINTS / 2 * STRIDE];
+
+   t = now();
+   mat4_transform_points(a, in, STRIDE, out, STRIDE, POINTS);
+   simd = now() - t;
+   sink = out[POINTS / 2 * STRIDE];
+
+   printf("transform %d points: scalar %.3f ms, %s %.3f ms, %.2fx\n",
+          POINTS, scalar * 1000.0, mat4_simd(), simd * 1000.0, scalar / simd);
+
+   free(in);
+   free(out);
+}
+
+int
+main(int argc, char **argv)
+{
+   const char *env = getenv("MAT4BENCH_ITERATIONS");
+   int iterations = argc > 1 ? atoi(argv[1]) : env ? atoi(env) : 10000000;
+
+   srand48(1);
+   if (check()) {
+      printf("mat4bench: %s results differ from the scalar reference\n", mat4_simd());
+      return 1;
+   }
+   if (iterations > 0)
+      bench(iterations);
+
+   return 0;
+}
@@ -0,0 +1,218 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <Ecore.h>
+#include "pacing.h"
+
+struct _Pacing {
+   char *name;
+   Evas_Object *win;
+   Evas *evas;         /* NULL once the window is gone */
+   Elm_GLView_Render_Policy policy;
+   Ecore_Timer *timer;
+   double since;
+
+   /* animator ticks */
+   double last_tick;
+   double pending;     /* oldest changed_set not drawn yet, 0 if none */
+   int ticks, missed, coalesced;
+   double interval, interval_sq, interval_max;
+
+   /* render callback */
+   double draw_begin;
+   int draws, latencies;
+   double draw, latency, latency_max;
+
+   /* Evas flush */
+   double flush_begin;
+   int flushes;
+   double flush, flush_max;
+};
+
+static void
+_flush_pre(void *data, Evas *e EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   Pacing *p = data;
+
+   p->flush_begin = ecore_time_get();
+}
+
+static void
+_flush_post(void *data, Evas *e EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   Pacing *p = data;
+   double t;
+
+   if (p->flush_begin <= 0.0)
+      return;
+   t = ecore_time_get() - p->flush_begin;
+   p->flush += t;
+   if (t > p->flush_max)
+      p->flush_max = t;
+   p->flushes++;
+   p->flush_begin = 0.0;
+}
+
+static void
+_win_del(void *data, Evas *e EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   Pacing *p = data;
+
+   p->evas = NULL;
+}
+
+static Eina_Bool
+_report(void *data)
+{
+   Pacing *p = data;
+   double frametime = ecore_animator_frametime_get();
+   double now = ecore_time_get();
+   double dt = now - p->since;
+   double mean = 0.0, jitter = 0.0;
+   int n = p->ticks - 1;   /* intervals */
+
+   if (n > 0) {
+      mean = p->interval / n;
+      jitter = p->interval_sq / n - mean * mean;
+      jitter = jitter > 0.0 ? sqrt(jitter) : 0.0;
+   }
+
+   printf("pacing %s (%s, frametime %.2f ms): %.1f ticks/s, %.1f draws/s\n",
+          p->name, p->policy == ELM_GLVIEW_RENDER_POLICY_ALWAYS ? "always" : "on_demand",
+          frametime * 1000.0, p->ticks / dt, p->draws / dt);
+   printf("  tick interval %.3f ms, jitter %.3f ms, max %.3f ms, %d missed frames, %d ticks coalesced\n",
+          mean * 1000.0, jitter * 1000.0, p->interval_max * 1000.0, p->missed, p->coalesced);
+   printf("  changed_set to draw %.3f ms avg, %.3f ms max; draw %.3f ms; flush %.3f ms avg, %.3f ms max\n",
+          p->latencies ? p->latency * 1000.0 / p->latencies : 0.0, p->latency_max * 1000.0,
+          p->draws ? p->draw * 1000.0 / p->draws : 0.0,
+          p->flushes ? p->flush * 1000.0 / p->flushes : 0.0, p->flush_max * 1000.0);
+
+   /* the next window starts at the last tick, so no interval is lost */
+   p->since = now;
+   p->ticks = p->last_tick > 0.0 ? 1 : 0;
+   p->missed = p->coalesced = 0;
+   p->interval = p->interval_sq = p->interval_max = 0.0;
+   p->draws = p->latencies = 0;
+   p->draw = p->latency = p->latency_max = 0.0;
+   p->flushes = 0;
+   p->flush = p->flush_max = 0.0;
+
+   return ECORE_CALLBACK_RENEW;
+}
+
+/* RENDER_POLICY=on_demand|always, on demand when unset */
+Elm_GLView_Render_Policy
+pacing_render_policy(void)
+{
+   const char *policy = getenv("RENDER_POLICY");
+
+   if (policy && !strcmp(policy, "always"))
+      return ELM_GLVIEW_RENDER_POLICY_ALWAYS;
+
+   return ELM_GLVIEW_RENDER_POLICY_ON_DEMAND;
+}
+
+Pacing *
+pacing_new(const char *name, Evas_Object *win, Elm_GLView_Render_Policy policy)
+{
+   const char *period = getenv("PACING");
+   Pacing *p;
+
+   if (!period || atof(period) <= 0.0)
+      return NULL;
+
+   p = calloc(1, sizeof(Pacing));
+   if (!p)
+      return NULL;
+
+   p->name = strdup(name);
+   p->policy = policy;
+   p->since = ecore_time_get();
+   p->timer = ecore_timer_add(atof(period), _report, p);
+
+   p->win = win;
+   p->evas = evas_object_evas_get(win);
+   evas_object_event_callback_add(win, EVAS_CALLBACK_DEL, _win_del, p);
+   evas_event_callback_add(p->evas, EVAS_CALLBACK_RENDER_FLUSH_PRE, _flush_pre, p);
+   evas_event_callback_add(p->evas, EVAS_CALLBACK_RENDER_FLUSH_POST, _flush_post, p);
+
+   return p;
+}
+
+void
+pacing_free(Pacing *p)
+{
+   if (!p)
+      return;
+
+   if (p->evas) {
+      evas_object_event_callback_del_full(p->win, EVAS_CALLBACK_DEL, _win_del, p);
+      evas_event_callback_del_full(p->evas, EVAS_CALLBACK_RENDER_FLUSH_PRE, _flush_pre, p);
+      evas_event_callback_del_full(p->evas, EVAS_CALLBACK_RENDER_FLUSH_POST, _flush_post, p);
+   }
+   ecore_timer_del(p->timer);
+   free(p->name);
+   free(p);
+}
+
+/* Call where the animator calls elm_glview_changed_set(). */
+void
+pacing_tick(Pacing *p)
+{
+   double now, interval, frametime;
+
+   if (!p)
+      return;
+
+   now = ecore_time_get();
+   if (p->last_tick > 0.0) {
+      interval = now - p->last_tick;
+      frametime = ecore_animator_frametime_get();
+      p->interval += interval;
+      p->interval_sq += interval * interval;
+      if (interval > p->interval_max)
+         p->interval_max = interval;
+      /* a tick 1.5 frametimes apart skipped at least one vsync */
+      if (frametime > 0.0 && interval > 1.5 * frametime)
+         p->missed += (int)(interval / frametime + 0.5) - 1;
+   }
+   p->last_tick = now;
+   p->ticks++;
+
+   /* on demand, a second changed_set before the draw is folded into it */
+   if (p->pending > 0.0)
+      p->coalesced++;
+   else
+      p->pending = now;
+}
+
+void
+pacing_draw_begin(Pacing *p)
+{
+   double latency;
+
+   if (!p)
+      return;
+
+   p->draw_begin = ecore_time_get();
+   /* always-policy draws nobody asked for have no latency to speak of */
+   if (p->pending > 0.0) {
+      latency = p->draw_begin - p->pending;
+      p->latency += latency;
+      if (latency > p->latency_max)
+         p->latency_max = latency;
+      p->latencies++;
+      p->pending = 0.0;
+   }
+}
+
+void
+pacing_draw_end(Pacing *p)
+{
+   if (!p)
+      return;
+
+   p->draw += ecore_time_get() - p->draw_begin;
+   p->draws++;
+}
@@ -0,0 +1,31 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include <Elementary.h>
+
+/*
+ * Frame pacing instrumentation for the glview demos.
+ *
+ * PACING=<seconds> records, per frame, the animator tick that calls
+ * elm_glview_changed_set(), the start and end of the glview render
+ * callback and the Evas render flush around it, and prints a summary
+ * every <seconds>: the tick interval and its jitter against the animator
+ * frametime, missed frames (ticks more than 1.5 frametimes after the
+ * previous one, which skipped at least one vsync),
+ * the latency from changed_set to the draw it asked for, ticks that were
+ * coalesced into one draw, and the draw and flush times.
+ *
+ * RENDER_POLICY=on_demand|always picks the glview render policy the
+ * numbers are taken under; with "always" the glview redraws on every
+ * canvas render whether or not changed_set was called.
+ */
+typedef struct _Pacing Pacing;
+
+Elm_GLView_Render_Policy pacing_render_policy(void);
+Pacing  *pacing_new(const char *name, Evas_Object *win, Elm_GLView_Render_Policy policy);
+void     pacing_free(Pacing *pacing);
+void     pacing_tick(Pacing *pacing);
+void     pacing_draw_begin(Pacing *pacing);
+void     pacing_draw_end(Pacing *pacing);
+
+#endif
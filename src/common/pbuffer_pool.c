@@ -0,0 +1,210 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <Ecore.h>
+#include "pbuffer_pool.h"
+
+#define PBUFFER_POOL_MAX 16
+
+typedef struct _Pbuffer_Pool_Entry Pbuffer_Pool_Entry;
+
+struct _Pbuffer_Pool_Entry {
+   Evas_GL_Surface *surface;
+   int w, h;           /* bucket size */
+   Eina_Bool busy;
+   double last_used;
+};
+
+struct _Pbuffer_Pool {
+   Evas_GL *evas_gl;
+   Evas_GL_Config *config;
+   int bucket;
+   double timeout;
+   Ecore_Timer *timer;
+
+   Pbuffer_Pool_Entry entries[PBUFFER_POOL_MAX];
+   int count;
+
+   unsigned long created, reused, evicted;
+};
+
+static int
+_round_up(int v, int bucket)
+{
+   return (v + bucket - 1) / bucket * bucket;
+}
+
+static void
+_entry_destroy(Pbuffer_Pool *pool, int i)
+{
+   evas_gl_surface_destroy(pool->evas_gl, pool->entries[i].surface);
+   pool->entries[i] = pool->entries[--pool->count];
+}
+
+static Eina_Bool
+_evict(void *data)
+{
+   Pbuffer_Pool *pool = data;
+   double now = ecore_time_get();
+   int i;
+
+   for (i = pool->count - 1; i >= 0; i--) {
+      Pbuffer_Pool_Entry *e = &pool->entries[i];
+
+      if (e->busy || now - e->last_used < pool->timeout)
+         continue;
+      printf("pbuffer pool: evicting %dx%d surface, idle for %.1f s\n",
+             e->w, e->h, now - e->last_used);
+      _entry_destroy(pool, i);
+      pool->evicted++;
+   }
+
+   return ECORE_CALLBACK_RENEW;
+}
+
+Pbuffer_Pool *
+pbuffer_pool_new(Evas_GL *evas_gl, const Evas_GL_Config *config, int bucket, double timeout)
+{
+   Pbuffer_Pool *pool;
+
+   pool = calloc(1, sizeof(Pbuffer_Pool));
+   if (!pool)
+      return NULL;
+
+   pool->config = evas_gl_config_new();
+   if (!pool->config) {
+      free(pool);
+      return NULL;
+   }
+   *pool->config = *config;
+
+   pool->evas_gl = evas_gl;
+   pool->bucket = bucket > 0 ? bucket : 1;
+   pool->timeout = timeout;
+   pool->timer = ecore_timer_add(timeout / 2.0, _evict, pool);
+
+   return pool;
+}
+
+void
+pbuffer_pool_free(Pbuffer_Pool *pool)
+{
+   if (!pool)
+      return;
+
+   if (pool->timer)
+      ecore_timer_del(pool->timer);
+   while (pool->count)
+      _entry_destroy(pool, pool->count - 1);
+   evas_gl_config_free(pool->config);
+   free(pool);
+}
+
+Evas_GL_Surface *
+pbuffer_pool_acquire(Pbuffer_Pool *pool, int w, int h)
+{
+   Pbuffer_Pool_Entry *e, *best = NULL;
+   int bw = _round_up(w, pool->bucket);
+   int bh = _round_up(h, pool->bucket);
+   int i;
+
+   /* smallest idle surface that fits, an exact bucket if there is one */
+   for (i = 0; i < pool->count; i++) {
+      e = &pool->entries[i];
+      if (e->busy || e->w < bw || e->h < bh)
+         continue;
+      if (!best || e->w * e->h < best->w * best->h)
+         best = e;
+   }
+   if (best && best->w == bw && best->h == bh) {
+      best->busy = EINA_TRUE;
+      pool->reused++;
+      return best->surface;
+   }
+
+   /* pool full: make do with a bigger surface, or evict the least
+    * recently used idle one */
+   if (pool->count == PBUFFER_POOL_MAX) {
+      int lru = -1;
+
+      if (best) {
+         best->busy = EINA_TRUE;
+         pool->reused++;
+         return best->surface;
+      }
+
+      for (i = 0; i < pool->count; i++) {
+         e = &pool->entries[i];
+         if (!e->busy && (lru < 0 || e->last_used < pool->entries[lru].last_used))
+            lru = i;
+      }
+      if (lru < 0)
+         return NULL;
+      _entry_destroy(pool, lru);
+      pool->evicted++;
+   }
+
+   e = &pool->entries[pool->count];
+   e->surface = evas_gl_pbuffer_surface_create(pool->evas_gl, pool->config, bw, bh, NULL);
+   if (!e->surface) {
+      printf("pbuffer pool: cannot create a %dx%d pbuffer\n", bw, bh);
+      /* a bigger idle surface still does the job */
+      if (!best)
+         return NULL;
+      best->busy = EINA_TRUE;
+      pool->reused++;
+      return best->surface;
+   }
+   e->w = bw;
+   e->h = bh;
+   e->busy = EINA_TRUE;
+   pool->count++;
+   pool->created++;
+
+   return e->surface;
+}
+
+void
+pbuffer_pool_release(Pbuffer_Pool *pool, Evas_GL_Surface *surface)
+{
+   int i;
+
+   for (i = 0; i < pool->count; i++) {
+      if (pool->entries[i].surface == surface) {
+         pool->entries[i].busy = EINA_FALSE;
+         pool->entries[i].last_used = ecore_time_get();
+         return;
+      }
+   }
+}
+
+/* Keeps surface while w x h stays in its bucket, otherwise swaps it for
+ * one of the right bucket.  Returns NULL, keeping surface busy, when no
+ * such pbuffer can be had. */
+Evas_GL_Surface *
+pbuffer_pool_resize(Pbuffer_Pool *pool, Evas_GL_Surface *surface, int w, int h)
+{
+   Evas_GL_Surface *s;
+   int i;
+
+   for (i = 0; i < pool->count; i++) {
+      Pbuffer_Pool_Entry *e = &pool->entries[i];
+
+      if (e->surface == surface &&
+          e->w == _round_up(w, pool->bucket) && e->h == _round_up(h, pool->bucket))
+         return surface;
+   }
+
+   s = pbuffer_pool_acquire(pool, w, h);
+   if (s && surface)
+      pbuffer_pool_release(pool, surface);
+
+   return s;
+}
+
+void
+pbuffer_pool_report(const Pbuffer_Pool *pool)
+{
+   printf("pbuffer pool: %d surfaces live, %lu created, %lu reused, %lu evicted\n",
+          pool->count, pool->created, pool->reused, pool->evicted);
+}
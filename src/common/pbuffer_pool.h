@@ -0,0 +1,25 @@
+#ifndef PBUFFER_POOL_H
+#define PBUFFER_POOL_H
+
+#include <Evas_GL.h>
+
+/*
+ * Pool of pbuffer surfaces keyed by size bucket.
+ *
+ * Sizes are rounded up to a multiple of the bucket, so a surface serves
+ * every size in its bucket: callers render and read back only the w x h
+ * corner at the origin.  Surfaces handed back go idle instead of being
+ * destroyed and are picked up again when the size comes back; a timer
+ * destroys those that stayed idle longer than the timeout.  Dragging a
+ * window edge therefore creates one surface per bucket crossed, once.
+ */
+typedef struct _Pbuffer_Pool Pbuffer_Pool;
+
+Pbuffer_Pool    *pbuffer_pool_new(Evas_GL *evas_gl, const Evas_GL_Config *config, int bucket, double timeout);
+void             pbuffer_pool_free(Pbuffer_Pool *pool);
+Evas_GL_Surface *pbuffer_pool_acquire(Pbuffer_Pool *pool, int w, int h);
+void             pbuffer_pool_release(Pbuffer_Pool *pool, Evas_GL_Surface *surface);
+Evas_GL_Surface *pbuffer_pool_resize(Pbuffer_Pool *pool, Evas_GL_Surface *surface, int w, int h);
+void             pbuffer_pool_report(const Pbuffer_Pool *pool);
+
+#endif
@@ -0,0 +1,242 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+#include "frame_stats.h"
+#include "perf_counters.h"
+
+enum {
+   CYCLES,             /* the group leader */
+   INSTRUCTIONS,
+   CACHE_REFERENCES,
+   CACHE_MISSES,
+   BRANCH_MISSES,
+   EVENTS
+};
+
+struct _Perf_Counters {
+   char *name;
+   int report;              /* frames per report */
+
+   int opened;
+   int fd[EVENTS];          /* -1 when not counted */
+   int slot[EVENTS];        /* index in the group read */
+   int nr;                  /* events in the group */
+
+   /* group read at perf_counters_begin(): nr, time enabled, time running
+    * and the values */
+   uint64_t begin[3 + EVENTS];
+   int begun;
+   int in_frame;            /* between a begin and its end */
+   uint64_t begin_time, last_begin;
+
+   /* the frames of the current report */
+   double sums[EVENTS];
+   uint64_t frame_time, draw_time;
+   int frames, intervals, counted;
+};
+
+#if defined(__linux__)
+static const struct {
+   uint64_t config;
+   const char *name;
+} events[EVENTS] = {
+   { PERF_COUNT_HW_CPU_CYCLES,       "cycles" },
+   { PERF_COUNT_HW_INSTRUCTIONS,     "instructions" },
+   { PERF_COUNT_HW_CACHE_REFERENCES, "cache references" },
+   { PERF_COUNT_HW_CACHE_MISSES,     "cache misses" },
+   { PERF_COUNT_HW_BRANCH_MISSES,    "branch misses" },
+};
+
+static void
+_open(Perf_Counters *pc)
+{
+   struct perf_event_attr attr;
+   int e;
+
+   for (e = 0; e < EVENTS; e++) {
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = events[e].config;
+      attr.read_format = PERF_FORMAT_GROUP |
+                         PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      /* the group starts once every member is in */
+      attr.disabled = e == CYCLES;
+
+      /* this thread, any CPU */
+      pc->fd[e] = syscall(__NR_perf_event_open, &attr, 0, -1,
+                          e == CYCLES ? -1 : pc->fd[CYCLES], 0);
+      if (pc->fd[e] < 0) {
+         printf("perf: %s: %s not counted (%s)\n", pc->name, events[e].name, strerror(errno));
+         if (e == CYCLES)
+            return;
+         continue;
+      }
+      pc->slot[e] = pc->nr++;
+   }
+
+   ioctl(pc->fd[CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+#else
+static void
+_open(Perf_Counters *pc)
+{
+   printf("perf: %s: hardware counters need Linux\n", pc->name);
+}
+#endif
+
+static int
+_read(Perf_Counters *pc, uint64_t *values)
+{
+   ssize_t size = (3 + pc->nr) * sizeof(uint64_t);
+
+   return pc->fd[CYCLES] >= 0 && read(pc->fd[CYCLES], values, size) == size;
+}
+
+static void
+_report(Perf_Counters *pc)
+{
+   double n = pc->counted;
+   double *s = pc->sums;
+
+   printf("perf: name=%s frames=%d frame_ms=%.3f draw_ms=%.3f",
+          pc->name, pc->frames,
+          pc->intervals ? pc->frame_time / 1e6 / pc->intervals : 0.0,
+          pc->draw_time / 1e6 / pc->frames);
+   if (n > 0) {
+      printf(" cycles=%.0f", s[CYCLES] / n);
+      if (pc->fd[INSTRUCTIONS] >= 0)
+         printf(" instructions=%.0f ipc=%.2f", s[INSTRUCTIONS] / n,
+                s[CYCLES] > 0 ? s[INSTRUCTIONS] / s[CYCLES] : 0.0);
+      if (pc->fd[CACHE_MISSES] >= 0) {
+         printf(" cache_misses=%.0f", s[CACHE_MISSES] / n);
+         if (pc->fd[INSTRUCTIONS] >= 0)
+            printf(" cache_mpki=%.2f",
+                   s[INSTRUCTIONS] > 0 ? s[CACHE_MISSES] * 1000.0 / s[INSTRUCTIONS] : 0.0);
+         if (pc->fd[CACHE_REFERENCES] >= 0)
+            printf(" cache_miss_pct=%.1f",
+                   s[CACHE_REFERENCES] > 0 ? s[CACHE_MISSES] * 100.0 / s[CACHE_REFERENCES] : 0.0);
+      }
+      if (pc->fd[BRANCH_MISSES] >= 0 && pc->fd[INSTRUCTIONS] >= 0)
+         printf(" branch_mpki=%.2f",
+                s[INSTRUCTIONS] > 0 ? s[BRANCH_MISSES] * 1000.0 / s[INSTRUCTIONS] : 0.0);
+   }
+   printf("\n");
+
+   memset(pc->sums, 0, sizeof(pc->sums));
+   pc->frame_time = pc->draw_time = 0;
+   pc->frames = pc->intervals = pc->counted = 0;
+}
+
+Perf_Counters *
+perf_counters_new(const char *name)
+{
+   const char *frames = getenv("PERF_COUNTERS");
+   Perf_Counters *pc;
+   int e;
+
+   if (!frames || atoi(frames) <= 0)
+      return NULL;
+
+   pc = calloc(1, sizeof(Perf_Counters));
+   if (!pc)
+      return NULL;
+
+   pc->name = strdup(name);
+   pc->report = atoi(frames);
+   for (e = 0; e < EVENTS; e++)
+      pc->fd[e] = -1;
+
+   return pc;
+}
+
+void
+perf_counters_begin(Perf_Counters *pc)
+{
+   uint64_t now;
+
+   if (!pc)
+      return;
+
+   if (!pc->opened) {
+      _open(pc);
+      pc->opened = 1;
+   }
+
+   now = frame_stats_now();
+   if (pc->last_begin) {
+      pc->frame_time += now - pc->last_begin;
+      pc->intervals++;
+   }
+   pc->last_begin = pc->begin_time = now;
+   pc->in_frame = 1;
+
+   /* read last, so the bookkeeping above is not counted */
+   pc->begun = _read(pc, pc->begin);
+}
+
+void
+perf_counters_end(Perf_Counters *pc)
+{
+   uint64_t end[3 + EVENTS];
+   uint64_t enabled, running;
+   double scale;
+   int e, s;
+
+   if (!pc || !pc->in_frame)
+      return;
+
+   /* read first, for the same reason */
+   if (pc->begun && _read(pc, end)) {
+      enabled = end[1] - pc->begin[1];
+      running = end[2] - pc->begin[2];
+      /* a frame the PMU did not run the group in at all has no counts */
+      if (running) {
+         /* multiplexed with other users of the PMU, extrapolate */
+         scale = running < enabled ? (double)enabled / running : 1.0;
+         for (e = 0; e < EVENTS; e++) {
+            if (pc->fd[e] < 0)
+               continue;
+            s = pc->slot[e];
+            pc->sums[e] += (end[3 + s] - pc->begin[3 + s]) * scale;
+         }
+         pc->counted++;
+      }
+   }
+   pc->begun = 0;
+   pc->in_frame = 0;
+
+   pc->draw_time += frame_stats_now() - pc->begin_time;
+   if (++pc->frames == pc->report)
+      _report(pc);
+}
+
+/* Reports the frames left over and closes the counters. */
+void
+perf_counters_free(Perf_Counters *pc)
+{
+   int e;
+
+   if (!pc)
+      return;
+
+   if (pc->frames)
+      _report(pc);
+   for (e = 0; e < EVENTS; e++) {
+      if (pc->fd[e] >= 0)
+         close(pc->fd[e]);
+   }
+   free(pc->name);
+   free(pc);
+}
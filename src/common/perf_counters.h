@@ -0,0 +1,33 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+/*
+ * Hardware counters around the draw callback.
+ *
+ * PERF_COUNTERS=<frames> counts CPU cycles, instructions, cache references
+ * and misses and branch misses of the drawing thread in user space, with
+ * perf_event_open(), between perf_counters_begin() and perf_counters_end().
+ * Every <frames> frames it prints one "perf:" line of per frame averages:
+ * the frame time (between two begins), the time inside the callback, the
+ * cycles and instructions, IPC, cache misses per frame, per thousand
+ * instructions and as a share of the references, and branch misses per
+ * thousand instructions.  A low IPC with many cache misses points at a
+ * memory bound callback, a high IPC at a compute bound one.
+ *
+ * A callback that does more than draw can end the window early, before
+ * that work; perf_counters_end() does nothing outside a window, so the
+ * end at the bottom of the callback may stay for the frames that did not.
+ *
+ * The counters are opened by the first perf_counters_begin(), in the
+ * thread that draws.  An event the CPU or the kernel does not offer is
+ * left out of the report; without cycles, or outside Linux, nothing is
+ * counted.  perf_event_paranoid above 2 refuses even user space counting.
+ */
+typedef struct _Perf_Counters Perf_Counters;
+
+Perf_Counters *perf_counters_new(const char *name);
+void           perf_counters_begin(Perf_Counters *pc);
+void           perf_counters_end(Perf_Counters *pc);
+void           perf_counters_free(Perf_Counters *pc);
+
+#endif
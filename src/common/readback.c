@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "readback.h"
+
+#define READBACK_MAX_TARGETS 4
+
+struct _Readback {
+   Evas_GL_API *gl;
+   int targets;
+   int depth;
+   int w, h;
+   int frame;
+
+   /* depth * targets buffers, slot-major */
+   GLuint *pbo;
+   GLuint mapped[READBACK_MAX_TARGETS];
+};
+
+static void
+_readback_storage(Readback *rb)
+{
+   Evas_GL_API *gl = rb->gl;
+   int i;
+
+   for (i = 0; i < rb->depth * rb->targets; i++) {
+      gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbo[i]);
+      gl->glBufferData(GL_PIXEL_PACK_BUFFER, rb->w * rb->h * 4, NULL, GL_STREAM_READ);
+   }
+   gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+   rb->frame = 0;
+}
+
+Readback *
+readback_new(Evas_GL_API *gl, int targets, int depth, int w, int h)
+{
+   Readback *rb;
+
+   if (!gl || !gl->glMapBufferRange) {
+      printf("readback: pixel pack buffers need a GLES 3.x context\n");
+      return NULL;
+   }
+   if (targets < 1 || targets > READBACK_MAX_TARGETS || depth < 2)
+      return NULL;
+
+   rb = calloc(1, sizeof(Readback));
+   if (!rb)
+      return NULL;
+
+   rb->pbo = calloc(depth * targets, sizeof(GLuint));
+   if (!rb->pbo) {
+      free(rb);
+      return NULL;
+   }
+
+   rb->gl = gl;
+   rb->targets = targets;
+   rb->depth = depth;
+   rb->w = w;
+   rb->h = h;
+
+   gl->glGenBuffers(depth * targets, rb->pbo);
+   _readback_storage(rb);
+
+   return rb;
+}
+
+void
+readback_free(Readback *rb)
+{
+   if (!rb)
+      return;
+
+   readback_unmap(rb);
+   rb->gl->glDeleteBuffers(rb->depth * rb->targets, rb->pbo);
+   free(rb->pbo);
+   free(rb);
+}
+
+void
+readback_resize(Readback *rb, int w, int h)
+{
+   if (rb->w == w && rb->h == h)
+      return;
+
+   readback_unmap(rb);
+   rb->w = w;
+   rb->h = h;
+   /* frames still in flight have the old size, start over */
+   _readback_storage(rb);
+}
+
+void
+readback_read(Readback *rb, int target)
+{
+   Evas_GL_API *gl = rb->gl;
+   int slot = rb->frame % rb->depth;
+
+   gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbo[slot * rb->targets + target]);
+   gl->glReadPixels(0, 0, rb->w, rb->h, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid *) 0);
+   gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+const void *
+readback_map(Readback *rb, int target)
+{
+   Evas_GL_API *gl = rb->gl;
+   int slot = (rb->frame + 1) % rb->depth;
+   GLuint pbo = rb->pbo[slot * rb->targets + target];
+   void *ptr;
+
+   /* the oldest slot has not been written yet */
+   if (rb->frame < rb->depth - 1)
+      return NULL;
+
+   gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+   ptr = gl->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, rb->w * rb->h * 4, GL_MAP_READ_BIT);
+   gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+   if (ptr)
+      rb->mapped[target] = pbo;
+
+   return ptr;
+}
+
+void
+readback_unmap(Readback *rb)
+{
+   Evas_GL_API *gl = rb->gl;
+   int i;
+
+   for (i = 0; i < rb->targets; i++) {
+      if (!rb->mapped[i])
+         continue;
+      gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->mapped[i]);
+      gl->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      rb->mapped[i] = 0;
+   }
+   gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void
+readback_advance(Readback *rb)
+{
+   rb->frame++;
+}
+
+int
+readback_depth(const Readback *rb)
+{
+   return rb->depth;
+}
+
+int
+readback_frame(const Readback *rb)
+{
+   return rb->frame - (rb->depth - 1);
+}
@@ -0,0 +1,34 @@
+#ifndef READBACK_H
+#define READBACK_H
+
+#include <Evas_GL.h>
+
+/*
+ * Asynchronous glReadPixels through a ring of pixel pack buffers.
+ *
+ * Needs a GLES 3.x context.  readback_read() only queues the copy of the
+ * current framebuffer into the PBO of the current slot, so the CPU keeps
+ * going while the GPU finishes the frame.  readback_map() returns the
+ * pixels of the oldest slot, i.e. the frame read depth - 1 frames ago,
+ * or NULL while the ring is still filling up.
+ *
+ * Usage per frame:
+ *    readback_read(rb, 0); ... readback_read(rb, 1);
+ *    a = readback_map(rb, 0); b = readback_map(rb, 1);
+ *    ... use a and b ...
+ *    readback_unmap(rb);
+ *    readback_advance(rb);
+ */
+typedef struct _Readback Readback;
+
+Readback   *readback_new(Evas_GL_API *gl, int targets, int depth, int w, int h);
+void        readback_free(Readback *rb);
+void        readback_resize(Readback *rb, int w, int h);
+void        readback_read(Readback *rb, int target);
+const void *readback_map(Readback *rb, int target);
+void        readback_unmap(Readback *rb);
+void        readback_advance(Readback *rb);
+int         readback_depth(const Readback *rb);
+int         readback_frame(const Readback *rb);
+
+#endif
@@ -0,0 +1,190 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "tex_atlas.h"
+
+#define TEX_ATLAS_BORDER 1
+
+struct _Tex_Atlas {
+   int w, h;
+   unsigned *pixels;   /* RGBA 8888, byte order R G B A in memory */
+
+   /* current shelf */
+   int shelf_x, shelf_y, shelf_h;
+
+   Tex_Atlas_Region *regions;
+   int count, size;
+};
+
+static unsigned
+_rgba(unsigned r, unsigned g, unsigned b, unsigned a)
+{
+   unsigned char c[4] = { r, g, b, a };
+   unsigned p;
+
+   memcpy(&p, c, 4);
+   return p;
+}
+
+static unsigned
+_convert(const void *pixels, int i, Tex_Atlas_Format format)
+{
+   unsigned p;
+
+   switch (format) {
+   case TEX_ATLAS_RGBA_4444:
+      p = ((const unsigned short *)pixels)[i];
+      return _rgba(((p >> 12) & 0xf) * 17, ((p >> 8) & 0xf) * 17,
+                   ((p >> 4) & 0xf) * 17, (p & 0xf) * 17);
+   case TEX_ATLAS_RGB_565:
+      p = ((const unsigned short *)pixels)[i];
+      return _rgba(((p >> 11) & 0x1f) * 255 / 31, ((p >> 5) & 0x3f) * 255 / 63,
+                   (p & 0x1f) * 255 / 31, 255);
+   default:
+      return ((const unsigned *)pixels)[i];
+   }
+}
+
+Tex_Atlas *
+tex_atlas_new(int w, int h)
+{
+   Tex_Atlas *atlas;
+
+   atlas = calloc(1, sizeof(Tex_Atlas));
+   if (!atlas)
+      return NULL;
+
+   atlas->pixels = calloc((size_t)w * h, 4);
+   if (!atlas->pixels) {
+      free(atlas);
+      return NULL;
+   }
+   atlas->w = w;
+   atlas->h = h;
+
+   return atlas;
+}
+
+void
+tex_atlas_free(Tex_Atlas *atlas)
+{
+   if (!atlas)
+      return;
+
+   free(atlas->regions);
+   free(atlas->pixels);
+   free(atlas);
+}
+
+/* Returns the region index, -1 when the image does not fit. */
+int
+tex_atlas_add(Tex_Atlas *atlas, const void *pixels, int w, int h, Tex_Atlas_Format format)
+{
+   Tex_Atlas_Region *r;
+   int bw = w + 2 * TEX_ATLAS_BORDER;
+   int bh = h + 2 * TEX_ATLAS_BORDER;
+   int x, y, sx, sy;
+
+   if (bw > atlas->w)
+      return -1;
+
+   /* next shelf when this one is full */
+   if (atlas->shelf_x + bw > atlas->w) {
+      atlas->shelf_y += atlas->shelf_h;
+      atlas->shelf_x = 0;
+      atlas->shelf_h = 0;
+   }
+   if (atlas->shelf_y + bh > atlas->h) {
+      printf("tex_atlas: no room for a %dx%d image in %dx%d\n", w, h, atlas->w, atlas->h);
+      return -1;
+   }
+
+   if (atlas->count == atlas->size) {
+      int size = atlas->size ? atlas->size * 2 : 8;
+
+      r = realloc(atlas->regions, size * sizeof(Tex_Atlas_Region));
+      if (!r)
+         return -1;
+      atlas->regions = r;
+      atlas->size = size;
+   }
+
+   r = &atlas->regions[atlas->count];
+   r->x = atlas->shelf_x + TEX_ATLAS_BORDER;
+   r->y = atlas->shelf_y + TEX_ATLAS_BORDER;
+   r->w = w;
+   r->h = h;
+   r->u0 = (float)r->x / atlas->w;
+   r->v0 = (float)r->y / atlas->h;
+   r->su = (float)w / atlas->w;
+   r->sv = (float)h / atlas->h;
+
+   /* the border repeats the nearest edge pixel */
+   for (y = -TEX_ATLAS_BORDER; y < h + TEX_ATLAS_BORDER; y++) {
+      unsigned *dst = atlas->pixels + (size_t)(r->y + y) * atlas->w + r->x;
+
+      sy = y < 0 ? 0 : (y >= h ? h - 1 : y);
+      for (x = -TEX_ATLAS_BORDER; x < w + TEX_ATLAS_BORDER; x++) {
+         sx = x < 0 ? 0 : (x >= w ? w - 1 : x);
+         dst[x] = _convert(pixels, sy * w + sx, format);
+      }
+   }
+
+   atlas->shelf_x += bw;
+   if (bh > atlas->shelf_h)
+      atlas->shelf_h = bh;
+
+   return atlas->count++;
+}
+
+const Tex_Atlas_Region *
+tex_atlas_region_get(const Tex_Atlas *atlas, int region)
+{
+   if (region < 0 || region >= atlas->count)
+      return NULL;
+
+   return &atlas->regions[region];
+}
+
+/* Column major texture matrix mapping 0..1 onto the region. */
+void
+tex_atlas_matrix(const Tex_Atlas_Region *region, float m[16])
+{
+   memset(m, 0, 16 * sizeof(float));
+   m[0] = region->su;
+   m[5] = region->sv;
+   m[10] = 1.0f;
+   m[12] = region->u0;
+   m[13] = region->v0;
+   m[15] = 1.0f;
+}
+
+/* count (u, v) pairs */
+void
+tex_atlas_remap(const Tex_Atlas_Region *region, const float *uv, float *out, int count)
+{
+   int i;
+
+   for (i = 0; i < count; i++) {
+      out[i * 2] = region->u0 + uv[i * 2] * region->su;
+      out[i * 2 + 1] = region->v0 + uv[i * 2 + 1] * region->sv;
+   }
+}
+
+GLuint
+tex_atlas_upload(const Tex_Atlas *atlas, Evas_GL_API *gl)
+{
+   GLuint tex;
+
+   gl->glGenTextures(1, &tex);
+   gl->glBindTexture(GL_TEXTURE_2D, tex);
+   gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+   gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlas->w, atlas->h, 0,
+                    GL_RGBA, GL_UNSIGNED_BYTE, atlas->pixels);
+   gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+   gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+   gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+   return tex;
+}
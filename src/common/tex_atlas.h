@@ -0,0 +1,41 @@
+#ifndef TEX_ATLAS_H
+#define TEX_ATLAS_H
+
+#include <Eina.h>
+#include <Evas_GL.h>
+
+/*
+ * Packs small images into one RGBA 8888 texture.
+ *
+ * Images are placed on shelves, left to right, with a one pixel border
+ * copied from their edges so linear filtering at a region edge does not
+ * pick up the neighbour.  Each region maps the image's own 0..1 texture
+ * coordinates into the atlas as u' = u0 + u * su, v' = v0 + v * sv, either
+ * through the GL_TEXTURE matrix from tex_atlas_matrix() or baked into a
+ * copy of the texture coordinates by tex_atlas_remap().  With the latter
+ * objects switch image with one glTexCoordPointer() instead of binding
+ * another texture.  16 bit source formats are expanded on the way in.
+ */
+typedef struct _Tex_Atlas Tex_Atlas;
+typedef struct _Tex_Atlas_Region Tex_Atlas_Region;
+
+typedef enum {
+   TEX_ATLAS_RGBA_8888,
+   TEX_ATLAS_RGBA_4444,
+   TEX_ATLAS_RGB_565
+} Tex_Atlas_Format;
+
+struct _Tex_Atlas_Region {
+   int x, y, w, h;          /* in pixels, border excluded */
+   float u0, v0, su, sv;
+};
+
+Tex_Atlas              *tex_atlas_new(int w, int h);
+void                    tex_atlas_free(Tex_Atlas *atlas);
+int                     tex_atlas_add(Tex_Atlas *atlas, const void *pixels, int w, int h, Tex_Atlas_Format format);
+const Tex_Atlas_Region *tex_atlas_region_get(const Tex_Atlas *atlas, int region);
+void                    tex_atlas_matrix(const Tex_Atlas_Region *region, float m[16]);
+void                    tex_atlas_remap(const Tex_Atlas_Region *region, const float *uv, float *out, int count);
+GLuint                  tex_atlas_upload(const Tex_Atlas *atlas, Evas_GL_API *gl);
+
+#endif
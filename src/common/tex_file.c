@@ -0,0 +1,180 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "tex_file.h"
+
+/* bytes per pixel of an uncompressed format and type, 0 for those the
+ * loader does not know */
+static size_t
+_pixel_size(uint32_t format, uint32_t type)
+{
+   switch (type) {
+   case GL_UNSIGNED_SHORT_5_6_5:
+      return format == GL_RGB ? 2 : 0;
+   case GL_UNSIGNED_SHORT_4_4_4_4:
+   case GL_UNSIGNED_SHORT_5_5_5_1:
+      return format == GL_RGBA ? 2 : 0;
+   case GL_UNSIGNED_BYTE:
+      switch (format) {
+      case GL_RGBA:
+         return 4;
+      case GL_RGB:
+         return 3;
+      case GL_LUMINANCE_ALPHA:
+         return 2;
+      case GL_LUMINANCE:
+      case GL_ALPHA:
+         return 1;
+      }
+   }
+
+   return 0;
+}
+
+static Eina_Bool
+_index(Tex_File *file, const char *path)
+{
+   const Tex_File_Header *h = file->map;
+   const unsigned char *p = file->map;
+   size_t off = sizeof(Tex_File_Header);
+   size_t pixel = 0;
+   uint32_t size, i, w, hh;
+
+   if (file->map_size < sizeof(Tex_File_Header) ||
+       memcmp(h->magic, TEX_FILE_MAGIC, 8)) {
+      printf("tex_file: %s is not a texture file\n", path);
+      return EINA_FALSE;
+   }
+   if (h->endianness != TEX_FILE_ENDIANNESS) {
+      printf("tex_file: %s was written with the other byte order\n", path);
+      return EINA_FALSE;
+   }
+   if (!h->levels || h->levels > TEX_FILE_MAX_LEVELS) {
+      printf("tex_file: %s has %u mip levels\n", path, h->levels);
+      return EINA_FALSE;
+   }
+   if (!h->width || !h->height || h->width > 65536 || h->height > 65536) {
+      printf("tex_file: %s is %ux%u\n", path, h->width, h->height);
+      return EINA_FALSE;
+   }
+   if (h->gl_type && !(pixel = _pixel_size(h->gl_format, h->gl_type))) {
+      printf("tex_file: %s has an unknown format 0x%x, type 0x%x\n", path, h->gl_format, h->gl_type);
+      return EINA_FALSE;
+   }
+
+   w = h->width;
+   hh = h->height;
+   for (i = 0; i < h->levels; i++) {
+      if (off + 4 > file->map_size)
+         break;
+      memcpy(&size, p + off, 4);
+      off += 4;
+      if (size > file->map_size - off)
+         break;
+      /* glTexImage2D() reads the whole level, whatever the count says */
+      if (pixel && size < (size_t)w * hh * pixel) {
+         printf("tex_file: %s has %u bytes for the %ux%u mip level %u\n", path, size, w, hh, i);
+         return EINA_FALSE;
+      }
+      file->level[i] = p + off;
+      file->level_size[i] = size;
+      off += (size + 3) & ~3u;
+      w = w > 1 ? w / 2 : 1;
+      hh = hh > 1 ? hh / 2 : 1;
+   }
+   if (i < h->levels) {
+      printf("tex_file: %s is truncated at mip level %u\n", path, i);
+      return EINA_FALSE;
+   }
+
+   file->header = h;
+   return EINA_TRUE;
+}
+
+Tex_File *
+tex_file_open(const char *path)
+{
+   Tex_File *file;
+   struct stat st;
+   int fd;
+
+   fd = open(path, O_RDONLY);
+   if (fd < 0) {
+      printf("tex_file: cannot open %s\n", path);
+      return NULL;
+   }
+   if (fstat(fd, &st) < 0) {
+      close(fd);
+      return NULL;
+   }
+
+   file = calloc(1, sizeof(Tex_File));
+   if (!file) {
+      close(fd);
+      return NULL;
+   }
+
+   file->map_size = st.st_size;
+   file->map = mmap(NULL, file->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (file->map == MAP_FAILED) {
+      printf("tex_file: cannot map %s\n", path);
+      free(file);
+      return NULL;
+   }
+
+   if (!_index(file, path)) {
+      tex_file_close(file);
+      return NULL;
+   }
+
+   return file;
+}
+
+void
+tex_file_close(Tex_File *file)
+{
+   if (!file)
+      return;
+
+   munmap(file->map, file->map_size);
+   free(file);
+}
+
+/* Uploads every level into a new texture, left bound to GL_TEXTURE_2D. */
+GLuint
+tex_file_upload(const Tex_File *file, Evas_GL_API *gl)
+{
+   const Tex_File_Header *h = file->header;
+   GLuint tex;
+   uint32_t i, w, hh;
+
+   gl->glGenTextures(1, &tex);
+   gl->glBindTexture(GL_TEXTURE_2D, tex);
+   gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+   w = h->width;
+   hh = h->height;
+   for (i = 0; i < h->levels; i++) {
+      if (!h->gl_type)
+         gl->glCompressedTexImage2D(GL_TEXTURE_2D, i, h->gl_internal_format, w, hh, 0,
+                                    file->level_size[i], file->level[i]);
+      else
+         gl->glTexImage2D(GL_TEXTURE_2D, i, h->gl_internal_format, w, hh, 0,
+                          h->gl_format, h->gl_type, file->level[i]);
+      w = w > 1 ? w / 2 : 1;
+      hh = hh > 1 ? hh / 2 : 1;
+   }
+
+   gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                       h->levels > 1 ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR);
+   gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+   gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+   return tex;
+}
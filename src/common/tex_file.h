@@ -0,0 +1,58 @@
+#ifndef TEX_FILE_H
+#define TEX_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Eina.h>
+#include <Evas_GL.h>
+
+/*
+ * Texture container, read through mmap().
+ *
+ * Laid out like KTX: a fixed header naming the GL format, type and size,
+ * then each mip level as a 32 bit byte count followed by the level data,
+ * padded to 4 bytes.  Uncompressed levels hold tightly packed rows, and
+ * files with a level shorter than width x height pixels of its format
+ * and type, or with a format and type the loader does not know, are
+ * rejected: GL would read past the level.  A type of 0 marks compressed
+ * levels, uploaded with glCompressedTexImage2D() using the internal
+ * format and the level's byte count.  All fields are in the writer's byte
+ * order; files whose endianness field does not read back as
+ * TEX_FILE_ENDIANNESS are rejected rather than swapped.
+ *
+ * The loader only indexes the mapping: level data is handed to GL, and to
+ * callers, straight from the mapped pages.
+ */
+#define TEX_FILE_MAGIC      "ETEX0001"
+#define TEX_FILE_ENDIANNESS 0x04030201
+#define TEX_FILE_MAX_LEVELS 16
+
+typedef struct _Tex_File_Header Tex_File_Header;
+typedef struct _Tex_File Tex_File;
+
+struct _Tex_File_Header {
+   char     magic[8];
+   uint32_t endianness;
+   uint32_t gl_type;
+   uint32_t gl_format;
+   uint32_t gl_internal_format;
+   uint32_t width;
+   uint32_t height;
+   uint32_t levels;
+   uint32_t reserved;
+};
+
+struct _Tex_File {
+   const Tex_File_Header *header;
+   const void *level[TEX_FILE_MAX_LEVELS];
+   uint32_t level_size[TEX_FILE_MAX_LEVELS];
+
+   void *map;
+   size_t map_size;
+};
+
+Tex_File *tex_file_open(const char *path);
+void      tex_file_close(Tex_File *file);
+GLuint    tex_file_upload(const Tex_File *file, Evas_GL_API *gl);
+
+#endif
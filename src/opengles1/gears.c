@@ -28,21 +28,18 @@
 #include <assert.h>
 #include <Elementary.h>
 #include <Evas_GL.h>
-
-#define EVAS_GL_API_USE(gl) \
-   Evas_GL_API *__evas_gl_glapi = evas_gl_context_api_get(gl, evas_gl_context);
-
-Evas_GL *evas_gl;
-Evas_GL_Surface *evas_gl_surface;
-Evas_GL_Context *evas_gl_context;
+#include "bench.h"
+#include "frame_stats.h"
+#include "gl_profile.h"
+#include "gl_redundant.h"
+#include "gl_trace.h"
+#include "golden.h"
+#include "perf_counters.h"
 
 static int WinWidth = 300, WinHeight = 300;
 
-typedef struct appdata {
-   const char *name;
-
-   Evas_Object *win;
-} appdata_s;
+/* BENCH_SIZE, INSTANCES and DIRECT, see bench.h */
+static Eina_Bool direct = EINA_TRUE;
 
 #ifndef M_PI
 #define M_PI 3.14159265
@@ -57,14 +54,43 @@ struct gear {
    GLint num_teeth;
 };
 
-static GLfloat view_rotx = 20.0, view_roty = 30.0, view_rotz = 0.0;
-static struct gear gears[3];
-static GLfloat angle = 0.0;
+/* One gears scene with its own window and Evas GL context */
+typedef struct appdata {
+   const char *name;
+   int id;
+
+   Evas_Object *win;
+
+   Evas_GL *evas_gl;
+   Evas_GL_Surface *evas_gl_surface;
+   Evas_GL_Context *evas_gl_context;
+
+   /* API table of evas_gl_context, looked up once when the context is
+    * created and passed down to the helpers.  GL_PROFILE, GL_TRACE and
+    * GL_REDUNDANT wrap it, see gl_profile.h, gl_trace.h and gl_redundant.h.
+    */
+   Evas_GL_API *glapi;
+
+   GLfloat view_rotx, view_roty, view_rotz;
+   struct gear gears[3];
+   GLfloat angle;
+   double t0;
+   int frame;
+
+   /* GOLDEN=record|check, BENCH_FRAMES, BENCH_API_LOOKUP, FRAME_STATS and
+    * PERF_COUNTERS, see golden.h, bench.h, frame_stats.h and
+    * perf_counters.h; the first instance only */
+   Golden *golden;
+   Bench *bench;
+   Frame_Stats *frame_stats;
+   Perf_Counters *perf_counters;
+} appdata_s;
 
 /*
  *  Initialize a gear wheel.
  *
- *  Input:  gear - gear to initialize
+ *  Input:  api - GL API table of the current context
+ *          gear - gear to initialize
  *          inner_radius - radius of hole at center
  *          outer_radius - radius at center of teeth
  *          width - width of gear
@@ -72,10 +98,10 @@ static GLfloat angle = 0.0;
  *          tooth_depth - depth of tooth
  */
 static void
-init_gear(struct gear *gear, GLfloat inner_radius, GLfloat outer_radius,
+init_gear(Evas_GL_API *api, struct gear *gear,
+          GLfloat inner_radius, GLfloat outer_radius,
           GLfloat width, GLint teeth, GLfloat tooth_depth)
 {
-   EVAS_GL_API_USE(evas_gl);
    GLfloat r0, r1, r2;
    GLfloat a0, da;
    GLint verts_per_tooth, total_verts, total_size;
@@ -185,18 +211,17 @@ init_gear(struct gear *gear, GLfloat inner_radius, GLfloat outer_radius,
    gear->vertices = verts;
 
    /* setup VBO */
-   __evas_gl_glapi->glGenBuffers(1, &gear->vbo);
+   api->glGenBuffers(1, &gear->vbo);
    if (gear->vbo) {
-      __evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, gear->vbo);
-      __evas_gl_glapi->glBufferData(GL_ARRAY_BUFFER, total_size, verts, GL_STATIC_DRAW);
+      api->glBindBuffer(GL_ARRAY_BUFFER, gear->vbo);
+      api->glBufferData(GL_ARRAY_BUFFER, total_size, verts, GL_STATIC_DRAW);
    }
 }
 
 
 static void
-draw_gear(const struct gear *gear)
+draw_gear(Evas_GL_API *api, const struct gear *gear)
 {
-   EVAS_GL_API_USE(evas_gl);
    GLint i;
 
    if (!gear->vbo && !gear->vertices) {
@@ -205,22 +230,22 @@ draw_gear(const struct gear *gear)
    }
 
    if (gear->vbo) {
-      __evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, gear->vbo);
-      __evas_gl_glapi->glVertexPointer(3, GL_FLOAT, gear->stride, (const GLvoid *) 0);
-      __evas_gl_glapi->glNormalPointer(GL_FLOAT, gear->stride, (const GLvoid *) (sizeof(GLfloat) * 3));
+      api->glBindBuffer(GL_ARRAY_BUFFER, gear->vbo);
+      api->glVertexPointer(3, GL_FLOAT, gear->stride, (const GLvoid *) 0);
+      api->glNormalPointer(GL_FLOAT, gear->stride, (const GLvoid *) (sizeof(GLfloat) * 3));
    } else {
-      __evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, 0);
-      __evas_gl_glapi->glVertexPointer(3, GL_FLOAT, gear->stride, gear->vertices);
-      __evas_gl_glapi->glNormalPointer(GL_FLOAT, gear->stride, gear->vertices + 3);
+      api->glBindBuffer(GL_ARRAY_BUFFER, 0);
+      api->glVertexPointer(3, GL_FLOAT, gear->stride, gear->vertices);
+      api->glNormalPointer(GL_FLOAT, gear->stride, gear->vertices + 3);
    }
 
-   __evas_gl_glapi->glEnableClientState(GL_VERTEX_ARRAY);
+   api->glEnableClientState(GL_VERTEX_ARRAY);
 
    for (i = 0; i < gear->num_teeth; i++) {
       const GLint base = (10 + 4) * i;
       GLushort indices[7];
 
-      __evas_gl_glapi->glShadeModel(GL_FLAT);
+      api->glShadeModel(GL_FLAT);
 
       /* front face */
       indices[0] = base + 12;
@@ -231,8 +256,8 @@ draw_gear(const struct gear *gear)
       indices[5] = base +  8;
       indices[6] = base + 10;
 
-      __evas_gl_glapi->glNormal3f(0.0, 0.0, 1.0);
-      __evas_gl_glapi->glDrawElements(GL_TRIANGLE_FAN, 7, GL_UNSIGNED_SHORT, indices);
+      api->glNormal3f(0.0, 0.0, 1.0);
+      api->glDrawElements(GL_TRIANGLE_FAN, 7, GL_UNSIGNED_SHORT, indices);
 
       /* back face */
       indices[0] = base + 13;
@@ -243,80 +268,80 @@ draw_gear(const struct gear *gear)
       indices[5] = base +  3;
       indices[6] = base +  1;
 
-      __evas_gl_glapi->glNormal3f(0.0, 0.0, -1.0);
-      __evas_gl_glapi->glDrawElements(GL_TRIANGLE_FAN, 7, GL_UNSIGNED_SHORT, indices);
+      api->glNormal3f(0.0, 0.0, -1.0);
+      api->glDrawElements(GL_TRIANGLE_FAN, 7, GL_UNSIGNED_SHORT, indices);
 
-      __evas_gl_glapi->glEnableClientState(GL_NORMAL_ARRAY);
+      api->glEnableClientState(GL_NORMAL_ARRAY);
 
       /* outward face of a tooth */
-      __evas_gl_glapi->glDrawArrays(GL_TRIANGLE_STRIP, base, 10);
+      api->glDrawArrays(GL_TRIANGLE_STRIP, base, 10);
 
       /* inside radius cylinder */
-      __evas_gl_glapi->glShadeModel(GL_SMOOTH);
-      __evas_gl_glapi->glDrawArrays(GL_TRIANGLE_STRIP, base + 10, 4);
+      api->glShadeModel(GL_SMOOTH);
+      api->glDrawArrays(GL_TRIANGLE_STRIP, base + 10, 4);
 
-      __evas_gl_glapi->glDisableClientState(GL_NORMAL_ARRAY);
+      api->glDisableClientState(GL_NORMAL_ARRAY);
    }
 
-   __evas_gl_glapi->glDisableClientState(GL_VERTEX_ARRAY);
+   api->glDisableClientState(GL_VERTEX_ARRAY);
 }
 
 
 static void
-gears_draw(void)
+gears_draw(appdata_s *ad)
 {
-   EVAS_GL_API_USE(evas_gl);
+   Evas_GL_API *api = ad->glapi;
    static const GLfloat red[4] = { 0.8, 0.1, 0.0, 1.0 };
    static const GLfloat green[4] = { 0.0, 0.8, 0.2, 1.0 };
    static const GLfloat blue[4] = { 0.2, 0.2, 1.0, 1.0 };
 
-   __evas_gl_glapi->glClearColor(0,0,0,1);
-   __evas_gl_glapi->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+   api->glClearColor(0,0,0,1);
+   api->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-   __evas_gl_glapi->glPushMatrix();
-   __evas_gl_glapi->glRotatef(view_rotx, 1.0, 0.0, 0.0);
-   __evas_gl_glapi->glRotatef(view_roty, 0.0, 1.0, 0.0);
-   __evas_gl_glapi->glRotatef(view_rotz, 0.0, 0.0, 1.0);
+   api->glPushMatrix();
+   api->glRotatef(ad->view_rotx, 1.0, 0.0, 0.0);
+   api->glRotatef(ad->view_roty, 0.0, 1.0, 0.0);
+   api->glRotatef(ad->view_rotz, 0.0, 0.0, 1.0);
 
-   __evas_gl_glapi->glPushMatrix();
-   __evas_gl_glapi->glTranslatef(-3.0, -2.0, 0.0);
-   __evas_gl_glapi->glRotatef(angle, 0.0, 0.0, 1.0);
+   api->glPushMatrix();
+   api->glTranslatef(-3.0, -2.0, 0.0);
+   api->glRotatef(ad->angle, 0.0, 0.0, 1.0);
 
-   __evas_gl_glapi->glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, red);
-   draw_gear(&gears[0]);
+   api->glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, red);
+   draw_gear(api, &ad->gears[0]);
 
-   __evas_gl_glapi->glPopMatrix();
+   api->glPopMatrix();
 
-   __evas_gl_glapi->glPushMatrix();
-   __evas_gl_glapi->glTranslatef(3.1, -2.0, 0.0);
-   __evas_gl_glapi->glRotatef(-2.0 * angle - 9.0, 0.0, 0.0, 1.0);
+   api->glPushMatrix();
+   api->glTranslatef(3.1, -2.0, 0.0);
+   api->glRotatef(-2.0 * ad->angle - 9.0, 0.0, 0.0, 1.0);
 
-   __evas_gl_glapi->glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, green);
-   draw_gear(&gears[1]);
+   api->glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, green);
+   draw_gear(api, &ad->gears[1]);
 
-   __evas_gl_glapi->glPopMatrix();
+   api->glPopMatrix();
 
-   __evas_gl_glapi->glPushMatrix();
-   __evas_gl_glapi->glTranslatef(-3.1, 4.2, 0.0);
-   __evas_gl_glapi->glRotatef(-2.0 * angle - 25.0, 0.0, 0.0, 1.0);
+   api->glPushMatrix();
+   api->glTranslatef(-3.1, 4.2, 0.0);
+   api->glRotatef(-2.0 * ad->angle - 25.0, 0.0, 0.0, 1.0);
 
-   __evas_gl_glapi->glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, blue);
-   draw_gear(&gears[2]);
+   api->glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, blue);
+   draw_gear(api, &ad->gears[2]);
 
-   __evas_gl_glapi->glPopMatrix();
+   api->glPopMatrix();
 
-   __evas_gl_glapi->glPopMatrix();
+   api->glPopMatrix();
 }
 
 
-static void gears_fini(void)
+static void gears_fini(appdata_s *ad)
 {
-   EVAS_GL_API_USE(evas_gl);
+   Evas_GL_API *api = ad->glapi;
    GLint i;
    for (i = 0; i < 3; i++) {
-      struct gear *gear = &gears[i];
+      struct gear *gear = &ad->gears[i];
       if (gear->vbo) {
-         __evas_gl_glapi->glDeleteBuffers(1, &gear->vbo);
+         api->glDeleteBuffers(1, &gear->vbo);
          gear->vbo = 0;
       }
       if (gear->vertices) {
@@ -327,75 +352,87 @@ static void gears_fini(void)
 }
 
 
-static void gears_init(void)
+static void gears_init(appdata_s *ad)
 {
-   EVAS_GL_API_USE(evas_gl);
+   Evas_GL_API *api = ad->glapi;
    static const GLfloat pos[4] = { 5.0, 5.0, 10.0, 0.0 };
 
-   __evas_gl_glapi->glLightfv(GL_LIGHT0, GL_POSITION, pos);
-   __evas_gl_glapi->glEnable(GL_CULL_FACE);
-   __evas_gl_glapi->glEnable(GL_LIGHTING);
-   __evas_gl_glapi->glEnable(GL_LIGHT0);
-   __evas_gl_glapi->glEnable(GL_DEPTH_TEST);
-   __evas_gl_glapi->glEnable(GL_NORMALIZE);
+   api->glLightfv(GL_LIGHT0, GL_POSITION, pos);
+   api->glEnable(GL_CULL_FACE);
+   api->glEnable(GL_LIGHTING);
+   api->glEnable(GL_LIGHT0);
+   api->glEnable(GL_DEPTH_TEST);
+   api->glEnable(GL_NORMALIZE);
 
-   init_gear(&gears[0], 1.0, 4.0, 1.0, 20, 0.7);
-   init_gear(&gears[1], 0.5, 2.0, 2.0, 10, 0.7);
-   init_gear(&gears[2], 1.3, 2.0, 0.5, 10, 0.7);
+   init_gear(api, &ad->gears[0], 1.0, 4.0, 1.0, 20, 0.7);
+   init_gear(api, &ad->gears[1], 0.5, 2.0, 2.0, 10, 0.7);
+   init_gear(api, &ad->gears[2], 1.3, 2.0, 0.5, 10, 0.7);
 }
 
 
 /* new window size or exposure */
 static void
-gears_reshape(int width, int height)
+gears_reshape(Evas_GL_API *api, int width, int height)
 {
-   EVAS_GL_API_USE(evas_gl);
    GLfloat h = (GLfloat) height / (GLfloat) width;
 
-   __evas_gl_glapi->glViewport(0, 0, (GLint) width, (GLint) height);
+   api->glViewport(0, 0, (GLint) width, (GLint) height);
 
-   __evas_gl_glapi->glMatrixMode(GL_PROJECTION);
-   __evas_gl_glapi->glLoadIdentity();
-   __evas_gl_glapi->glFrustumf(-1.0, 1.0, -h, h, 5.0, 60.0);
+   api->glMatrixMode(GL_PROJECTION);
+   api->glLoadIdentity();
+   api->glFrustumf(-1.0, 1.0, -h, h, 5.0, 60.0);
 
-   __evas_gl_glapi->glMatrixMode(GL_MODELVIEW);
-   __evas_gl_glapi->glLoadIdentity();
-   __evas_gl_glapi->glTranslatef(0.0, 0.0, -40.0);
+   api->glMatrixMode(GL_MODELVIEW);
+   api->glLoadIdentity();
+   api->glTranslatef(0.0, 0.0, -40.0);
 }
 
 
 static void
-gears_idle(void)
+gears_idle(appdata_s *ad)
 {
-  static double t0 = -1.;
-  static int frame = 0;
-  double dt, t = frame / 1000.0;
-  if (t0 < 0.0)
-    t0 = t;
-  dt = t - t0;
-  t0 = t;
-
-  angle += 70.0 * dt;  /* 70 degrees per second */
-  angle = fmod(angle, 360.0); /* prevents eventual overflow */
-  frame+=10;
+  double dt, t = ad->frame * 10 / 1000.0;
+  if (ad->t0 < 0.0)
+    ad->t0 = t;
+  dt = t - ad->t0;
+  ad->t0 = t;
+
+  ad->angle += 70.0 * dt;  /* 70 degrees per second */
+  ad->angle = fmod(ad->angle, 360.0); /* prevents eventual overflow */
 }
 
 void on_pixels(void *data, Evas_Object *o)
 {
-   static int frame = 0;   
+   appdata_s *ad = data;
+   Evas_GL_API *api = ad->glapi;
 
-   evas_gl_make_current(evas_gl, evas_gl_surface, evas_gl_context);
+   frame_stats_frame(ad->frame_stats);
+   bench_draw_begin(ad->bench);
+   perf_counters_begin(ad->perf_counters);
+   evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context);
 
-   if (frame == 0)
+   if (ad->frame == 0)
    {
-      gears_init();
-      gears_reshape(WinWidth, WinHeight);
+      gears_init(ad);
+      gears_reshape(api, WinWidth, WinHeight);
    }
 
-   gears_idle();
-   gears_draw();
+   gears_idle(ad);
+   gears_draw(ad);
+   perf_counters_end(ad->perf_counters);
+
+   if (!golden_frame(ad->golden, api, WinWidth, WinHeight))
+      elm_exit();
+   /* the GL wrappers count frames of the whole process */
+   if (ad->id == 0) {
+      gl_profile_frame();
+      gl_trace_frame();
+      gl_redundant_frame();
+   }
+   if (!bench_draw_end(ad->bench))
+      elm_exit();
 
-   frame++;
+   ad->frame++;
 }
 
 static Eina_Bool anim(void *data) {
@@ -412,11 +449,13 @@ static void del_anim(void *data, Evas *evas, Evas_Object *obj, void *event_info)
 static void
 _win_resize_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *obj, void *event_info EINA_UNUSED)
 {
+   appdata_s *ad = data;
    float aspect;
    Evas_Coord w,h;
    evas_object_geometry_get( obj, NULL, NULL, &w, &h);
 
-   gears_reshape(w, h);
+   evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context);
+   gears_reshape(ad->glapi, w, h);
 }
 
 static Evas_Object* add_win(const char *name) {
@@ -470,20 +509,26 @@ static Eina_Bool app_create(void *data) {
    evas_object_resize(gl, WinWidth, WinHeight);
    evas_object_show(gl);
 
-   evas_gl = evas_gl_new(e);
+   ad->view_rotx = 20.0;
+   ad->view_roty = 30.0;
+   ad->view_rotz = 0.0;
+   ad->t0 = -1.0;
+
+   ad->evas_gl = evas_gl_new(e);
    evas_gl_config = evas_gl_config_new();
    evas_gl_config->color_format = EVAS_GL_RGBA_8888;
    evas_gl_config->depth_bits = EVAS_GL_DEPTH_BIT_8;
    evas_gl_config->stencil_bits = EVAS_GL_STENCIL_NONE;
-   evas_gl_config->options_bits = EVAS_GL_OPTIONS_DIRECT;
-   evas_gl_surface = evas_gl_surface_create(evas_gl, evas_gl_config, WinWidth, WinHeight);
-   evas_gl_context = evas_gl_context_version_create(evas_gl, NULL, EVAS_GL_GLES_1_X);
+   evas_gl_config->options_bits = direct ? EVAS_GL_OPTIONS_DIRECT : EVAS_GL_OPTIONS_NONE;
+   ad->evas_gl_surface = evas_gl_surface_create(ad->evas_gl, evas_gl_config, WinWidth, WinHeight);
+   ad->evas_gl_context = evas_gl_context_version_create(ad->evas_gl, NULL, EVAS_GL_GLES_1_X);
    evas_gl_config_free(evas_gl_config);
+   ad->glapi = gl_redundant_api(gl_profile_api(gl_trace_api(evas_gl_context_api_get(ad->evas_gl, ad->evas_gl_context))));
 
    Evas_Native_Surface ns;
-   evas_gl_native_surface_get(evas_gl, evas_gl_surface, &ns);
+   evas_gl_native_surface_get(ad->evas_gl, ad->evas_gl_surface, &ns);
    evas_object_image_native_surface_set(gl, &ns);
-   evas_object_image_pixels_get_callback_set(gl, on_pixels, NULL);
+   evas_object_image_pixels_get_callback_set(gl, on_pixels, ad);
 
    evas_object_show(gl);
 
@@ -497,7 +542,7 @@ static Eina_Bool app_create(void *data) {
    evas_object_data_set(gl, "ani", ani);
    evas_object_data_set(gl, "ad", ad);
    evas_object_event_callback_add(gl, EVAS_CALLBACK_DEL, del_anim, gl);
-   evas_object_event_callback_add(gl, EVAS_CALLBACK_RESIZE, _win_resize_cb, NULL);
+   evas_object_event_callback_add(gl, EVAS_CALLBACK_RESIZE, _win_resize_cb, ad);
 
    evas_object_show(ad->win);
 
@@ -508,11 +553,35 @@ static Eina_Bool app_create(void *data) {
 EAPI_MAIN int
 elm_main(int argc, char **argv)
 {
-   appdata_s ad = {0,};
-   app_create(&ad);
+   appdata_s *ads, *ad;
+   int i, n, status;
+
+   bench_size(&WinWidth, &WinHeight);
+   direct = bench_direct(EINA_TRUE);
+   n = bench_instances();
+
+   ads = calloc(n, sizeof(appdata_s));
+   if (!ads)
+      return 1;
+
+   ad = &ads[0];
+   ad->golden = golden_new("gears");
+   for (i = 0; i < n; i++) {
+      ads[i].id = i;
+      app_create(&ads[i]);
+   }
+   bench_api_lookup("gears", ad->evas_gl, ad->evas_gl_context, ad->glapi);
+   ad->bench = bench_new("gears", ad->win, direct);
+   ad->frame_stats = frame_stats_new("gears");
+   ad->perf_counters = perf_counters_new("gears");
 
    elm_run();
+   perf_counters_free(ad->perf_counters);
+   frame_stats_free(ad->frame_stats);
+   bench_finish(ad->bench);
+   status = golden_finish(ad->golden);
+   free(ads);
    elm_shutdown();
-   return 0;
+   return status;
 }
 ELM_MAIN()
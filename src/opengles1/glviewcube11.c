@@ -15,8 +15,22 @@
  */
 
 #include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <Evas_GL.h>
 #include <Elementary.h>
+#include "bench.h"
+#include "frame_stats.h"
+#include "gl_profile.h"
+#include "gl_redundant.h"
+#include "gl_trace.h"
+#include "golden.h"
+#include "pacing.h"
+#include "perf_counters.h"
+#include "tex_atlas.h"
+#include "tex_file.h"
 
 #define APPDATA_KEY "AppData"
 
@@ -24,11 +38,19 @@
 #define ONEN  -1.0
 #define ZERO   0.0
 
+/* GL_PROFILE, GL_TRACE and GL_REDUNDANT, see gl_profile.h, gl_trace.h
+ * and gl_redundant.h */
 #define ELEMENTARY_GLVIEW_USE(glview) \
-   Evas_GL_API *__evas_gl_glapi = elm_glview_gl_api_get(glview);
+   Evas_GL_API *__evas_gl_glapi = \
+      gl_redundant_api(gl_profile_api(gl_trace_api(elm_glview_gl_api_get(glview))));
 
 #define Z_POS_INC 0.01f
 
+/* counts the GL calls issued to draw the cubes */
+#define GL_CALL(fn) (gl_calls++, __evas_gl_glapi->fn)
+
+#define STATS_FRAMES 300
+
 #define S(a) evas_object_show(a)
 
 #define SX(a) do { \
@@ -43,6 +65,22 @@
    evas_object_show(a); \
    } while (0)
 
+/*
+ * Last fixed function state and projection sent to the context, so that
+ * draw_gl() only issues what changed.  Fields are ~0 when unknown, as
+ * after init_gles() on a new context.
+ */
+typedef struct
+{
+   unsigned shade_model;
+   unsigned cull_face_enabled, cull_face;
+   unsigned depth_test_enabled, depth_func;
+   int w, h;
+   float fov, znear, zfar;
+
+   unsigned long applied, skipped;   /* GL calls */
+} Gl_State;
+
 struct _appdata_s
 {
    Evas_Object *table, *bg, *img;
@@ -53,11 +91,176 @@ struct _appdata_s
 
    GLuint tex_ids[2];
    int current_tex_index;
+
+   /* both images packed in one texture, selected by texture coordinates
+    * remapped into each image's region; with batch they follow the cube2
+    * vertices in its buffer */
+   GLuint atlas_tex;
+   float atlas_uv[2][24 * 2];
+   Eina_Bool atlas;
+   int cube_count;        /* textured cubes, in a grid when more than 1 */
+
+   /* cube1 and cube2 as indexed triangle lists in buffer objects */
+   GLuint vbo[2], ibo[2];
+   Eina_Bool batch;       /* draw from the buffers, not client arrays */
+   Eina_Bool compare;     /* switch between both every STATS_FRAMES */
+
+   /* per STATS_FRAMES */
+   int frames;
+   unsigned long calls;
+   double submit;
+   unsigned long state_applied, state_skipped;
+   double state;
+
+   /* position in the GRID, 0 when there is a single view */
+   int index;
+   int angle1, angle2;
+   float zpos, zpos_inc;
+   Gl_State tracker;
 };
 typedef struct _appdata_s appdata_s;
 
+/* cube1 vertex: x y z r g b a */
+typedef struct
+{
+   float pos[3];
+   float color[4];
+} Color_Vertex;
+
+/* cube2 vertex: x y z s t */
+typedef struct
+{
+   float pos[3];
+   float uv[2];
+} Tex_Vertex;
+
+/*
+ * GRID=<cols>x<rows> stress mode: one glview per cell, each with its own
+ * context, animator and copy of the app data.  Every 2 s it prints how
+ * the canvas render time splits between the views' draw_gl() and the
+ * rest, composition mostly.
+ */
+typedef struct
+{
+   int cols, rows;
+   Ecore_Timer *timer;
+
+   /* since the last report */
+   double since;
+   int renders, draws;
+   double render_start, render, draw;
+} Grid_Stats;
+
+static Grid_Stats grid = { 1, 1, NULL, 0.0, 0, 0, 0.0, 0.0, 0.0 };
+
+/* GOLDEN=record|check, see golden.h */
+static Golden *golden = NULL;
+
+/* BENCH_FRAMES, BENCH_SIZE and DIRECT, see bench.h; the first view
+ * paces the benchmark */
+static Bench *bench = NULL;
+static Eina_Bool direct = EINA_FALSE;
+static int WinWidth = 320, WinHeight = 480;
+
+/* PACING and RENDER_POLICY, see pacing.h; taken on the first view */
+static Pacing *pacing = NULL;
+static Elm_GLView_Render_Policy render_policy = ELM_GLVIEW_RENDER_POLICY_ON_DEMAND;
+
+/* FRAME_STATS, see frame_stats.h; the first view too */
+static Frame_Stats *frame_stats = NULL;
+
+/* PERF_COUNTERS, see perf_counters.h; also on the first view */
+static Perf_Counters *perf_counters = NULL;
+
+static unsigned long gl_calls = 0;
+
+/* STATE_TRACKING=0 sends all of it every frame.  gl_state is the
+ * tracker of the view whose callback runs, see view_get(). */
+static Gl_State *gl_state = NULL;
+static Eina_Bool state_tracking = EINA_TRUE;
+
+static const float CUBE1_VERTICES[] =
+{
+   ONEN, ONEP, ONEN, // 0
+   ONEP, ONEP, ONEN, // 1
+   ONEN, ONEN, ONEN, // 2
+   ONEP, ONEN, ONEN, // 3
+   ONEN, ONEP, ONEP, // 4
+   ONEP, ONEP, ONEP, // 5
+   ONEN, ONEN, ONEP, // 6
+   ONEP, ONEN, ONEP  // 7
+};
+
+static const float CUBE1_COLORS[] =
+{
+   ONEP, ZERO, ONEP, ONEP,
+   ONEP, ONEP, ZERO, ONEP,
+   ZERO, ONEP, ONEP, ONEP,
+   ONEP, ZERO, ZERO, ONEP,
+   ZERO, ZERO, ONEP, ONEP,
+   ZERO, ONEP, ZERO, ONEP,
+   ONEP, ONEP, ONEP, ONEP,
+   ZERO, ZERO, ZERO, ONEP
+};
+
+static const unsigned short CUBE1_INDICES[] =
+{
+   0, 1, 2, 2, 1, 3,
+   1, 5, 3, 3, 5, 7,
+   5, 4, 7, 7, 4, 6,
+   4, 0, 6, 6, 0, 2,
+   4, 5, 0, 0, 5, 1,
+   2, 3, 6, 6, 3, 7
+};
+
+/* six faces, one 4 vertex triangle strip each */
+static const float CUBE2_VERTICES[] =
+{
+   ONEN, ONEN, ONEP, ONEP, ONEN, ONEP, ONEN, ONEP, ONEP, ONEP, ONEP, ONEP,
+   ONEN, ONEN, ONEN, ONEN, ONEP, ONEN, ONEP, ONEN, ONEN, ONEP, ONEP, ONEN,
+   ONEN, ONEN, ONEP, ONEN, ONEP, ONEP, ONEN, ONEN, ONEN, ONEN, ONEP, ONEN,
+   ONEP, ONEN, ONEN, ONEP, ONEP, ONEN, ONEP, ONEN, ONEP, ONEP, ONEP, ONEP,
+   ONEN, ONEP, ONEP, ONEP, ONEP, ONEP, ONEN, ONEP, ONEN, ONEP, ONEP, ONEN,
+   ONEN, ONEN, ONEP, ONEN, ONEN, ONEN, ONEP, ONEN, ONEP, ONEP, ONEN, ONEN
+};
+
+static const float CUBE2_TEXTURE_COORD[] =
+{
+   ONEP, ZERO, ZERO, ZERO, ONEP, ONEP, ZERO, ONEP,
+   ONEP, ZERO, ZERO, ZERO, ONEP, ONEP, ZERO, ONEP,
+   ONEP, ZERO, ZERO, ZERO, ONEP, ONEP, ZERO, ONEP,
+   ONEP, ZERO, ZERO, ZERO, ONEP, ONEP, ZERO, ONEP,
+   ONEP, ZERO, ZERO, ZERO, ONEP, ONEP, ZERO, ONEP,
+   ONEP, ZERO, ZERO, ZERO, ONEP, ONEP, ZERO, ONEP
+};
+
+/* Texture images: the 4444 one, then the 565 one.  They are mapped from
+ * tex_file containers written by texconv at build time, found in the
+ * TEXTURE_DIR environment variable when set, else in TEXTURE_DIR where
+ * they are installed, then in TEXTURE_BUILD_DIR so an uninstalled binary
+ * runs from the build tree; or they are compiled in when built with
+ * EMBEDDED_TEXTURES. */
+#ifdef EMBEDDED_TEXTURES
 extern const unsigned short IMAGE_565_128_128_1[];
 extern const unsigned short IMAGE_4444_128_128_1[];
+#else
+#ifndef TEXTURE_DIR
+#define TEXTURE_DIR "."
+#endif
+#ifndef TEXTURE_BUILD_DIR
+#define TEXTURE_BUILD_DIR "."
+#endif
+static const char *TEXTURE_FILES[2] = { "image_4444.etex", "image_565.etex" };
+#endif
+
+typedef struct
+{
+   const void *pixels;   /* level 0, NULL when the atlas cannot take it */
+   int w, h;
+   Tex_Atlas_Format format;
+} Image;
+
+static double startup_time = 0.0;
 
 static void
 set_perspective(Evas_Object *obj, float fovDegree, int w, int h, float zNear,  float zFar)
@@ -103,16 +306,28 @@ set_perspective(Evas_Object *obj, float fovDegree, int w, int h, float zNear,  f
    __evas_gl_glapi->glFrustumf(fxdXMin, fxdXMax, fxdYMin, fxdYMax, zNear, zFar);
 }
 
-void
-init_gles(Evas_Object *obj)
+static long
+rss_kb(void)
+{
+   long pages = 0;
+   FILE *f;
+
+   f = fopen("/proc/self/statm", "r");
+   if (!f)
+      return -1;
+   if (fscanf(f, "%*s %ld", &pages) != 1)
+      pages = -1;
+   fclose(f);
+
+   return pages < 0 ? -1 : pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+#ifdef EMBEDDED_TEXTURES
+static Eina_Bool
+init_textures(Evas_Object *obj, appdata_s *ad, Image images[2])
 {
-   int w, h;
-   appdata_s *ad;
-printf("%s\n", __func__);
    ELEMENTARY_GLVIEW_USE(obj);
-   ad = evas_object_data_get(obj, APPDATA_KEY);
 
-   fprintf(stderr, "Extension: %s\n", evas_gl_string_query(elm_glview_evas_gl_get(obj), EVAS_GL_EXTENSIONS));
    __evas_gl_glapi->glGenTextures(2, ad->tex_ids);
 
    /* Create and map texture 1 */
@@ -131,18 +346,290 @@ printf("%s\n", __func__);
    __evas_gl_glapi->glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
    __evas_gl_glapi->glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
+   images[0].pixels = IMAGE_4444_128_128_1;
+   images[0].format = TEX_ATLAS_RGBA_4444;
+   images[1].pixels = IMAGE_565_128_128_1;
+   images[1].format = TEX_ATLAS_RGB_565;
+   images[0].w = images[0].h = images[1].w = images[1].h = 128;
+
+   return EINA_TRUE;
+}
+#else
+/* The files stay mapped until init_gles() is done with them. */
+static Eina_Bool
+init_textures(Evas_Object *obj, appdata_s *ad, Image images[2], Tex_File *files[2])
+{
+   const char *dirs[2] = { TEXTURE_DIR, TEXTURE_BUILD_DIR };
+   char path[4096];
+   int i, d, ndirs = 2;
+
+   ELEMENTARY_GLVIEW_USE(obj);
+
+   if (getenv("TEXTURE_DIR")) {
+      dirs[0] = getenv("TEXTURE_DIR");
+      ndirs = 1;
+   }
+
+   /* both files from the same directory */
+   for (d = 0; d < ndirs; d++) {
+      for (i = 0; i < 2; i++) {
+         snprintf(path, sizeof(path), "%s/%s", dirs[d], TEXTURE_FILES[i]);
+         files[i] = tex_file_open(path);
+         if (!files[i])
+            break;
+      }
+      if (i == 2)
+         break;
+      if (i == 1)
+         tex_file_close(files[0]);
+      files[0] = files[1] = NULL;
+   }
+   if (d == ndirs)
+      return EINA_FALSE;
+
+   for (i = 0; i < 2; i++) {
+      const Tex_File_Header *h;
+
+      /* straight from the mapping */
+      ad->tex_ids[i] = tex_file_upload(files[i], __evas_gl_glapi);
+
+      h = files[i]->header;
+      images[i].w = h->width;
+      images[i].h = h->height;
+      images[i].pixels = files[i]->level[0];
+      if (h->gl_type == GL_UNSIGNED_SHORT_4_4_4_4)
+         images[i].format = TEX_ATLAS_RGBA_4444;
+      else if (h->gl_type == GL_UNSIGNED_SHORT_5_6_5)
+         images[i].format = TEX_ATLAS_RGB_565;
+      else if (h->gl_type == GL_UNSIGNED_BYTE && h->gl_format == GL_RGBA)
+         images[i].format = TEX_ATLAS_RGBA_8888;
+      else
+         images[i].pixels = NULL;
+   }
+
+   return EINA_TRUE;
+}
+#endif
+
+static void
+init_atlas(Evas_Object *obj, appdata_s *ad, const Image images[2])
+{
+   Tex_Atlas *atlas;
+   int r0, r1;
+
+   ELEMENTARY_GLVIEW_USE(obj);
+
+   if (!images[0].pixels || !images[1].pixels) {
+      ad->atlas = EINA_FALSE;
+      return;
+   }
+
+   /* power of two for GLES 1.1, with room for more images */
+   atlas = tex_atlas_new(512, 512);
+   if (!atlas)
+      return;
+
+   r0 = tex_atlas_add(atlas, images[0].pixels, images[0].w, images[0].h, images[0].format);
+   r1 = tex_atlas_add(atlas, images[1].pixels, images[1].w, images[1].h, images[1].format);
+   if (r0 >= 0 && r1 >= 0) {
+      tex_atlas_remap(tex_atlas_region_get(atlas, r0), CUBE2_TEXTURE_COORD, ad->atlas_uv[0], 24);
+      tex_atlas_remap(tex_atlas_region_get(atlas, r1), CUBE2_TEXTURE_COORD, ad->atlas_uv[1], 24);
+      ad->atlas_tex = tex_atlas_upload(atlas, __evas_gl_glapi);
+   }
+   tex_atlas_free(atlas);
+
+   if (!ad->atlas_tex)
+      ad->atlas = EINA_FALSE;
+}
+
+static void
+init_buffers(Evas_Object *obj, appdata_s *ad)
+{
+   Color_Vertex v1[8];
+   /* the atlas coordinates of both images after the vertices */
+   struct {
+      Tex_Vertex v[24];
+      float atlas_uv[2][24 * 2];
+   } v2;
+   unsigned short i2[36];
+   int i;
+
+   ELEMENTARY_GLVIEW_USE(obj);
+
+   for (i = 0; i < 8; i++) {
+      memcpy(v1[i].pos, &CUBE1_VERTICES[i * 3], sizeof(v1[i].pos));
+      memcpy(v1[i].color, &CUBE1_COLORS[i * 4], sizeof(v1[i].color));
+   }
+   for (i = 0; i < 24; i++) {
+      memcpy(v2.v[i].pos, &CUBE2_VERTICES[i * 3], sizeof(v2.v[i].pos));
+      memcpy(v2.v[i].uv, &CUBE2_TEXTURE_COORD[i * 2], sizeof(v2.v[i].uv));
+   }
+   memcpy(v2.atlas_uv, ad->atlas_uv, sizeof(v2.atlas_uv));
+   /* strip v0 v1 v2 v3 is the triangles v0 v1 v2 and v2 v1 v3 */
+   for (i = 0; i < 6; i++) {
+      i2[i * 6 + 0] = i * 4 + 0;
+      i2[i * 6 + 1] = i * 4 + 1;
+      i2[i * 6 + 2] = i * 4 + 2;
+      i2[i * 6 + 3] = i * 4 + 2;
+      i2[i * 6 + 4] = i * 4 + 1;
+      i2[i * 6 + 5] = i * 4 + 3;
+   }
+
+   __evas_gl_glapi->glGenBuffers(2, ad->vbo);
+   __evas_gl_glapi->glGenBuffers(2, ad->ibo);
+
+   __evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, ad->vbo[0]);
+   __evas_gl_glapi->glBufferData(GL_ARRAY_BUFFER, sizeof(v1), v1, GL_STATIC_DRAW);
+   __evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ad->ibo[0]);
+   __evas_gl_glapi->glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(CUBE1_INDICES), CUBE1_INDICES, GL_STATIC_DRAW);
+
+   __evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, ad->vbo[1]);
+   __evas_gl_glapi->glBufferData(GL_ARRAY_BUFFER, sizeof(v2), &v2, GL_STATIC_DRAW);
+   __evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ad->ibo[1]);
+   __evas_gl_glapi->glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(i2), i2, GL_STATIC_DRAW);
+
+   __evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, 0);
+   __evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+/* App data of the view obj, making its state tracker current */
+static appdata_s *
+view_get(Evas_Object *obj)
+{
+   appdata_s *ad = evas_object_data_get(obj, APPDATA_KEY);
+
+   gl_state = &ad->tracker;
+   return ad;
+}
+
+static void
+state_invalidate(void)
+{
+   memset(gl_state, 0xff, offsetof(Gl_State, applied));
+}
+
+/* Records v as the current value of *cur, returns whether the calls
+ * setting it must be issued. */
+static Eina_Bool
+state_changed(unsigned *cur, unsigned v, int calls)
+{
+   if (state_tracking && *cur == v) {
+      gl_state->skipped += calls;
+      return EINA_FALSE;
+   }
+
+   *cur = v;
+   gl_state->applied += calls;
+   return EINA_TRUE;
+}
+
+static void
+state_shade_model(Evas_GL_API *gl, GLenum mode)
+{
+   if (state_changed(&gl_state->shade_model, mode, 1))
+      gl->glShadeModel(mode);
+}
+
+static void
+state_cull_face(Evas_GL_API *gl, Eina_Bool enable, GLenum mode)
+{
+   if (state_changed(&gl_state->cull_face_enabled, enable, 1)) {
+      if (enable)
+         gl->glEnable(GL_CULL_FACE);
+      else
+         gl->glDisable(GL_CULL_FACE);
+   }
+   if (state_changed(&gl_state->cull_face, mode, 1))
+      gl->glCullFace(mode);
+}
+
+static void
+state_depth_test(Evas_GL_API *gl, Eina_Bool enable, GLenum func)
+{
+   if (state_changed(&gl_state->depth_test_enabled, enable, 1)) {
+      if (enable)
+         gl->glEnable(GL_DEPTH_TEST);
+      else
+         gl->glDisable(GL_DEPTH_TEST);
+   }
+   if (state_changed(&gl_state->depth_func, func, 1))
+      gl->glDepthFunc(func);
+}
+
+/* set_perspective() is 4 GL calls */
+static void
+state_perspective(Evas_Object *obj, float fovDegree, int w, int h, float zNear, float zFar)
+{
+   if (state_tracking && gl_state->w == w && gl_state->h == h && gl_state->fov == fovDegree &&
+       gl_state->znear == zNear && gl_state->zfar == zFar) {
+      gl_state->skipped += 4;
+      return;
+   }
+
+   gl_state->w = w;
+   gl_state->h = h;
+   gl_state->fov = fovDegree;
+   gl_state->znear = zNear;
+   gl_state->zfar = zFar;
+   gl_state->applied += 4;
+   set_perspective(obj, fovDegree, w, h, zNear, zFar);
+}
+
+void
+init_gles(Evas_Object *obj)
+{
+   int w, h;
+   appdata_s *ad;
+   Image images[2];
+   Eina_Bool loaded;
+   double t;
+#ifndef EMBEDDED_TEXTURES
+   Tex_File *files[2] = { NULL, NULL };
+#endif
+printf("%s\n", __func__);
+   ELEMENTARY_GLVIEW_USE(obj);
+   ad = view_get(obj);
+
+   fprintf(stderr, "Extension: %s\n", evas_gl_string_query(elm_glview_evas_gl_get(obj), EVAS_GL_EXTENSIONS));
+
+   memset(images, 0, sizeof(images));
+   t = ecore_time_get();
+#ifdef EMBEDDED_TEXTURES
+   loaded = init_textures(obj, ad, images);
+#else
+   loaded = init_textures(obj, ad, images, files);
+#endif
+
    ad->current_tex_index = 0;
 
-   __evas_gl_glapi->glShadeModel(GL_SMOOTH);
+   init_atlas(obj, ad, images);
+#ifndef EMBEDDED_TEXTURES
+   tex_file_close(files[0]);
+   tex_file_close(files[1]);
+#endif
+   t = ecore_time_get() - t;
+
+   if (!loaded)
+      printf("textures: cannot load, set TEXTURE_DIR\n");
+   printf("textures %s: %.3f ms to load and upload, ready %.3f ms after start, RSS %ld kB\n",
+#ifdef EMBEDDED_TEXTURES
+          "compiled in",
+#else
+          "mapped",
+#endif
+          t * 1000.0, (ecore_time_get() - startup_time) * 1000.0, rss_kb());
+
+   init_buffers(obj, ad);
 
-   __evas_gl_glapi->glEnable(GL_CULL_FACE);
-   __evas_gl_glapi->glCullFace(GL_BACK);
+   /* new context, nothing sent yet */
+   state_invalidate();
 
-   __evas_gl_glapi->glEnable(GL_DEPTH_TEST);
-   __evas_gl_glapi->glDepthFunc(GL_LESS);
+   state_shade_model(__evas_gl_glapi, GL_SMOOTH);
+   state_cull_face(__evas_gl_glapi, EINA_TRUE, GL_BACK);
+   state_depth_test(__evas_gl_glapi, EINA_TRUE, GL_LESS);
 
    elm_glview_size_get(obj, &w, &h);
-   set_perspective(obj, 60.0f, w, h, 1.0f, 400.0f);
+   state_perspective(obj, 60.0f, w, h, 1.0f, 400.0f);
 }
 
 void
@@ -164,170 +651,260 @@ destroy_gles(Evas_Object *obj)
       __evas_gl_glapi->glDeleteTextures(1, &(ad->tex_ids[1]));
       ad->tex_ids[1] = 0;
    }
+
+   if (ad->atlas_tex)
+   {
+      __evas_gl_glapi->glDeleteTextures(1, &ad->atlas_tex);
+      ad->atlas_tex = 0;
+   }
+
+   if (ad->vbo[0])
+   {
+      __evas_gl_glapi->glDeleteBuffers(2, ad->vbo);
+      __evas_gl_glapi->glDeleteBuffers(2, ad->ibo);
+      ad->vbo[0] = ad->vbo[1] = 0;
+      ad->ibo[0] = ad->ibo[1] = 0;
+   }
 }
 
 void
 resize_gl(Evas_Object *obj)
 {
    int w, h;
+   view_get(obj);
    elm_glview_size_get(obj, &w, &h);
-   set_perspective(obj, 60.0f, w, h, 1.0f, 400.0f);
+   state_perspective(obj, 60.0f, w, h, 1.0f, 400.0f);
    printf("%s (w %d, h %d)\n", __func__, w, h);
 }
 
 static void
 draw_cube1(Evas_Object *obj)
 {
-   static int angle = 0;
+   appdata_s *ad;
 
    ELEMENTARY_GLVIEW_USE(obj);
+   ad = evas_object_data_get(obj, APPDATA_KEY);
 
-   static const float VERTICES[] =
-   {
-      ONEN, ONEP, ONEN, // 0
-      ONEP, ONEP, ONEN, // 1
-      ONEN, ONEN, ONEN, // 2
-      ONEP, ONEN, ONEN, // 3
-      ONEN, ONEP, ONEP, // 4
-      ONEP, ONEP, ONEP, // 5
-      ONEN, ONEN, ONEP, // 6
-      ONEP, ONEN, ONEP  // 7
-   };
-
-   static const float VERTEX_COLOR[] =
-   {
-      ONEP, ZERO, ONEP, ONEP,
-      ONEP, ONEP, ZERO, ONEP,
-      ZERO, ONEP, ONEP, ONEP,
-      ONEP, ZERO, ZERO, ONEP,
-      ZERO, ZERO, ONEP, ONEP,
-      ZERO, ONEP, ZERO, ONEP,
-      ONEP, ONEP, ONEP, ONEP,
-      ZERO, ZERO, ZERO, ONEP
-   };
-
-   static const unsigned short INDEX_BUFFER[] =
-   {
-      0, 1, 2, 2, 1, 3,
-      1, 5, 3, 3, 5, 7,
-      5, 4, 7, 7, 4, 6,
-      4, 0, 6, 6, 0, 2,
-      4, 5, 0, 0, 5, 1,
-      2, 3, 6, 6, 3, 7
-   };
+   GL_CALL(glEnableClientState)(GL_VERTEX_ARRAY);
+   GL_CALL(glEnableClientState)(GL_COLOR_ARRAY);
+   if (ad->batch) {
+      GL_CALL(glBindBuffer)(GL_ARRAY_BUFFER, ad->vbo[0]);
+      GL_CALL(glBindBuffer)(GL_ELEMENT_ARRAY_BUFFER, ad->ibo[0]);
+      GL_CALL(glVertexPointer)(3, GL_FLOAT, sizeof(Color_Vertex), (void *)offsetof(Color_Vertex, pos));
+      GL_CALL(glColorPointer)(4, GL_FLOAT, sizeof(Color_Vertex), (void *)offsetof(Color_Vertex, color));
+   }
+   else {
+      GL_CALL(glVertexPointer)(3, GL_FLOAT, 0, CUBE1_VERTICES);
+      GL_CALL(glColorPointer)(4, GL_FLOAT, 0, CUBE1_COLORS);
+   }
 
-   __evas_gl_glapi->glEnableClientState(GL_VERTEX_ARRAY);
-   __evas_gl_glapi->glVertexPointer(3, GL_FLOAT, 0, VERTICES);
+   GL_CALL(glMatrixMode)(GL_MODELVIEW);
+   GL_CALL(glLoadIdentity)();
+   GL_CALL(glTranslatef)(0, -0.7f, -5.0f);
 
-   __evas_gl_glapi->glEnableClientState(GL_COLOR_ARRAY);
-   __evas_gl_glapi->glColorPointer(4, GL_FLOAT, 0, VERTEX_COLOR);
+   ad->angle1 = (ad->angle1 + 1) % (360 * 3);
+   GL_CALL(glRotatef)((float)ad->angle1 / 3, 1.0f, 0, 0);
+   GL_CALL(glRotatef)((float)ad->angle1, 0, 0, 1.0f);
 
-   __evas_gl_glapi->glMatrixMode(GL_MODELVIEW);
-   __evas_gl_glapi->glLoadIdentity();
-   __evas_gl_glapi->glTranslatef(0, -0.7f, -5.0f);
+   if (ad->batch)
+      GL_CALL(glDrawElements)(GL_TRIANGLES, 6 * (3 * 2), GL_UNSIGNED_SHORT, NULL);
+   else
+      GL_CALL(glDrawElements)(GL_TRIANGLES, 6 * (3 * 2), GL_UNSIGNED_SHORT, &CUBE1_INDICES[0]);
 
-   angle = (angle + 1) % (360 * 3);
-   __evas_gl_glapi->glRotatef((float)angle / 3, 1.0f, 0, 0);
-   __evas_gl_glapi->glRotatef((float)angle, 0, 0, 1.0f);
+   GL_CALL(glDisableClientState)(GL_VERTEX_ARRAY);
+   GL_CALL(glDisableClientState)(GL_COLOR_ARRAY);
+}
 
-   __evas_gl_glapi->glDrawElements(GL_TRIANGLES, 6 * (3 * 2), GL_UNSIGNED_SHORT, &INDEX_BUFFER[0]);
+/* Switches cube2 to image 0 or 1: a texture bind, or with the atlas the
+ * texture coordinates of its region. */
+static void
+select_image(Evas_Object *obj, appdata_s *ad, int image)
+{
+   ELEMENTARY_GLVIEW_USE(obj);
 
-   __evas_gl_glapi->glDisableClientState(GL_VERTEX_ARRAY);
-   __evas_gl_glapi->glDisableClientState(GL_COLOR_ARRAY);
+   if (ad->atlas && ad->batch) {
+      GL_CALL(glTexCoordPointer)(2, GL_FLOAT, 0,
+                                 (void *)(sizeof(Tex_Vertex[24]) + image * sizeof(ad->atlas_uv[0])));
+   }
+   else if (ad->atlas) {
+      GL_CALL(glTexCoordPointer)(2, GL_FLOAT, 0, ad->atlas_uv[image]);
+   }
+   else {
+      GL_CALL(glBindTexture)(GL_TEXTURE_2D, ad->tex_ids[image]);
+   }
 }
 
 static void
 draw_cube2(Evas_Object *obj)
 {
-   int i;
+   int i, c, n, image, last = -1;
    appdata_s *ad;
-   static float zPos = -5.0f;
-   static float zPosInc = Z_POS_INC;
-   static int angle = 0;
 
    ELEMENTARY_GLVIEW_USE(obj);
    ad = evas_object_data_get(obj, APPDATA_KEY);
 
-   static const float VERTICES[] =
-   {
-      ONEN, ONEN, ONEP, ONEP, ONEN, ONEP, ONEN, ONEP, ONEP, ONEP, ONEP, ONEP,
-      ONEN, ONEN, ONEN, ONEN, ONEP, ONEN, ONEP, ONEN, ONEN, ONEP, ONEP, ONEN,
-      ONEN, ONEN, ONEP, ONEN, ONEP, ONEP, ONEN, ONEN, ONEN, ONEN, ONEP, ONEN,
-      ONEP, ONEN, ONEN, ONEP, ONEP, ONEN, ONEP, ONEN, ONEP, ONEP, ONEP, ONEP,
-      ONEN, ONEP, ONEP, ONEP, ONEP, ONEP, ONEN, ONEP, ONEN, ONEP, ONEP, ONEN,
-      ONEN, ONEN, ONEP, ONEN, ONEN, ONEN, ONEP, ONEN, ONEP, ONEP, ONEN, ONEN
-   };
-
-   static const float TEXTURE_COORD[] =
-   {
-      ONEP, ZERO, ZERO, ZERO, ONEP, ONEP, ZERO, ONEP,
-      ONEP, ZERO, ZERO, ZERO, ONEP, ONEP, ZERO, ONEP,
-      ONEP, ZERO, ZERO, ZERO, ONEP, ONEP, ZERO, ONEP,
-      ONEP, ZERO, ZERO, ZERO, ONEP, ONEP, ZERO, ONEP,
-      ONEP, ZERO, ZERO, ZERO, ONEP, ONEP, ZERO, ONEP,
-      ONEP, ZERO, ZERO, ZERO, ONEP, ONEP, ZERO, ONEP
-   };
-
-   __evas_gl_glapi->glEnableClientState(GL_VERTEX_ARRAY);
-   __evas_gl_glapi->glVertexPointer(3, GL_FLOAT, 0, VERTICES);
-
-   __evas_gl_glapi->glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-   __evas_gl_glapi->glTexCoordPointer(2, GL_FLOAT, 0, TEXTURE_COORD);
+   GL_CALL(glEnableClientState)(GL_VERTEX_ARRAY);
+   GL_CALL(glEnableClientState)(GL_TEXTURE_COORD_ARRAY);
+   if (ad->batch) {
+      GL_CALL(glBindBuffer)(GL_ARRAY_BUFFER, ad->vbo[1]);
+      GL_CALL(glBindBuffer)(GL_ELEMENT_ARRAY_BUFFER, ad->ibo[1]);
+      GL_CALL(glVertexPointer)(3, GL_FLOAT, sizeof(Tex_Vertex), (void *)offsetof(Tex_Vertex, pos));
+      GL_CALL(glTexCoordPointer)(2, GL_FLOAT, sizeof(Tex_Vertex), (void *)offsetof(Tex_Vertex, uv));
+   }
+   else {
+      GL_CALL(glVertexPointer)(3, GL_FLOAT, 0, CUBE2_VERTICES);
+      GL_CALL(glTexCoordPointer)(2, GL_FLOAT, 0, CUBE2_TEXTURE_COORD);
+   }
 
-   __evas_gl_glapi->glEnable(GL_TEXTURE_2D);
-   __evas_gl_glapi->glBindTexture(GL_TEXTURE_2D, ad->tex_ids[ad->current_tex_index]);
+   GL_CALL(glEnable)(GL_TEXTURE_2D);
+   if (ad->atlas)
+      GL_CALL(glBindTexture)(GL_TEXTURE_2D, ad->atlas_tex);
 
-   __evas_gl_glapi->glMatrixMode(GL_MODELVIEW);
+   GL_CALL(glMatrixMode)(GL_MODELVIEW);
 
-   zPos += zPosInc;
+   ad->zpos += ad->zpos_inc;
 
    /* Keep switching textures in cube 2 */
-   if (zPos < -8.0f)
+   if (ad->zpos < -8.0f)
    {
-      zPosInc = Z_POS_INC;
+      ad->zpos_inc = Z_POS_INC;
       ad->current_tex_index = 1 - (ad->current_tex_index);
    }
 
-   if (zPos > -5.0f)
-      zPosInc = -Z_POS_INC;
-
-   __evas_gl_glapi->glLoadIdentity();
-   __evas_gl_glapi->glTranslatef(0, 1.2f, zPos);
-
-   angle = (angle + 1) % (360 * 3);
-   __evas_gl_glapi->glRotatef((float)angle / 3, 0, 0, 1.0f);
-   __evas_gl_glapi->glRotatef((float)angle, 0, 1.0f, 0);
+   if (ad->zpos > -5.0f)
+      ad->zpos_inc = -Z_POS_INC;
+
+   ad->angle2 = (ad->angle2 + 1) % (360 * 3);
+
+   /* side of the grid */
+   for (n = 1; n * n < ad->cube_count; n++)
+      ;
+
+   for (c = 0; c < ad->cube_count; c++) {
+      /* neighbours show different images */
+      image = (c + ad->current_tex_index) & 1;
+      if (image != last)
+         select_image(obj, ad, image);
+      last = image;
+
+      GL_CALL(glLoadIdentity)();
+      if (ad->cube_count == 1) {
+         GL_CALL(glTranslatef)(0, 1.2f, ad->zpos);
+      }
+      else {
+         float step = 3.0f / n;
+
+         GL_CALL(glTranslatef)(-1.5f + step * (c % n + 0.5f), -1.0f + step * (c / n + 0.5f), ad->zpos);
+         GL_CALL(glScalef)(step * 0.35f, step * 0.35f, step * 0.35f);
+      }
+
+      GL_CALL(glRotatef)((float)ad->angle2 / 3, 0, 0, 1.0f);
+      GL_CALL(glRotatef)((float)ad->angle2, 0, 1.0f, 0);
+
+      if (ad->batch) {
+         GL_CALL(glDrawElements)(GL_TRIANGLES, 6 * (3 * 2), GL_UNSIGNED_SHORT, NULL);
+      }
+      else {
+         for(i = 0; i < 6; i++)
+            GL_CALL(glDrawArrays)(GL_TRIANGLE_STRIP, (4 * i), 4);
+      }
+   }
 
-   for(i = 0; i < 6; i++)
-      __evas_gl_glapi->glDrawArrays(GL_TRIANGLE_STRIP, (4 * i), 4);
+   if (ad->batch) {
+      GL_CALL(glBindBuffer)(GL_ARRAY_BUFFER, 0);
+      GL_CALL(glBindBuffer)(GL_ELEMENT_ARRAY_BUFFER, 0);
+   }
 
-   __evas_gl_glapi->glDisable(GL_TEXTURE_2D);
-   __evas_gl_glapi->glDisableClientState(GL_VERTEX_ARRAY);
-   __evas_gl_glapi->glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+   GL_CALL(glDisable)(GL_TEXTURE_2D);
+   GL_CALL(glDisableClientState)(GL_VERTEX_ARRAY);
+   GL_CALL(glDisableClientState)(GL_TEXTURE_COORD_ARRAY);
 }
 
+/* GL calls and CPU time spent submitting the cubes, per frame */
+static void
+submit_stats(appdata_s *ad, unsigned long calls, double t)
+{
+   ad->frames++;
+   ad->calls += calls;
+   ad->submit += t;
+   if (ad->frames < STATS_FRAMES)
+      return;
+
+   printf("%s, %s, %d textured cubes: %.1f GL calls/frame, %.3f ms/frame submit\n",
+          ad->batch ? "buffer objects" : "client arrays",
+          ad->atlas ? "atlas" : "texture binds", ad->cube_count,
+          (double)ad->calls / ad->frames, ad->submit * 1000.0 / ad->frames);
+   printf("state%s: %.1f GL calls/frame applied, %.1f saved, %.3f ms/frame\n",
+          state_tracking ? "" : " (untracked)",
+          (double)ad->state_applied / ad->frames, (double)ad->state_skipped / ad->frames,
+          ad->state * 1000.0 / ad->frames);
+
+   ad->frames = 0;
+   ad->calls = 0;
+   ad->submit = 0.0;
+   ad->state_applied = 0;
+   ad->state_skipped = 0;
+   ad->state = 0.0;
+   if (ad->compare)
+      ad->batch = !ad->batch;
+}
 
 void
 draw_gl(Evas_Object *obj)
 {
    ELEMENTARY_GLVIEW_USE(obj);
    //printf("%s\n", __func__);
+   appdata_s *ad = view_get(obj);
+   unsigned long applied, skipped;
+   double t, start;
    int w, h;
-   __evas_gl_glapi->glShadeModel(GL_SMOOTH);
 
-      __evas_gl_glapi->glEnable(GL_CULL_FACE);
-      __evas_gl_glapi->glCullFace(GL_BACK);
-
-      __evas_gl_glapi->glEnable(GL_DEPTH_TEST);
-      __evas_gl_glapi->glDepthFunc(GL_LESS);
+   start = ecore_time_get();
+   if (ad->index == 0) {
+      frame_stats_frame(frame_stats);
+      pacing_draw_begin(pacing);
+      bench_draw_begin(bench);
+      perf_counters_begin(perf_counters);
+   }
+   applied = gl_state->applied;
+   skipped = gl_state->skipped;
+   t = ecore_time_get();
+   state_shade_model(__evas_gl_glapi, GL_SMOOTH);
+   state_cull_face(__evas_gl_glapi, EINA_TRUE, GL_BACK);
+   state_depth_test(__evas_gl_glapi, EINA_TRUE, GL_LESS);
    elm_glview_size_get(obj, &w, &h);
-      set_perspective(obj, 60.0f, w, h, 1.0f, 400.0f);
+   state_perspective(obj, 60.0f, w, h, 1.0f, 400.0f);
+   ad->state += ecore_time_get() - t;
+   ad->state_applied += gl_state->applied - applied;
+   ad->state_skipped += gl_state->skipped - skipped;
 
    __evas_gl_glapi->glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
    __evas_gl_glapi->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+   gl_calls = 0;
+   t = ecore_time_get();
    draw_cube1(obj);
    draw_cube2(obj);
+   t = ecore_time_get() - t;
+   /* one view reports for the grid */
+   if (ad->index == 0) {
+      submit_stats(ad, gl_calls, t);
+      perf_counters_end(perf_counters);
+   }
+
+   if (ad->index == 0 && !golden_frame(golden, __evas_gl_glapi, w, h))
+      elm_exit();
+   if (ad->index == 0) {
+      pacing_draw_end(pacing);
+      gl_profile_frame();
+      gl_trace_frame();
+      gl_redundant_frame();
+   }
+   if (ad->index == 0 && !bench_draw_end(bench))
+      elm_exit();
+
+   grid.draws++;
+   grid.draw += ecore_time_get() - start;
 }
 
 
@@ -338,17 +915,17 @@ _glview_create(appdata_s *ad)
 printf("%s\n", __func__);
    /* Create a GLView with an OpenGL-ES 1.1 context */
    obj = elm_glview_version_add(ad->win, EVAS_GL_GLES_1_X);
-   evas_object_resize(obj, 320, 480);
+   evas_object_resize(obj, WinWidth, WinHeight);
    //elm_table_pack(ad->table, obj, 1, 1, 3, 1);
    evas_object_data_set(obj, APPDATA_KEY, ad);
 
-   if (!getenv("DIRECT"))
+   if (!direct)
      elm_glview_mode_set(obj, ELM_GLVIEW_DEPTH);
    else
      elm_glview_mode_set(obj, ELM_GLVIEW_DEPTH | ELM_GLVIEW_DIRECT);
 
    elm_glview_resize_policy_set(obj, ELM_GLVIEW_RESIZE_POLICY_RECREATE);
-   elm_glview_render_policy_set(obj, ELM_GLVIEW_RENDER_POLICY_ON_DEMAND);
+   elm_glview_render_policy_set(obj, render_policy);
 
    elm_glview_init_func_set(obj, init_gles);
    elm_glview_del_func_set(obj, destroy_gles);
@@ -385,6 +962,8 @@ _anim_cb(void *data)
    //evas_object_hide(ad->img);
    //evas_damage_rectangle_add(evas_object_evas_get(ad->img), 0, 0, 720, 1280);
    //if (cnt<100 || cnt>200)
+   if (ad->index == 0)
+      pacing_tick(pacing);
    elm_glview_changed_set(ad->glview);
    cnt++;
    return ECORE_CALLBACK_RENEW;
@@ -398,6 +977,87 @@ _destroy_anim(void *data, Evas *evas, Evas_Object *obj, void *event_info)
 }
 
 
+static void
+_view_free(void *data, Evas *evas EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   appdata_s *vd = data;
+
+   ecore_animator_del(vd->anim);
+   free(vd);
+}
+
+static void
+_render_pre(void *data EINA_UNUSED, Evas *e EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   grid.render_start = ecore_time_get();
+}
+
+static void
+_render_post(void *data EINA_UNUSED, Evas *e EINA_UNUSED, void *event_info EINA_UNUSED)
+{
+   grid.renders++;
+   grid.render += ecore_time_get() - grid.render_start;
+}
+
+static Eina_Bool
+_grid_report(void *data EINA_UNUSED)
+{
+   double now = ecore_time_get();
+   double dt = now - grid.since;
+
+   if (grid.renders)
+      printf("grid %dx%d%s: %.1f canvas renders/s, %.1f view frames/s, "
+             "render %.3f ms: draw_gl %.3f ms, composition and the rest %.3f ms\n",
+             grid.cols, grid.rows, direct ? " direct" : "",
+             grid.renders / dt, grid.draws / dt,
+             grid.render * 1000.0 / grid.renders, grid.draw * 1000.0 / grid.renders,
+             (grid.render - grid.draw) * 1000.0 / grid.renders);
+
+   grid.since = now;
+   grid.renders = grid.draws = 0;
+   grid.render = grid.draw = 0.0;
+   return ECORE_CALLBACK_RENEW;
+}
+
+/* Fills the table with cols x rows views, each a copy of ad. */
+static void
+_grid_create(appdata_s *ad)
+{
+   Evas_Object *g, *o;
+   Evas *evas;
+   int i;
+
+   evas_object_resize(ad->win, grid.cols * 160 > WinWidth ? grid.cols * 160 : WinWidth,
+                      grid.rows * 160 > WinHeight ? grid.rows * 160 : WinHeight);
+
+   g = elm_table_add(ad->win);
+   elm_table_homogeneous_set(g, EINA_TRUE);
+   elm_table_pack(ad->table, g, 1, 1, 3, 8);
+   SX(g);
+
+   ecore_animator_frametime_set(1.0 / 60.0);
+   for (i = 0; i < grid.cols * grid.rows; i++) {
+      appdata_s *vd = malloc(sizeof(appdata_s));
+
+      if (!vd)
+         break;
+      *vd = *ad;
+      vd->index = i;
+      vd->glview = o = _glview_create(vd);
+      elm_table_pack(g, o, i % grid.cols, i / grid.cols, 1, 1);
+      SX(o);
+
+      vd->anim = ecore_animator_add(_anim_cb, vd);
+      evas_object_event_callback_add(o, EVAS_CALLBACK_FREE, _view_free, vd);
+   }
+
+   evas = evas_object_evas_get(ad->win);
+   evas_event_callback_add(evas, EVAS_CALLBACK_RENDER_PRE, _render_pre, NULL);
+   evas_event_callback_add(evas, EVAS_CALLBACK_RENDER_POST, _render_post, NULL);
+   grid.since = ecore_time_get();
+   grid.timer = ecore_timer_add(2.0, _grid_report, NULL);
+}
+
 static void
 _close_cb(void *data EINA_UNUSED,
           Evas_Object *obj EINA_UNUSED, void *event_info EINA_UNUSED)
@@ -410,32 +1070,60 @@ int main(int argc, char **argv)
    appdata_s add = {0,};
    Evas_Object *o, *t;
    appdata_s *ad = &add;
+   const char *batch;
+   int status;
+
+   startup_time = ecore_time_get();
 
    /* Force OpenGL engine */
    elm_init(argc, argv);
    elm_config_accel_preference_set("opengl:depth24");
 
+   bench_size(&WinWidth, &WinHeight);
+   direct = bench_direct(EINA_FALSE);
+   render_policy = pacing_render_policy();
+
+   /* CUBE_BATCH=0 draws from client arrays, =compare alternates */
+   batch = getenv("CUBE_BATCH");
+   ad->batch = !batch || strcmp(batch, "0");
+   ad->compare = batch && !strcmp(batch, "compare");
+   state_tracking = !getenv("STATE_TRACKING") || atoi(getenv("STATE_TRACKING"));
+   /* ATLAS=0 binds one texture per image, CUBE_COUNT=N draws N cubes */
+   ad->atlas = !getenv("ATLAS") || atoi(getenv("ATLAS"));
+   ad->cube_count = getenv("CUBE_COUNT") ? atoi(getenv("CUBE_COUNT")) : 1;
+   if (ad->cube_count < 1)
+      ad->cube_count = 1;
+   ad->zpos = -5.0f;
+   ad->zpos_inc = Z_POS_INC;
+
+   if (getenv("GRID") &&
+       (sscanf(getenv("GRID"), "%dx%d", &grid.cols, &grid.rows) != 2 ||
+        grid.cols < 1 || grid.rows < 1)) {
+      printf("GRID must be <cols>x<rows>\n");
+      grid.cols = grid.rows = 1;
+   }
+
    /* Add a window */
    ad->win = o = elm_win_add(NULL, "glview", ELM_WIN_BASIC);
    elm_win_title_set(o, "GLView Simple");
    elm_win_autodel_set(o, EINA_TRUE);
    //evas_object_smart_callback_add(o, "delete,request", _close_cb, ad);
    evas_object_event_callback_add(o, EVAS_CALLBACK_RESIZE, _win_resize_cb, ad);
-   evas_object_resize(ad->win, 320, 480);
+   evas_object_resize(ad->win, WinWidth, WinHeight);
    //eext_object_event_callback_add(o, EEXT_CALLBACK_BACK, _close_cb, ad);
    S(o);
 
    /* Add a background */
    ad->bg = o = elm_bg_add(ad->win);
    //elm_win_resize_object_add(ad->win, ad->bg);
-   evas_object_resize(o, 320, 480);
+   evas_object_resize(o, WinWidth, WinHeight);
    elm_bg_color_set(o, 255, 68, 68);
    S(o);
 
    /* Add a resize conformant */
    ad->conform = o = elm_conformant_add(ad->win);
    //elm_win_resize_object_add(ad->win, ad->conform);
-   evas_object_resize(o, 320, 480);
+   evas_object_resize(o, WinWidth, WinHeight);
    SX(o);
 
    ad->table = t = elm_table_add(ad->win);
@@ -452,6 +1140,11 @@ int main(int argc, char **argv)
    elm_table_pack(t, o, 1, 9, 3, 1);
    SF(o);
 
+   if (grid.cols * grid.rows > 1) {
+      _grid_create(ad);
+      goto run;
+   }
+
    ad->glview = o = _glview_create(ad);
    SX(o);
 
@@ -468,9 +1161,21 @@ int main(int argc, char **argv)
    ad->anim = ecore_animator_add(_anim_cb, ad);
    evas_object_event_callback_add(ad->glview, EVAS_CALLBACK_DEL, _destroy_anim, ad->anim);
 
+run:
+   golden = golden_new("glviewcube11");
+   bench = bench_new("glviewcube11", ad->win, direct);
+   pacing = pacing_new("glviewcube11", ad->win, render_policy);
+   frame_stats = frame_stats_new("glviewcube11");
+   perf_counters = perf_counters_new("glviewcube11");
+
    elm_run();
+   perf_counters_free(perf_counters);
+   frame_stats_free(frame_stats);
+   pacing_free(pacing);
+   bench_finish(bench);
+   status = golden_finish(golden);
    elm_shutdown();
-   return 0;
+   return status;
 }
 #if 0
 EAPI_MAIN int
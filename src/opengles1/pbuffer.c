@@ -19,25 +19,168 @@
 #include <string.h>
 #include <Elementary.h>
 #include <Evas_GL.h>
+#include "frame_arena.h"
+#include "frame_writer.h"
+#include "gl_share.h"
+#include "bench.h"
+#include "frame_stats.h"
+#include "gl_profile.h"
+#include "gl_redundant.h"
+#include "gl_trace.h"
+#include "golden.h"
+#include "gpu_fence.h"
+#include "image_diff.h"
+#include "mat4.h"
+#include "pbuffer_pool.h"
+#include "perf_counters.h"
+#include "readback.h"
 
-#define EVAS_GL_API_USE(gl) \
-   Evas_GL_API *__evas_gl_glapi = evas_gl_context_api_get(gl, evas_gl_context);
+static int WinWidth = 360, WinHeight = 480;
 
-Evas_GL *evas_gl;
-Evas_GL_Surface *evas_gl_surface;
-Evas_GL_Surface *evas_gl_pbuffer_surface;
-Evas_GL_Context *evas_gl_context;
+/* BENCH_SIZE, INSTANCES and DIRECT, see bench.h */
+static Eina_Bool direct = EINA_TRUE;
 
-static int WinWidth = 360, WinHeight = 480;
+#define PBUFFER_BUCKET 64
+#define PBUFFER_IDLE_TIMEOUT 2.0
+#define HEAP_REPORT_FRAMES 300
 
-static GLfloat view_rotx = 0.0, view_roty = 0.0, view_rotz = 0.0;
+/* PBUFFER_HEATMAP=<file.ppm> saves the per tile error map of the first
+ * frame that does not match.
+ */
+static const char *heatmap_path = NULL;
 
+#define TORUS_SIDES 30
+#define TORUS_RINGS 60
+#define TORUS_RING_VERTS ((TORUS_SIDES + 1) * 2)
+
+/* One window and pbuffer pair, compared frame by frame, with its own
+ * window and Evas GL contexts.
+ */
 typedef struct appdata {
    const char *name;
+   int id;
 
    Evas_Object *win;
+
+   Evas_GL *evas_gl;
+   Evas_GL_Surface *evas_gl_surface;
+   Evas_GL_Surface *evas_gl_pbuffer_surface;
+   Evas_GL_Context *evas_gl_context;
+   Evas_GL_Context *evas_gl_pbuffer_context;
+
+   /* The API table is per GLES version, the one of evas_gl_context serves
+    * the pbuffer and render farm contexts too.  It is looked up when the
+    * context is created, wrapped by GL_PROFILE, GL_TRACE and GL_REDUNDANT
+    * (see gl_profile.h, gl_trace.h and gl_redundant.h).
+    */
+   Evas_GL_API *glapi;
+
+   /* current window size, the pbuffer renders the same */
+   int width, height;
+   GLfloat view_rotx, view_roty, view_rotz;
+
+   /* GLES3 set in the environment runs the comparison on a GLES 3.x
+    * context, where the readbacks go through a ring of pixel pack buffers
+    * instead of stalling in glReadPixels.  The fixed function pipeline is
+    * gone there, so the torus is drawn from a VBO with a small lighting
+    * shader.
+    */
+   Eina_Bool use_gles3;
+   Readback *readback;
+   Eina_Bool verbose;
+
+   /* SHARE_CONTEXTS set in the environment renders the pbuffer with its
+    * own context.  It shares objects with the window context, so the
+    * texture and the torus mesh are uploaded once through the share
+    * manager and only the per context state is set up twice.
+    */
+   Gl_Share *share;
+
+   /* Without the PBO ring, frames are synchronised with fences when the
+    * context has them, PBUFFER_FINISH set in the environment goes back to
+    * glFinish().  gpu_wait adds up the time the CPU sat blocked on the GPU
+    * in either path, glReadPixels() included.
+    */
+   Eina_Bool use_fences;
+   double gpu_wait;
+
+   /* The pbuffer follows the window size through a pool of surfaces
+    * rounded up to PBUFFER_BUCKET pixels; only the width x height corner
+    * is rendered and read back.  Surfaces left behind by a resize are
+    * destroyed after PBUFFER_IDLE_TIMEOUT seconds unless the size comes
+    * back.  When the pool cannot make a surface that fits, the old one
+    * stays and frames are not compared until a resize fits again.
+    */
+   Pbuffer_Pool *pbuffer_pool;
+   Eina_Bool pbuffer_short;
+
+   /* Window and pbuffer readbacks of the synchronous path.  The arena is
+    * sized in reshape(), so steady state frames never go to the heap; its
+    * counters are reported every HEAP_REPORT_FRAMES frames.
+    */
+   Frame_Arena frame_buffers;
+   int report_frame;
+   unsigned long report_allocs;
+   size_t report_bytes;
+
+   /* PBUFFER_TOLERANCE="r,g,b,a" sets how far a channel may differ before
+    * the pixel counts as a mismatch.
+    */
+   Image_Diff *differ;
+   Eina_Bool heatmap_saved;
+
+   GLuint es3_program, es3_vbo;
+   GLint es3_mvp_loc, es3_mv_loc;
+   GLfloat projection[16], modelview[16];
+
+   int frame;          /* draw callbacks */
+   int sync_frame;     /* frames compared by the synchronous paths */
+
+   /* the render farm's frame queue, see farm() */
+   Frame_Writer *farm_writer;
+   int farm_next, farm_frames;
+
+   /* GOLDEN=record|check, BENCH_FRAMES, BENCH_API_LOOKUP, FRAME_STATS and
+    * PERF_COUNTERS, see golden.h, bench.h, frame_stats.h and
+    * perf_counters.h; the first instance only */
+   Golden *golden;
+   Bench *frame_bench;
+   Frame_Stats *frame_stats;
+   Perf_Counters *perf_counters;
 } appdata_s;
 
+static const char es3_vertex_shader[] =
+   "#version 300 es\n"
+   "uniform mat4 u_mvp;\n"
+   "uniform mat4 u_modelview;\n"
+   "layout (location = 0) in vec3 a_position;\n"
+   "layout (location = 1) in vec3 a_normal;\n"
+   "layout (location = 2) in vec2 a_texcoord;\n"
+   "out vec4 v_color;\n"
+   "out vec2 v_texcoord;\n"
+   "void main()\n"
+   "{\n"
+   "   const vec3 light = vec3(20.0, 20.0, 50.0);\n"
+   "   vec3 n = normalize(mat3(u_modelview) * a_normal);\n"
+   "   vec3 p = vec3(u_modelview * vec4(a_position, 1.0));\n"
+   "   float d = max(dot(n, normalize(light - p)), 0.0);\n"
+   "   v_color = vec4(vec3(1.0, 0.0, 0.0) * (0.2 + 0.7 * d), 1.0);\n"
+   "   v_texcoord = a_texcoord;\n"
+   "   gl_Position = u_mvp * vec4(a_position, 1.0);\n"
+   "}";
+
+static const char es3_fragment_shader[] =
+   "#version 300 es\n"
+   "precision mediump float;\n"
+   "uniform sampler2D u_texture;\n"
+   "in vec4 v_color;\n"
+   "in vec2 v_texcoord;\n"
+   "out vec4 o_color;\n"
+   "void main()\n"
+   "{\n"
+   "   o_color = v_color * texture(u_texture, v_texcoord);\n"
+   "}";
+
 static void
 Normal(GLfloat *n, GLfloat nx, GLfloat ny, GLfloat nz)
 {
@@ -61,98 +204,247 @@ Texcoord(GLfloat *v, GLfloat s, GLfloat t)
    v[1] = t;
 }
 
+/* One GL_TRIANGLE_STRIP ring of the torus between theta and theta1 */
+static int
+torus_ring(GLfloat r, GLfloat R, GLint nsides, GLfloat theta, GLfloat theta1,
+           GLfloat (*varray)[3], GLfloat (*narray)[3], GLfloat (*tarray)[2])
+{
+   GLfloat cosTheta = cos(theta), sinTheta = sin(theta);
+   GLfloat cosTheta1 = cos(theta1), sinTheta1 = sin(theta1);
+   GLfloat phi = 0.0, sideDelta = 2.0 * M_PI / nsides;
+   int j, vcount = 0;
+
+   for (j = nsides; j >= 0; j--) {
+      GLfloat s0, s1, t;
+      GLfloat cosPhi, sinPhi, dist;
+
+      phi += sideDelta;
+      cosPhi = cos(phi);
+      sinPhi = sin(phi);
+      dist = R + r * cosPhi;
+
+      s0 = 20.0 * theta / (2.0 * M_PI);
+      s1 = 20.0 * theta1 / (2.0 * M_PI);
+      t = 8.0 * phi / (2.0 * M_PI);
+
+      Normal(narray[vcount], cosTheta1 * cosPhi, -sinTheta1 * cosPhi, sinPhi);
+      Texcoord(tarray[vcount], s1, t);
+      Vertex(varray[vcount], cosTheta1 * dist, -sinTheta1 * dist, r * sinPhi);
+      vcount++;
+
+      Normal(narray[vcount], cosTheta * cosPhi, -sinTheta * cosPhi, sinPhi);
+      Texcoord(tarray[vcount], s0, t);
+      Vertex(varray[vcount], cosTheta * dist, -sinTheta * dist,  r * sinPhi);
+      vcount++;
+   }
+
+   return vcount;
+}
+
 
 /* Borrowed from glut, adapted */
 static void
-draw_torus(GLfloat r, GLfloat R, GLint nsides, GLint rings)
+draw_torus(Evas_GL_API *api, GLfloat r, GLfloat R, GLint nsides, GLint rings)
 {
-   EVAS_GL_API_USE(evas_gl);
-   int i, j;
-   GLfloat theta, phi, theta1;
-   GLfloat cosTheta, sinTheta;
-   GLfloat cosTheta1, sinTheta1;
-   GLfloat ringDelta, sideDelta;
-   GLfloat varray[100][3], narray[100][3], tarray[100][2];
+   int i;
+   GLfloat theta, theta1;
+   GLfloat ringDelta;
+   /* GL reads these only at the draws; zeroing varray quiets
+    * -Wmaybe-uninitialized about handing them over before */
+   GLfloat varray[100][3] = { { 0 } }, narray[100][3], tarray[100][2];
    int vcount;
 
-   __evas_gl_glapi->glVertexPointer(3, GL_FLOAT, 0, varray);
-   __evas_gl_glapi->glNormalPointer(GL_FLOAT, 0, narray);
-   __evas_gl_glapi->glTexCoordPointer(2, GL_FLOAT, 0, tarray);
-   __evas_gl_glapi->glEnableClientState(GL_VERTEX_ARRAY);
-   __evas_gl_glapi->glEnableClientState(GL_NORMAL_ARRAY);
-   __evas_gl_glapi->glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+   api->glVertexPointer(3, GL_FLOAT, 0, varray);
+   api->glNormalPointer(GL_FLOAT, 0, narray);
+   api->glTexCoordPointer(2, GL_FLOAT, 0, tarray);
+   api->glEnableClientState(GL_VERTEX_ARRAY);
+   api->glEnableClientState(GL_NORMAL_ARRAY);
+   api->glEnableClientState(GL_TEXTURE_COORD_ARRAY);
    
    ringDelta = 2.0 * M_PI / rings;
-   sideDelta = 2.0 * M_PI / nsides;
 
    theta = 0.0;
-   cosTheta = 1.0;
-   sinTheta = 0.0;
    for (i = rings - 1; i >= 0; i--) {
       theta1 = theta + ringDelta;
-      cosTheta1 = cos(theta1);
-      sinTheta1 = sin(theta1);
-
-      vcount = 0; /* glBegin(GL_QUAD_STRIP); */
-
-      phi = 0.0;
-      for (j = nsides; j >= 0; j--) {
-         GLfloat s0, s1, t;
-         GLfloat cosPhi, sinPhi, dist;
-
-         phi += sideDelta;
-         cosPhi = cos(phi);
-         sinPhi = sin(phi);
-         dist = R + r * cosPhi;
-
-         s0 = 20.0 * theta / (2.0 * M_PI);
-         s1 = 20.0 * theta1 / (2.0 * M_PI);
-         t = 8.0 * phi / (2.0 * M_PI);
-
-         Normal(narray[vcount], cosTheta1 * cosPhi, -sinTheta1 * cosPhi, sinPhi);
-         Texcoord(tarray[vcount], s1, t);
-         Vertex(varray[vcount], cosTheta1 * dist, -sinTheta1 * dist, r * sinPhi);
-         vcount++;
-
-         Normal(narray[vcount], cosTheta * cosPhi, -sinTheta * cosPhi, sinPhi);
-         Texcoord(tarray[vcount], s0, t);
-         Vertex(varray[vcount], cosTheta * dist, -sinTheta * dist,  r * sinPhi);
-         vcount++;
-      }
 
-      /*glEnd();*/
+      /* glBegin(GL_QUAD_STRIP); ... glEnd(); */
+      vcount = torus_ring(r, R, nsides, theta, theta1, varray, narray, tarray);
       assert(vcount <= 100);
-      __evas_gl_glapi->glDrawArrays(GL_TRIANGLE_STRIP, 0, vcount);
+      api->glDrawArrays(GL_TRIANGLE_STRIP, 0, vcount);
 
       theta = theta1;
-      cosTheta = cosTheta1;
-      sinTheta = sinTheta1;
    }
 
-   __evas_gl_glapi->glDisableClientState(GL_VERTEX_ARRAY);
-   __evas_gl_glapi->glDisableClientState(GL_NORMAL_ARRAY);
-   __evas_gl_glapi->glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+   api->glDisableClientState(GL_VERTEX_ARRAY);
+   api->glDisableClientState(GL_NORMAL_ARRAY);
+   api->glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 }
 
 
+/* GLES 3.x: the whole torus lives in one VBO, positions, normals and
+ * texcoords one block after the other, TORUS_RING_VERTS per ring.
+ */
 static void
-draw(void)
+build_torus_vbo(appdata_s *ad, GLfloat r, GLfloat R)
 {
-   EVAS_GL_API_USE(evas_gl);
-   __evas_gl_glapi->glClearColor(0.4, 0.4, 0.4, 1.0);
-   __evas_gl_glapi->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+   Evas_GL_API *api = ad->glapi;
+   const int count = TORUS_RINGS * TORUS_RING_VERTS;
+   GLfloat (*varray)[3], (*narray)[3], (*tarray)[2];
+   GLfloat theta = 0.0, ringDelta = 2.0 * M_PI / TORUS_RINGS;
+   int i;
+
+   if (ad->share && (ad->es3_vbo = gl_share_get(ad->share, "torus mesh")))
+      return;
+
+   varray = malloc(sizeof(GLfloat) * count * 8);
+   if (!varray) {
+      printf("failed to allocate torus vertices\n");
+      return;
+   }
+   narray = varray + count;
+   tarray = (GLfloat (*)[2]) (narray + count);
+
+   for (i = 0; i < TORUS_RINGS; i++) {
+      torus_ring(r, R, TORUS_SIDES, theta, theta + ringDelta,
+                 varray + i * TORUS_RING_VERTS,
+                 narray + i * TORUS_RING_VERTS,
+                 tarray + i * TORUS_RING_VERTS);
+      theta += ringDelta;
+   }
+
+   if (ad->share) {
+      ad->es3_vbo = gl_share_buffer(ad->share, "torus mesh", GL_ARRAY_BUFFER,
+                                    sizeof(GLfloat) * count * 8, varray);
+   }
+   else {
+      api->glGenBuffers(1, &ad->es3_vbo);
+      api->glBindBuffer(GL_ARRAY_BUFFER, ad->es3_vbo);
+      api->glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * count * 8, varray, GL_STATIC_DRAW);
+      api->glBindBuffer(GL_ARRAY_BUFFER, 0);
+   }
+
+   free(varray);
+}
+
+
+static void
+draw_torus_es3(appdata_s *ad, GLfloat rotx, GLfloat roty, GLfloat rotz)
+{
+   Evas_GL_API *api = ad->glapi;
+   const int count = TORUS_RINGS * TORUS_RING_VERTS;
+   GLfloat mv[16], mvp[16];
+   int i;
+
+   memcpy(mv, ad->modelview, sizeof(mv));
+   mat4_rotate(mv, rotx, 1, 0, 0);
+   mat4_rotate(mv, roty, 0, 1, 0);
+   mat4_rotate(mv, rotz, 0, 0, 1);
+   mv[0] *= 0.5; mv[1] *= 0.5; mv[2] *= 0.5;
+   mv[4] *= 0.5; mv[5] *= 0.5; mv[6] *= 0.5;
+   mv[8] *= 0.5; mv[9] *= 0.5; mv[10] *= 0.5;
+   mat4_multiply(mvp, ad->projection, mv);
+
+   api->glUseProgram(ad->es3_program);
+   api->glUniformMatrix4fv(ad->es3_mvp_loc, 1, GL_FALSE, mvp);
+   api->glUniformMatrix4fv(ad->es3_mv_loc, 1, GL_FALSE, mv);
+
+   api->glBindBuffer(GL_ARRAY_BUFFER, ad->es3_vbo);
+   api->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid *) 0);
+   api->glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid *) (sizeof(GLfloat) * count * 3));
+   api->glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid *) (sizeof(GLfloat) * count * 6));
+   api->glEnableVertexAttribArray(0);
+   api->glEnableVertexAttribArray(1);
+   api->glEnableVertexAttribArray(2);
+
+   for (i = 0; i < TORUS_RINGS; i++)
+      api->glDrawArrays(GL_TRIANGLE_STRIP, i * TORUS_RING_VERTS, TORUS_RING_VERTS);
+
+   api->glDisableVertexAttribArray(0);
+   api->glDisableVertexAttribArray(1);
+   api->glDisableVertexAttribArray(2);
+   api->glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+/* Only reads from ad, so the render farm threads call it as well */
+static void
+draw_view(appdata_s *ad, GLfloat rotx, GLfloat roty, GLfloat rotz)
+{
+   Evas_GL_API *api = ad->glapi;
+   api->glClearColor(0.4, 0.4, 0.4, 1.0);
+   api->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+   if (ad->use_gles3) {
+      draw_torus_es3(ad, rotx, roty, rotz);
+   }
+   else {
+      api->glPushMatrix();
+      api->glRotatef(rotx, 1, 0, 0);
+      api->glRotatef(roty, 0, 1, 0);
+      api->glRotatef(rotz, 0, 0, 1);
+      api->glScalef(0.5, 0.5, 0.5);
+
+      draw_torus(api, 1.0, 3.0, TORUS_SIDES, TORUS_RINGS);
+
+      api->glPopMatrix();
+   }
+}
+
+
+static void
+draw(appdata_s *ad)
+{
+   draw_view(ad, ad->view_rotx, ad->view_roty, ad->view_rotz);
+}
+
+
+static void
+compare_frames(appdata_s *ad, const unsigned *wbuf, const unsigned *pbuf, int frame)
+{
+   const Image_Diff_Result *res;
+   int x = 100, y = 110;
+   int i;
+
+   /* the golden check and the diff are not drawing, keep them out of
+    * PERF_COUNTERS' window */
+   perf_counters_end(ad->perf_counters);
+
+   /* the pbuffer is smaller than what was read back from it */
+   if (ad->pbuffer_short)
+      return;
 
-   __evas_gl_glapi->glPushMatrix();
-   __evas_gl_glapi->glRotatef(view_rotx, 1, 0, 0);
-   __evas_gl_glapi->glRotatef(view_roty, 0, 1, 0);
-   __evas_gl_glapi->glRotatef(view_rotz, 0, 0, 1);
-   __evas_gl_glapi->glScalef(0.5, 0.5, 0.5);
+   if (ad->verbose) {
+      printf("Window[%d,%d] = 0x%08x (frame %d)\n", x, y, wbuf[y*ad->width+x], frame);
+      printf("Pbuffer[%d,%d] = 0x%08x (frame %d)\n", x, y, pbuf[y*ad->width+x], frame);
+   }
 
-   draw_torus(1.0, 3.0, 30, 60);
+   /* the pbuffer rendering is the headless one, it goes to the golden store */
+   if (!golden_check(ad->golden, pbuf, ad->width, ad->height))
+      elm_exit();
 
-   __evas_gl_glapi->glPopMatrix();
+   if (!ad->differ)
+      return;
 
-   __evas_gl_glapi->glFinish();
+   /* compare renderings */
+   res = image_diff_run(ad->differ, wbuf, pbuf, ad->width, ad->height);
+   if (!res || !ad->verbose)
+      return;
+
+   if (res->mismatches) {
+      i = res->first_mismatch;
+      printf("Difference at %d: 0x%08x vs. 0x%08x\n", i, wbuf[i], pbuf[i]);
+      printf("%lu pixels over tolerance, max error %u, PSNR %.2f dB (%.3f ms)\n",
+             res->mismatches, res->max_error, res->psnr, res->seconds * 1000.0);
+      if (heatmap_path && !ad->heatmap_saved) {
+         if (image_diff_heatmap_save(ad->differ, heatmap_path))
+            printf("Error heatmap of frame %d written to %s\n", frame, heatmap_path);
+         ad->heatmap_saved = EINA_TRUE;
+      }
+   }
+   else {
+      printf("Window rendering matches Pbuffer rendering! (max error %u, %.3f ms)\n",
+             res->max_error, res->seconds * 1000.0);
+   }
 }
 
 
@@ -160,93 +452,308 @@ draw(void)
  * Draw to both the window and pbuffer and compare results.
  */
 static void
-draw_both()
+draw_both_sync(appdata_s *ad)
 {
-   EVAS_GL_API_USE(evas_gl);
+   Evas_GL_API *api = ad->glapi;
    unsigned *wbuf, *pbuf;
-   int x = 100, y = 110;
-   int i, dif;
+   double t;
 
-   wbuf = (unsigned *) calloc(1, WinWidth * WinHeight * 4);
-   pbuf = (unsigned *) calloc(1, WinWidth * WinHeight * 4);
+   frame_arena_reset(&ad->frame_buffers);
+   wbuf = frame_arena_alloc(&ad->frame_buffers, ad->width * ad->height * 4);
+   pbuf = frame_arena_alloc(&ad->frame_buffers, ad->width * ad->height * 4);
+   if (!wbuf || !pbuf) {
+      printf("Error: frame buffers not reserved for %dx%d\n", ad->width, ad->height);
+      return;
+   }
 
-   __evas_gl_glapi->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+   api->glPixelStorei(GL_PACK_ALIGNMENT, 1);
 
    /* first draw to window */
-   if (!evas_gl_make_current(evas_gl, evas_gl_surface, evas_gl_context)) {
+   if (!evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context)) {
       printf("Error: eglMakeCurrent(window) failed\n");
       return;
    }
-   draw();
-   __evas_gl_glapi->glReadPixels(0, 0, WinWidth, WinHeight, GL_RGBA, GL_UNSIGNED_BYTE, wbuf);
-   printf("Window[%d,%d] = 0x%08x\n", x, y, wbuf[y*WinWidth+x]);
+   draw(ad);
+   t = ecore_time_get();
+   api->glFinish();
+   api->glReadPixels(0, 0, ad->width, ad->height, GL_RGBA, GL_UNSIGNED_BYTE, wbuf);
+   ad->gpu_wait += ecore_time_get() - t;
 
    /* then draw to pbuffer */
-   if (!evas_gl_make_current(evas_gl, evas_gl_pbuffer_surface, evas_gl_context)) {
+   if (!evas_gl_make_current(ad->evas_gl, ad->evas_gl_pbuffer_surface, ad->evas_gl_pbuffer_context)) {
       printf("Error: eglMakeCurrent(pbuffer) failed\n");
       return;
    }
 
-   draw();
-   __evas_gl_glapi->glReadPixels(0, 0, WinWidth, WinHeight, GL_RGBA, GL_UNSIGNED_BYTE, pbuf);
-   printf("Pbuffer[%d,%d] = 0x%08x\n", x, y, pbuf[y*WinWidth+x]);
+   draw(ad);
+   t = ecore_time_get();
+   api->glFinish();
+   api->glReadPixels(0, 0, ad->width, ad->height, GL_RGBA, GL_UNSIGNED_BYTE, pbuf);
+   ad->gpu_wait += ecore_time_get() - t;
 
+   compare_frames(ad, wbuf, pbuf, ad->sync_frame++);
+}
 
-   /* compare renderings */
-   for (dif = i = 0; i < WinWidth * WinHeight; i++) {
-      if (wbuf[i] != pbuf[i]) {
-         dif = 1;
-         break;
-      }
+
+/**
+ * Same as draw_both_sync() with fences instead of glFinish(): both
+ * targets are queued back to back, and the window is read back as soon
+ * as its own fence signals while the GPU still works on the pbuffer.
+ */
+static void
+draw_both_fenced(appdata_s *ad)
+{
+   Evas_GL_API *api = ad->glapi;
+   Gpu_Fence wfence, pfence;
+   unsigned *wbuf, *pbuf;
+   double t;
+
+   frame_arena_reset(&ad->frame_buffers);
+   wbuf = frame_arena_alloc(&ad->frame_buffers, ad->width * ad->height * 4);
+   pbuf = frame_arena_alloc(&ad->frame_buffers, ad->width * ad->height * 4);
+   if (!wbuf || !pbuf) {
+      printf("Error: frame buffers not reserved for %dx%d\n", ad->width, ad->height);
+      return;
    }
 
-   if (dif)
-      printf("Difference at %d: 0x%08x vs. 0x%08x\n", i, wbuf[i], pbuf[i]);
+   api->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+   if (!evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context)) {
+      printf("Error: eglMakeCurrent(window) failed\n");
+      return;
+   }
+   draw(ad);
+   gpu_fence_insert(&wfence, ad->evas_gl, api);
+
+   if (!evas_gl_make_current(ad->evas_gl, ad->evas_gl_pbuffer_surface, ad->evas_gl_pbuffer_context)) {
+      printf("Error: eglMakeCurrent(pbuffer) failed\n");
+      gpu_fence_wait(&wfence);
+      return;
+   }
+   draw(ad);
+   gpu_fence_insert(&pfence, ad->evas_gl, api);
+
+   ad->gpu_wait += gpu_fence_wait(&wfence);
+   evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context);
+   t = ecore_time_get();
+   api->glReadPixels(0, 0, ad->width, ad->height, GL_RGBA, GL_UNSIGNED_BYTE, wbuf);
+   ad->gpu_wait += ecore_time_get() - t;
+
+   ad->gpu_wait += gpu_fence_wait(&pfence);
+   evas_gl_make_current(ad->evas_gl, ad->evas_gl_pbuffer_surface, ad->evas_gl_pbuffer_context);
+   t = ecore_time_get();
+   api->glReadPixels(0, 0, ad->width, ad->height, GL_RGBA, GL_UNSIGNED_BYTE, pbuf);
+   ad->gpu_wait += ecore_time_get() - t;
+
+   compare_frames(ad, wbuf, pbuf, ad->sync_frame++);
+}
+
+
+/**
+ * Same as draw_both_sync() but both readbacks are queued into the PBO
+ * ring, and the comparison runs on the frame that was rendered
+ * readback_depth() - 1 frames ago.
+ */
+static void
+draw_both_async(appdata_s *ad)
+{
+   Evas_GL_API *api = ad->glapi;
+   const unsigned *wbuf, *pbuf;
+
+   api->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+   if (!evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context)) {
+      printf("Error: eglMakeCurrent(window) failed\n");
+      return;
+   }
+   draw(ad);
+   readback_read(ad->readback, 0);
+
+   if (!evas_gl_make_current(ad->evas_gl, ad->evas_gl_pbuffer_surface, ad->evas_gl_pbuffer_context)) {
+      printf("Error: eglMakeCurrent(pbuffer) failed\n");
+      return;
+   }
+   draw(ad);
+   readback_read(ad->readback, 1);
+
+   wbuf = readback_map(ad->readback, 0);
+   pbuf = readback_map(ad->readback, 1);
+   if (wbuf && pbuf)
+      compare_frames(ad, wbuf, pbuf, readback_frame(ad->readback));
+   readback_unmap(ad->readback);
+
+   readback_advance(ad->readback);
+}
+
+
+static void
+draw_both(appdata_s *ad)
+{
+   if (ad->readback)
+      draw_both_async(ad);
+   else if (ad->use_fences)
+      draw_both_fenced(ad);
    else
-      printf("Window rendering matches Pbuffer rendering!\n");
+      draw_both_sync(ad);
+
+   ad->view_rotx++;
+   ad->view_roty++;
+   ad->view_rotz++;
+
+   if (ad->verbose && ++ad->report_frame % HEAP_REPORT_FRAMES == 0) {
+      printf("frame buffers: %lu heap allocations, %zu bytes in the last %d frames\n",
+             ad->frame_buffers.allocs - ad->report_allocs,
+             ad->frame_buffers.bytes - ad->report_bytes,
+             HEAP_REPORT_FRAMES);
+      ad->report_allocs = ad->frame_buffers.allocs;
+      ad->report_bytes = ad->frame_buffers.bytes;
+   }
+}
+
+
+/* PBUFFER_BENCH=<frames> renders and compares that many frames back to
+ * back in every readback mode the context supports, then quits.
+ */
+static void
+bench(appdata_s *ad, int frames)
+{
+   Readback *ring = ad->readback;
+   Eina_Bool fences = ad->use_fences;
+   unsigned long allocs;
+   double t, finish_wait;
+   int i;
+
+   ad->verbose = EINA_FALSE;
+
+   ad->readback = NULL;
+   ad->use_fences = EINA_FALSE;
+   allocs = ad->frame_buffers.allocs;
+   ad->gpu_wait = 0.0;
+   t = ecore_time_get();
+   for (i = 0; i < frames; i++)
+      draw_both(ad);
+   t = ecore_time_get() - t;
+   finish_wait = ad->gpu_wait;
+   printf("sync readback (glFinish): %d frames in %.3f s, %.1f comparisons/s, "
+          "%.3f ms/frame blocked on the GPU, %lu heap allocations\n",
+          frames, t, frames / t, finish_wait * 1000.0 / frames,
+          ad->frame_buffers.allocs - allocs);
+
+   if (fences) {
+      ad->use_fences = EINA_TRUE;
+      ad->gpu_wait = 0.0;
+      t = ecore_time_get();
+      for (i = 0; i < frames; i++)
+         draw_both(ad);
+      t = ecore_time_get() - t;
+      printf("sync readback (fences): %d frames in %.3f s, %.1f comparisons/s, "
+             "%.3f ms/frame blocked on the GPU, %.3f ms/frame of CPU time recovered\n",
+             frames, t, frames / t, ad->gpu_wait * 1000.0 / frames,
+             (finish_wait - ad->gpu_wait) * 1000.0 / frames);
+   }
+   else {
+      printf("sync readback (fences): no fence sync on this context\n");
+   }
 
-   free(wbuf);
-   free(pbuf);
+   ad->readback = ring;
+   if (ad->readback) {
+      t = ecore_time_get();
+      for (i = 0; i < frames; i++)
+         draw_both(ad);
+      t = ecore_time_get() - t;
+      printf("async readback (%d PBOs deep): %d frames in %.3f s, %.1f comparisons/s\n",
+             readback_depth(ad->readback), frames, t, frames / t);
+   }
+   else {
+      printf("async readback: not available on a GLES 1.x context\n");
+   }
 
-   view_rotx++;
-   view_roty++;
-   view_rotz++;
+   ad->use_fences = fences;
+   ad->verbose = EINA_TRUE;
+   elm_exit();
 }
 
-/* new window size or exposure */
+/* viewport and projection of the current context */
 static void
-reshape(int width, int height)
+set_view(appdata_s *ad, int width, int height)
 {
-   printf("reshape(w %d, h %d)\n", width, height);
-   EVAS_GL_API_USE(evas_gl);
+   Evas_GL_API *api = ad->glapi;
    GLfloat ar = (GLfloat) width / (GLfloat) height;
 
-   WinWidth = width;
-   WinHeight = height;
+   api->glViewport(0, 0, (GLint) width, (GLint) height);
 
-   __evas_gl_glapi->glViewport(0, 0, (GLint) width, (GLint) height);
+   if (ad->use_gles3) {
+      mat4_frustum(ad->projection, -ar, ar, -1, 1, 5.0, 60.0);
+      mat4_identity(ad->modelview);
+      ad->modelview[14] = -15.0;
+      return;
+   }
 
-   __evas_gl_glapi->glMatrixMode(GL_PROJECTION);
-   __evas_gl_glapi->glLoadIdentity();
+   api->glMatrixMode(GL_PROJECTION);
+   api->glLoadIdentity();
 
-   __evas_gl_glapi->glFrustumf(-ar, ar, -1, 1, 5.0, 60.0);
+   api->glFrustumf(-ar, ar, -1, 1, 5.0, 60.0);
    
-   __evas_gl_glapi->glMatrixMode(GL_MODELVIEW);
-   __evas_gl_glapi->glLoadIdentity();
-   __evas_gl_glapi->glTranslatef(0.0, 0.0, -15.0);
+   api->glMatrixMode(GL_MODELVIEW);
+   api->glLoadIdentity();
+   api->glTranslatef(0.0, 0.0, -15.0);
 }
 
 
+/* new window size or exposure */
 static void
-make_texture(void)
+reshape(appdata_s *ad, int width, int height)
 {
-   EVAS_GL_API_USE(evas_gl);
+   printf("reshape(w %d, h %d)\n", width, height);
+
+   ad->width = width;
+   ad->height = height;
+
+   if (ad->readback)
+      readback_resize(ad->readback, width, height);
+   if (frame_arena_reserve(&ad->frame_buffers, 2 * (width * height * 4 + FRAME_ARENA_ALIGN)))
+      printf("frame buffers: reserved %zu bytes for %dx%d\n", ad->frame_buffers.size, width, height);
+
+   if (ad->pbuffer_pool) {
+      Evas_GL_Surface *surface;
+
+      surface = pbuffer_pool_resize(ad->pbuffer_pool, ad->evas_gl_pbuffer_surface, width, height);
+      ad->pbuffer_short = !surface;
+      if (!surface) {
+         printf("Error: no pbuffer for %dx%d, keeping the old one and not comparing\n",
+                width, height);
+      }
+      else if (surface != ad->evas_gl_pbuffer_surface) {
+         ad->evas_gl_pbuffer_surface = surface;
+         pbuffer_pool_report(ad->pbuffer_pool);
+      }
+   }
+
+   set_view(ad, width, height);
+   if (ad->evas_gl_pbuffer_context != ad->evas_gl_context) {
+      evas_gl_make_current(ad->evas_gl, ad->evas_gl_pbuffer_surface, ad->evas_gl_pbuffer_context);
+      set_view(ad, width, height);
+      evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context);
+   }
+}
+
+
+static void
+make_texture(appdata_s *ad)
+{
+   Evas_GL_API *api = ad->glapi;
 #define SZ 64
    GLenum Filter = GL_LINEAR;
    GLubyte image[SZ][SZ][4];
    GLuint i, j;
    GLuint tex;
 
+   if (ad->share && (tex = gl_share_get(ad->share, "torus texture"))) {
+      api->glActiveTexture(GL_TEXTURE0);
+      api->glBindTexture(GL_TEXTURE_2D, tex);
+      return;
+   }
+
    for (i = 0; i < SZ; i++) {
       for (j = 0; j < SZ; j++) {
          GLfloat d = (i - SZ/2) * (i - SZ/2) + (j - SZ/2) * (j - SZ/2);
@@ -266,65 +773,352 @@ make_texture(void)
       }
    }
 
-   __evas_gl_glapi->glActiveTexture(GL_TEXTURE0); /* unit 0 */
-   __evas_gl_glapi->glGenTextures(1, &tex);
-   __evas_gl_glapi->glBindTexture(GL_TEXTURE_2D, tex);
-   __evas_gl_glapi->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SZ, SZ, 0,
+   if (ad->share) {
+      tex = gl_share_texture(ad->share, "torus texture", SZ, SZ, image, Filter, GL_REPEAT);
+      api->glActiveTexture(GL_TEXTURE0);
+      api->glBindTexture(GL_TEXTURE_2D, tex);
+      return;
+   }
+
+   api->glActiveTexture(GL_TEXTURE0); /* unit 0 */
+   api->glGenTextures(1, &tex);
+   api->glBindTexture(GL_TEXTURE_2D, tex);
+   api->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SZ, SZ, 0,
                 GL_RGBA, GL_UNSIGNED_BYTE, image);
-   __evas_gl_glapi->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, Filter);
-   __evas_gl_glapi->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, Filter);
-   __evas_gl_glapi->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-   __evas_gl_glapi->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+   api->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, Filter);
+   api->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, Filter);
+   api->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+   api->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 #undef SZ
 }
 
 
 
+static GLuint
+load_shader(Evas_GL_API *api, GLenum type, const char *src)
+{
+   GLuint shader;
+   GLint compiled;
+
+   shader = api->glCreateShader(type);
+   api->glShaderSource(shader, 1, &src, NULL);
+   api->glCompileShader(shader);
+   api->glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+   if (!compiled) {
+      char log[512];
+      api->glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+      printf("Error compiling shader:\n%s\n", log);
+   }
+
+   return shader;
+}
+
+
+static void
+init_es3(appdata_s *ad)
+{
+   Evas_GL_API *api = ad->glapi;
+   GLuint vtx, fgmt;
+   const char *depth = getenv("PBUFFER_PBO_DEPTH");
+
+   /* program objects are shared along with textures and buffers */
+   if (!ad->es3_program) {
+      vtx = load_shader(api, GL_VERTEX_SHADER, es3_vertex_shader);
+      fgmt = load_shader(api, GL_FRAGMENT_SHADER, es3_fragment_shader);
+      ad->es3_program = api->glCreateProgram();
+      api->glAttachShader(ad->es3_program, vtx);
+      api->glAttachShader(ad->es3_program, fgmt);
+      api->glLinkProgram(ad->es3_program);
+      api->glDeleteShader(vtx);
+      api->glDeleteShader(fgmt);
+
+      ad->es3_mvp_loc = api->glGetUniformLocation(ad->es3_program, "u_mvp");
+      ad->es3_mv_loc = api->glGetUniformLocation(ad->es3_program, "u_modelview");
+   }
+
+   build_torus_vbo(ad, 1.0, 3.0);
+
+   api->glClearColor(0.4, 0.4, 0.4, 1.0);
+   api->glEnable(GL_DEPTH_TEST);
+
+   make_texture(ad);
+
+   if (!ad->readback)
+      ad->readback = readback_new(api, 2, depth ? atoi(depth) : 3,
+                                  ad->width, ad->height);
+}
+
+
+static void
+init_differ(appdata_s *ad)
+{
+   const char *tolerance = getenv("PBUFFER_TOLERANCE");
+   unsigned int r = 0, g = 0, b = 0, a = 0;
+
+   ad->differ = image_diff_new(0);
+   if (!ad->differ) {
+      printf("Error: image comparator could not be created\n");
+      return;
+   }
+
+   if (tolerance) {
+      if (sscanf(tolerance, "%u,%u,%u,%u", &r, &g, &b, &a) == 1)
+         g = b = a = r;
+      if (r > 255) r = 255;
+      if (g > 255) g = 255;
+      if (b > 255) b = 255;
+      if (a > 255) a = 255;
+      image_diff_tolerance_set(ad->differ, r, g, b, a);
+      printf("comparison tolerance: r %u g %u b %u a %u\n", r, g, b, a);
+   }
+
+   heatmap_path = getenv("PBUFFER_HEATMAP");
+}
+
+
+/* state of the current context */
 static void
-init(void)
+init_context(appdata_s *ad)
 {
-   EVAS_GL_API_USE(evas_gl);
+   Evas_GL_API *api = ad->glapi;
    static const GLfloat red[4] = {1, 0, 0, 0};
    static const GLfloat white[4] = {1.0, 1.0, 1.0, 1.0};
    static const GLfloat diffuse[4] = {0.7, 0.7, 0.7, 1.0};
    static const GLfloat specular[4] = {0.001, 0.001, 0.001, 1.0};
    static const GLfloat pos[4] = {20, 20, 50, 1};
 
-   __evas_gl_glapi->glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, red);
-   __evas_gl_glapi->glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, white);
-   __evas_gl_glapi->glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, 9.0);
+   if (ad->use_gles3) {
+      init_es3(ad);
+      return;
+   }
+
+   api->glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, red);
+   api->glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, white);
+   api->glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, 9.0);
+
+   api->glEnable(GL_LIGHTING);
+   api->glEnable(GL_LIGHT0);
+   api->glLightfv(GL_LIGHT0, GL_POSITION, pos);
+   api->glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse);
+   api->glLightfv(GL_LIGHT0, GL_SPECULAR, specular);
+
+   api->glClearColor(0.4, 0.4, 0.4, 1.0);
+   api->glEnable(GL_DEPTH_TEST);
+
+   make_texture(ad);
+   api->glEnable(GL_TEXTURE_2D);
+}
+
+
+static void
+init(appdata_s *ad)
+{
+   Evas_GL_API *api = ad->glapi;
 
-   __evas_gl_glapi->glEnable(GL_LIGHTING);
-   __evas_gl_glapi->glEnable(GL_LIGHT0);
-   __evas_gl_glapi->glLightfv(GL_LIGHT0, GL_POSITION, pos);
-   __evas_gl_glapi->glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse);
-   __evas_gl_glapi->glLightfv(GL_LIGHT0, GL_SPECULAR, specular);
+   init_differ(ad);
+   init_context(ad);
 
-   __evas_gl_glapi->glClearColor(0.4, 0.4, 0.4, 1.0);
-   __evas_gl_glapi->glEnable(GL_DEPTH_TEST);
+   ad->use_fences = !getenv("PBUFFER_FINISH") && gpu_fence_supported(api);
+   printf("frame completion: %s\n", ad->use_fences ? "fences" : "glFinish");
 
-   make_texture();
-   __evas_gl_glapi->glEnable(GL_TEXTURE_2D);
+   if (ad->evas_gl_pbuffer_context != ad->evas_gl_context) {
+      evas_gl_make_current(ad->evas_gl, ad->evas_gl_pbuffer_surface, ad->evas_gl_pbuffer_context);
+      init_context(ad);
+      evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context);
+   }
+
+   if (ad->share)
+      gl_share_report(ad->share);
+}
+
+
+/* PBUFFER_FARM=<threads> renders PBUFFER_FARM_FRAMES frames (default 360,
+ * one degree apart) on that many threads, 0 for one per core, then quits.
+ * Every thread has its own context and pbuffer; a writer thread saves the
+ * frames to PBUFFER_FARM_DIR (default "farm") as they come in.  The
+ * contexts get the texture and mesh through the share manager, so the
+ * farm needs SHARE_CONTEXTS as well.
+ */
+#define FARM_MAX_THREADS 16
+
+typedef struct _Farm_Worker Farm_Worker;
+
+struct _Farm_Worker {
+   appdata_s *ad;
+   Eina_Thread tid;
+   Evas_GL_Context *context;
+   Evas_GL_Surface *surface;
+   Eina_Bool started;
+   int frames;
+   double busy;
+};
+
+static void *
+farm_worker(void *data, Eina_Thread t EINA_UNUSED)
+{
+   Farm_Worker *w = data;
+   appdata_s *ad = w->ad;
+   Evas_GL_API *api = ad->glapi;
+   unsigned char *pixels;
+   double t0;
+   int frame;
+
+   if (!evas_gl_make_current(ad->evas_gl, w->surface, w->context)) {
+      printf("Error: eglMakeCurrent(farm pbuffer) failed\n");
+      return NULL;
+   }
+
+   while ((frame = __sync_fetch_and_add(&ad->farm_next, 1)) < ad->farm_frames) {
+      pixels = frame_writer_acquire(ad->farm_writer);
+
+      t0 = ecore_time_get();
+      draw_view(ad, frame, frame, frame);
+      api->glReadPixels(0, 0, ad->width, ad->height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+      w->busy += ecore_time_get() - t0;
+
+      frame_writer_submit(ad->farm_writer, pixels, frame);
+      w->frames++;
+   }
+
+   evas_gl_make_current(ad->evas_gl, NULL, NULL);
+   return NULL;
+}
+
+static void
+farm(appdata_s *ad, int threads, int frames)
+{
+   Evas_GL_API *api = ad->glapi;
+   Farm_Worker workers[FARM_MAX_THREADS];
+   Evas_GL_Config *evas_gl_config;
+   const char *dir = getenv("PBUFFER_FARM_DIR");
+   double start, t, drained;
+   int i, n;
+
+   if (threads <= 0)
+      threads = eina_cpu_count();
+   if (threads > FARM_MAX_THREADS)
+      threads = FARM_MAX_THREADS;
+
+   /* the worker contexts need the window context's program and objects;
+    * a share made here would upload them a second time */
+   if (!ad->share) {
+      printf("render farm: needs SHARE_CONTEXTS and shared contexts\n");
+      elm_exit();
+      return;
+   }
+
+   evas_gl_config = evas_gl_config_new();
+   evas_gl_config->color_format = EVAS_GL_NO_FBO;
+   evas_gl_config->depth_bits = EVAS_GL_DEPTH_BIT_8;
+   evas_gl_config->stencil_bits = EVAS_GL_STENCIL_NONE;
+   evas_gl_config->options_bits = EVAS_GL_OPTIONS_NONE;
+
+   /* set every context up here, the threads only render */
+   memset(workers, 0, sizeof(workers));
+   for (n = 0; n < threads; n++) {
+      Farm_Worker *w = &workers[n];
+
+      w->ad = ad;
+
+      w->surface = evas_gl_pbuffer_surface_create(ad->evas_gl, evas_gl_config, ad->width, ad->height, NULL);
+      if (w->surface)
+         w->context = gl_share_context_add(ad->share);
+      if (!w->context || !evas_gl_make_current(ad->evas_gl, w->surface, w->context)) {
+         if (w->surface)
+            evas_gl_surface_destroy(ad->evas_gl, w->surface);
+         break;
+      }
+      init_context(ad);
+      set_view(ad, ad->width, ad->height);
+      api->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+   }
+   evas_gl_config_free(evas_gl_config);
+
+   /* a context can only be current in one thread */
+   evas_gl_make_current(ad->evas_gl, NULL, NULL);
+
+   ad->farm_writer = frame_writer_new(dir ? dir : "farm", "pbuffer", ad->width, ad->height, n * 2);
+   if (!n || !ad->farm_writer) {
+      printf("render farm: could not set up %d pbuffer contexts\n", threads);
+      goto end;
+   }
+
+   ad->farm_next = 0;
+   ad->farm_frames = frames;
+
+   start = ecore_time_get();
+   for (i = 0; i < n; i++)
+      workers[i].started = eina_thread_create(&workers[i].tid, EINA_THREAD_NORMAL, -1,
+                                              farm_worker, &workers[i]);
+   for (i = 0; i < n; i++) {
+      if (workers[i].started)
+         eina_thread_join(workers[i].tid);
+   }
+   t = ecore_time_get() - start;
+
+   frame_writer_free(ad->farm_writer);
+   ad->farm_writer = NULL;
+   drained = ecore_time_get() - start;
+
+   for (i = 0; i < n; i++) {
+      printf("  thread %d: %d frames, %.3f s rendering\n",
+             i, workers[i].frames, workers[i].busy);
+   }
+   printf("render farm: %d threads, %d frames of %dx%d in %.3f s, %.1f frames/s, all written after %.3f s\n",
+          n, frames, ad->width, ad->height, t, frames / t, drained);
+   gl_share_report(ad->share);
+
+end:
+   frame_writer_free(ad->farm_writer);
+   ad->farm_writer = NULL;
+   for (i = 0; i < n; i++)
+      evas_gl_surface_destroy(ad->evas_gl, workers[i].surface);
+   evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context);
+   elm_exit();
 }
 
 
 
 void on_pixels(void *data, Evas_Object *o)
 {
-   static int frame = 0;   
+   appdata_s *ad = data;
 
-   evas_gl_make_current(evas_gl, evas_gl_surface, evas_gl_context);
+   frame_stats_frame(ad->frame_stats);
+   bench_draw_begin(ad->frame_bench);
+   perf_counters_begin(ad->perf_counters);
+   evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context);
 
-   if (frame == 0)
+   if (ad->frame == 0)
    {
-      init();
-      reshape(WinWidth, WinHeight);
+      const char *frames = getenv("PBUFFER_BENCH");
+
+      init(ad);
+      reshape(ad, ad->width, ad->height);
+
+      if (frames)
+         bench(ad, atoi(frames));
+
+      if (getenv("PBUFFER_FARM")) {
+         frames = getenv("PBUFFER_FARM_FRAMES");
+         farm(ad, atoi(getenv("PBUFFER_FARM")), frames ? atoi(frames) : 360);
+      }
    }
 
    
-   draw_both();
+   draw_both(ad);
+
+   /* a frame that compared has ended it already */
+   perf_counters_end(ad->perf_counters);
+   /* the GL wrappers take the first instance's frames for the process' */
+   if (ad->id == 0) {
+      gl_profile_frame();
+      gl_trace_frame();
+      gl_redundant_frame();
+   }
+   if (!bench_draw_end(ad->frame_bench))
+      elm_exit();
 
-   frame++;
+   ad->frame++;
 }
 
 static Eina_Bool anim(void *data) {
@@ -334,18 +1128,30 @@ static Eina_Bool anim(void *data) {
 
 static void del_anim(void *data, Evas *evas, Evas_Object *obj, void *event_info)
 {
+   appdata_s *ad = evas_object_data_get(obj, "ad");
    Ecore_Animator *ani = evas_object_data_get(obj, "ani");
    ecore_animator_del(ani);
+
+   /* the evas, and the Evas_GL with it, are still alive here */
+   evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context);
+   readback_free(ad->readback);
+   ad->readback = NULL;
+   gl_share_free(ad->share);
+   ad->share = NULL;
+   pbuffer_pool_free(ad->pbuffer_pool);
+   ad->pbuffer_pool = NULL;
 }
 
 static void
 _win_resize_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *obj, void *event_info EINA_UNUSED)
 {
+   appdata_s *ad = data;
    float aspect;
    Evas_Coord w,h;
    evas_object_geometry_get( obj, NULL, NULL, &w, &h);
 
-   reshape(w, h);
+   evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context);
+   reshape(ad, w, h);
 }
 
 static Evas_Object* add_win(const char *name) {
@@ -384,6 +1190,10 @@ static Eina_Bool app_create(void *data) {
    if (!data)
       return EINA_FALSE;
 
+   ad->width = WinWidth;
+   ad->height = WinHeight;
+   ad->verbose = EINA_TRUE;
+
    /* Create the window */
    ad->win = add_win(ad->name);
 
@@ -392,34 +1202,58 @@ static Eina_Bool app_create(void *data) {
 
    e = evas_object_evas_get(ad->win);
    gl = evas_object_image_filled_add(e);
-   evas_object_image_size_set(gl, WinWidth, WinHeight);
+   evas_object_image_size_set(gl, ad->width, ad->height);
    evas_object_image_alpha_set(gl, EINA_FALSE);
    evas_object_size_hint_align_set(gl, EVAS_HINT_FILL, EVAS_HINT_FILL);
    evas_object_size_hint_weight_set(gl, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
-   evas_object_resize(gl, WinWidth, WinHeight);
+   evas_object_resize(gl, ad->width, ad->height);
    evas_object_show(gl);
 
-   evas_gl = evas_gl_new(e);
+   ad->evas_gl = evas_gl_new(e);
    evas_gl_config = evas_gl_config_new();
    evas_gl_config->color_format = EVAS_GL_RGBA_8888;
    evas_gl_config->depth_bits = EVAS_GL_DEPTH_BIT_8;
    evas_gl_config->stencil_bits = EVAS_GL_STENCIL_NONE;
-   evas_gl_config->options_bits = EVAS_GL_OPTIONS_DIRECT;
-   evas_gl_surface = evas_gl_surface_create(evas_gl, evas_gl_config, WinWidth, WinHeight);
-   evas_gl_context = evas_gl_context_version_create(evas_gl, NULL, EVAS_GL_GLES_1_X);
+   evas_gl_config->options_bits = direct ? EVAS_GL_OPTIONS_DIRECT : EVAS_GL_OPTIONS_NONE;
+   ad->evas_gl_surface = evas_gl_surface_create(ad->evas_gl, evas_gl_config, ad->width, ad->height);
+   if (getenv("GLES3")) {
+      ad->evas_gl_context = evas_gl_context_version_create(ad->evas_gl, NULL, EVAS_GL_GLES_3_X);
+      if (ad->evas_gl_context)
+         ad->use_gles3 = EINA_TRUE;
+      else
+         printf("GLES 3.x context not available, falling back to GLES 1.x\n");
+   }
+   if (!ad->evas_gl_context)
+      ad->evas_gl_context = evas_gl_context_version_create(ad->evas_gl, NULL, EVAS_GL_GLES_1_X);
    evas_gl_config_free(evas_gl_config);
+   ad->glapi = gl_redundant_api(gl_profile_api(gl_trace_api(evas_gl_context_api_get(ad->evas_gl, ad->evas_gl_context))));
+
+   ad->evas_gl_pbuffer_context = ad->evas_gl_context;
+   if (getenv("SHARE_CONTEXTS")) {
+      ad->share = gl_share_new(ad->evas_gl, ad->evas_gl_context,
+                               ad->use_gles3 ? EVAS_GL_GLES_3_X : EVAS_GL_GLES_1_X);
+      if (ad->share)
+         ad->evas_gl_pbuffer_context = gl_share_context_add(ad->share);
+      if (!ad->evas_gl_pbuffer_context) {
+         printf("shared pbuffer context not available, using the window context\n");
+         ad->evas_gl_pbuffer_context = ad->evas_gl_context;
+      }
+   }
 
    evas_gl_config = evas_gl_config_new();
    evas_gl_config->color_format = EVAS_GL_NO_FBO;
    evas_gl_config->depth_bits = EVAS_GL_DEPTH_BIT_8;
    evas_gl_config->stencil_bits = EVAS_GL_STENCIL_NONE;
    evas_gl_config->options_bits = EVAS_GL_OPTIONS_NONE;
-   evas_gl_pbuffer_surface = evas_gl_pbuffer_surface_create(evas_gl, evas_gl_config, WinWidth, WinHeight, NULL);
+   ad->pbuffer_pool = pbuffer_pool_new(ad->evas_gl, evas_gl_config, PBUFFER_BUCKET, PBUFFER_IDLE_TIMEOUT);
+   if (ad->pbuffer_pool)
+      ad->evas_gl_pbuffer_surface = pbuffer_pool_acquire(ad->pbuffer_pool, ad->width, ad->height);
+   evas_gl_config_free(evas_gl_config);
 
    Evas_Native_Surface ns;
-   evas_gl_native_surface_get(evas_gl, evas_gl_surface, &ns);
+   evas_gl_native_surface_get(ad->evas_gl, ad->evas_gl_surface, &ns);
    evas_object_image_native_surface_set(gl, &ns);
-   evas_object_image_pixels_get_callback_set(gl, on_pixels, NULL);
+   evas_object_image_pixels_get_callback_set(gl, on_pixels, ad);
 
    evas_object_show(gl);
 
@@ -433,7 +1267,7 @@ static Eina_Bool app_create(void *data) {
    evas_object_data_set(gl, "ani", ani);
    evas_object_data_set(gl, "ad", ad);
    evas_object_event_callback_add(gl, EVAS_CALLBACK_DEL, del_anim, gl);
-   evas_object_event_callback_add(gl, EVAS_CALLBACK_RESIZE, _win_resize_cb, NULL);
+   evas_object_event_callback_add(gl, EVAS_CALLBACK_RESIZE, _win_resize_cb, ad);
 
    evas_object_show(ad->win);
 
@@ -444,11 +1278,43 @@ static Eina_Bool app_create(void *data) {
 EAPI_MAIN int
 elm_main(int argc, char **argv)
 {
-   appdata_s ad = {0,};
-   app_create(&ad);
+   appdata_s *ads, *ad;
+   const char *name;
+   int i, n, status;
+
+   bench_size(&WinWidth, &WinHeight);
+   direct = bench_direct(EINA_TRUE);
+   n = bench_instances();
+
+   ads = calloc(n, sizeof(appdata_s));
+   if (!ads)
+      return 1;
+
+   for (i = 0; i < n; i++) {
+      ads[i].id = i;
+      app_create(&ads[i]);
+   }
+
+   ad = &ads[0];
+   /* the shader path does not render the same pixels as fixed function */
+   name = ad->use_gles3 ? "pbuffer-gles3" : "pbuffer";
+   bench_api_lookup(name, ad->evas_gl, ad->evas_gl_context, ad->glapi);
+   ad->golden = golden_new(name);
+   ad->frame_bench = bench_new(name, ad->win, direct);
+   ad->frame_stats = frame_stats_new(name);
+   ad->perf_counters = perf_counters_new(name);
 
    elm_run();
+   perf_counters_free(ad->perf_counters);
+   frame_stats_free(ad->frame_stats);
+   bench_finish(ad->frame_bench);
+   status = golden_finish(ad->golden);
+   for (i = 0; i < n; i++) {
+      image_diff_free(ads[i].differ);
+      frame_arena_release(&ads[i].frame_buffers);
+   }
+   free(ads);
    elm_shutdown();
-   return 0;
+   return status;
 }
 ELM_MAIN()
@@ -0,0 +1,262 @@
+/*
+ * texconv - writes textures in the tex_file container (see tex_file.h).
+ *
+ *   texconv [-m] [-f rgba8888|rgba4444|rgb565] <input> <output>
+ *
+ * <input> is builtin:565 or builtin:4444 for the images compiled into
+ * glviewcube11, or a P7 RGB_ALPHA PAM file such as the golden store
+ * writes.  The format defaults to the builtin image's own, RGBA 8888 for
+ * PAM input.  -m adds the mip chain down to 1x1, box filtered.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <Evas_GL.h>
+#include "tex_file.h"
+
+extern const unsigned short IMAGE_565_128_128_1[];
+extern const unsigned short IMAGE_4444_128_128_1[];
+
+typedef enum {
+   FORMAT_NONE,
+   FORMAT_RGBA8888,
+   FORMAT_RGBA4444,
+   FORMAT_RGB565
+} Format;
+
+static unsigned char *
+unpack(const unsigned short *src, int w, int h, Format format)
+{
+   unsigned char *rgba, *d;
+   int i;
+
+   rgba = malloc((size_t)w * h * 4);
+   if (!rgba)
+      return NULL;
+
+   for (i = 0, d = rgba; i < w * h; i++, d += 4) {
+      unsigned p = src[i];
+
+      if (format == FORMAT_RGBA4444) {
+         d[0] = ((p >> 12) & 0xf) * 17;
+         d[1] = ((p >> 8) & 0xf) * 17;
+         d[2] = ((p >> 4) & 0xf) * 17;
+         d[3] = (p & 0xf) * 17;
+      }
+      else {
+         d[0] = ((p >> 11) & 0x1f) * 255 / 31;
+         d[1] = ((p >> 5) & 0x3f) * 255 / 63;
+         d[2] = (p & 0x1f) * 255 / 31;
+         d[3] = 255;
+      }
+   }
+
+   return rgba;
+}
+
+static unsigned char *
+pam_read(const char *path, int *w, int *h)
+{
+   unsigned char *rgba = NULL;
+   size_t len;
+   FILE *f;
+
+   f = fopen(path, "rb");
+   if (!f)
+      return NULL;
+
+   if (fscanf(f, "P7 WIDTH %d HEIGHT %d DEPTH 4 MAXVAL 255 TUPLTYPE RGB_ALPHA ENDHDR", w, h) == 2 &&
+       fgetc(f) == '\n' && *w > 0 && *h > 0) {
+      len = (size_t)*w * *h * 4;
+      rgba = malloc(len);
+      if (rgba && fread(rgba, 1, len, f) != len) {
+         free(rgba);
+         rgba = NULL;
+      }
+   }
+
+   fclose(f);
+   return rgba;
+}
+
+/* Packs w x h RGBA 8888 pixels into out, returns the byte count. */
+static size_t
+pack(const unsigned char *rgba, int w, int h, Format format, void *out)
+{
+   unsigned short *d16 = out;
+   int i;
+
+   if (format == FORMAT_RGBA8888) {
+      memcpy(out, rgba, (size_t)w * h * 4);
+      return (size_t)w * h * 4;
+   }
+
+   for (i = 0; i < w * h; i++, rgba += 4) {
+      if (format == FORMAT_RGBA4444)
+         d16[i] = ((rgba[0] >> 4) << 12) | ((rgba[1] >> 4) << 8) |
+                  ((rgba[2] >> 4) << 4) | (rgba[3] >> 4);
+      else
+         d16[i] = ((rgba[0] >> 3) << 11) | ((rgba[1] >> 2) << 5) | (rgba[2] >> 3);
+   }
+
+   return (size_t)w * h * 2;
+}
+
+/* 2x2 box filter into a new w/2 x h/2 image, in place. */
+static void
+downsample(unsigned char *rgba, int w, int h, int *nw, int *nh)
+{
+   int x, y, c, sx, sy;
+
+   *nw = w > 1 ? w / 2 : 1;
+   *nh = h > 1 ? h / 2 : 1;
+
+   for (y = 0; y < *nh; y++) {
+      for (x = 0; x < *nw; x++) {
+         for (c = 0; c < 4; c++) {
+            unsigned sum = 0;
+
+            for (sy = 0; sy < 2; sy++)
+               for (sx = 0; sx < 2; sx++) {
+                  int px = x * 2 + sx < w ? x * 2 + sx : w - 1;
+                  int py = y * 2 + sy < h ? y * 2 + sy : h - 1;
+
+                  sum += rgba[((size_t)py * w + px) * 4 + c];
+               }
+            /* the destination never overtakes the source rows it reads */
+            rgba[((size_t)y * *nw + x) * 4 + c] = (sum + 2) / 4;
+         }
+      }
+   }
+}
+
+static int
+write_file(const char *path, unsigned char *rgba, int w, int h, Format format, int mips)
+{
+   static const unsigned char pad[4];
+   Tex_File_Header header;
+   void *level;
+   uint32_t size;
+   FILE *f;
+   int n = 0, lw = w, lh = h;
+
+   level = malloc((size_t)w * h * 4);
+   f = fopen(path, "wb");
+   if (!level || !f) {
+      fprintf(stderr, "texconv: cannot write %s\n", path);
+      free(level);
+      if (f)
+         fclose(f);
+      return 1;
+   }
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, TEX_FILE_MAGIC, 8);
+   header.endianness = TEX_FILE_ENDIANNESS;
+   header.width = w;
+   header.height = h;
+   switch (format) {
+   case FORMAT_RGBA4444:
+      header.gl_type = GL_UNSIGNED_SHORT_4_4_4_4;
+      header.gl_format = header.gl_internal_format = GL_RGBA;
+      break;
+   case FORMAT_RGB565:
+      header.gl_type = GL_UNSIGNED_SHORT_5_6_5;
+      header.gl_format = header.gl_internal_format = GL_RGB;
+      break;
+   default:
+      header.gl_type = GL_UNSIGNED_BYTE;
+      header.gl_format = header.gl_internal_format = GL_RGBA;
+      break;
+   }
+
+   header.levels = 1;
+   if (mips) {
+      while ((lw > 1 || lh > 1) && header.levels < TEX_FILE_MAX_LEVELS) {
+         lw = lw > 1 ? lw / 2 : 1;
+         lh = lh > 1 ? lh / 2 : 1;
+         header.levels++;
+      }
+      lw = w;
+      lh = h;
+   }
+   fwrite(&header, sizeof(header), 1, f);
+
+   for (n = 0; n < (int)header.levels; n++) {
+      size = pack(rgba, lw, lh, format, level);
+      fwrite(&size, 4, 1, f);
+      fwrite(level, 1, size, f);
+      fwrite(pad, 1, (4 - size % 4) % 4, f);
+      if (n + 1 < (int)header.levels)
+         downsample(rgba, lw, lh, &lw, &lh);
+   }
+
+   free(level);
+   if (fclose(f)) {
+      fprintf(stderr, "texconv: cannot write %s\n", path);
+      return 1;
+   }
+
+   printf("%s: %dx%d, %u levels\n", path, w, h, header.levels);
+   return 0;
+}
+
+static void
+usage(void)
+{
+   fprintf(stderr, "usage: texconv [-m] [-f rgba8888|rgba4444|rgb565] <builtin:565|builtin:4444|file.pam> <output>\n");
+   exit(2);
+}
+
+int
+main(int argc, char **argv)
+{
+   Format format = FORMAT_NONE, source;
+   unsigned char *rgba;
+   int i, mips = 0, w, h, ret;
+
+   for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+      if (!strcmp(argv[i], "-m"))
+         mips = 1;
+      else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+         i++;
+         if (!strcmp(argv[i], "rgba8888"))
+            format = FORMAT_RGBA8888;
+         else if (!strcmp(argv[i], "rgba4444"))
+            format = FORMAT_RGBA4444;
+         else if (!strcmp(argv[i], "rgb565"))
+            format = FORMAT_RGB565;
+         else
+            usage();
+      }
+      else
+         usage();
+   }
+   if (argc - i != 2)
+      usage();
+
+   if (!strcmp(argv[i], "builtin:565")) {
+      source = FORMAT_RGB565;
+      w = h = 128;
+      rgba = unpack(IMAGE_565_128_128_1, w, h, source);
+   }
+   else if (!strcmp(argv[i], "builtin:4444")) {
+      source = FORMAT_RGBA4444;
+      w = h = 128;
+      rgba = unpack(IMAGE_4444_128_128_1, w, h, source);
+   }
+   else {
+      source = FORMAT_RGBA8888;
+      rgba = pam_read(argv[i], &w, &h);
+   }
+   if (!rgba) {
+      fprintf(stderr, "texconv: cannot read %s\n", argv[i]);
+      return 1;
+   }
+
+   ret = write_file(argv[i + 1], rgba, w, h, format != FORMAT_NONE ? format : source, mips);
+   free(rgba);
+
+   return ret;
+}
@@ -15,20 +15,45 @@
 #include <stdio.h>
 #include <Elementary.h>
 #include <Evas_GL.h>
-
-#define EVAS_GL_API_USE(gl) \
-   Evas_GL_API *__evas_gl_glapi = evas_gl_context_api_get(gl, evas_gl_context);
-
-Evas_GL *evas_gl;
-Evas_GL_Surface *evas_gl_surface;
-Evas_GL_Context *evas_gl_context;
+#include "bench.h"
+#include "frame_stats.h"
+#include "gl_profile.h"
+#include "gl_redundant.h"
+#include "gl_trace.h"
+#include "golden.h"
+#include "perf_counters.h"
 
 static int WinWidth = 360, WinHeight = 480;
 
+/* BENCH_SIZE, INSTANCES and DIRECT, see bench.h */
+static Eina_Bool direct = EINA_TRUE;
+
+/* One torus with its own window and Evas GL context */
 typedef struct appdata {
    const char *name;
+   int id;
 
    Evas_Object *win;
+
+   Evas_GL *evas_gl;
+   Evas_GL_Surface *evas_gl_surface;
+   Evas_GL_Context *evas_gl_context;
+
+   /* evas_gl_context's API table, wrapped by GL_PROFILE, GL_TRACE and
+    * GL_REDUNDANT (see gl_profile.h, gl_trace.h and gl_redundant.h) */
+   Evas_GL_API *glapi;
+
+   GLfloat view_rotx, view_roty, view_rotz;
+   GLint tex_format;
+   int frame;
+
+   /* GOLDEN=record|check, BENCH_FRAMES, BENCH_API_LOOKUP, FRAME_STATS and
+    * PERF_COUNTERS of the first instance, see golden.h, bench.h,
+    * frame_stats.h and perf_counters.h */
+   Golden *golden;
+   Bench *bench;
+   Frame_Stats *frame_stats;
+   Perf_Counters *perf_counters;
 } appdata_s;
 
 static const struct {
@@ -50,10 +75,7 @@ static const struct {
 };
 #define NUM_CPAL_FORMATS (sizeof(cpal_formats) / sizeof(cpal_formats[0]))
 
-static GLfloat view_rotx = 0.0, view_roty = 0.0, view_rotz = 0.0;
-static GLint tex_format = NUM_CPAL_FORMATS;
 static GLboolean animate = GL_TRUE;
-static int win;
 
 
 static void
@@ -82,23 +104,24 @@ Texcoord(GLfloat *v, GLfloat s, GLfloat t)
 
 /* Borrowed from glut, adapted */
 static void
-draw_torus(GLfloat r, GLfloat R, GLint nsides, GLint rings)
+draw_torus(Evas_GL_API *api, GLfloat r, GLfloat R, GLint nsides, GLint rings)
 {
-   EVAS_GL_API_USE(evas_gl);
    int i, j;
    GLfloat theta, phi, theta1;
    GLfloat cosTheta, sinTheta;
    GLfloat cosTheta1, sinTheta1;
    GLfloat ringDelta, sideDelta;
-   GLfloat varray[100][3], narray[100][3], tarray[100][2];
+   /* GL reads these only at the draws; zeroing varray quiets
+    * -Wmaybe-uninitialized about handing them over before */
+   GLfloat varray[100][3] = { { 0 } }, narray[100][3], tarray[100][2];
    int vcount;
 
-   __evas_gl_glapi->glVertexPointer(3, GL_FLOAT, 0, varray);
-   __evas_gl_glapi->glNormalPointer(GL_FLOAT, 0, narray);
-   __evas_gl_glapi->glTexCoordPointer(2, GL_FLOAT, 0, tarray);
-   __evas_gl_glapi->glEnableClientState(GL_VERTEX_ARRAY);
-   __evas_gl_glapi->glEnableClientState(GL_NORMAL_ARRAY);
-   __evas_gl_glapi->glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+   api->glVertexPointer(3, GL_FLOAT, 0, varray);
+   api->glNormalPointer(GL_FLOAT, 0, narray);
+   api->glTexCoordPointer(2, GL_FLOAT, 0, tarray);
+   api->glEnableClientState(GL_VERTEX_ARRAY);
+   api->glEnableClientState(GL_NORMAL_ARRAY);
+   api->glEnableClientState(GL_TEXTURE_COORD_ARRAY);
    
    ringDelta = 2.0 * M_PI / rings;
    sideDelta = 2.0 * M_PI / nsides;
@@ -140,61 +163,60 @@ draw_torus(GLfloat r, GLfloat R, GLint nsides, GLint rings)
 
       /*glEnd();*/
       assert(vcount <= 100);
-      __evas_gl_glapi->glDrawArrays(GL_TRIANGLE_STRIP, 0, vcount);
+      api->glDrawArrays(GL_TRIANGLE_STRIP, 0, vcount);
 
       theta = theta1;
       cosTheta = cosTheta1;
       sinTheta = sinTheta1;
    }
 
-   __evas_gl_glapi->glDisableClientState(GL_VERTEX_ARRAY);
-   __evas_gl_glapi->glDisableClientState(GL_NORMAL_ARRAY);
-   __evas_gl_glapi->glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+   api->glDisableClientState(GL_VERTEX_ARRAY);
+   api->glDisableClientState(GL_NORMAL_ARRAY);
+   api->glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 }
 
 
 static void
-draw(void)
+draw(appdata_s *ad)
 {
-   EVAS_GL_API_USE(evas_gl);
-   __evas_gl_glapi->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+   Evas_GL_API *api = ad->glapi;
+
+   api->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-   __evas_gl_glapi->glPushMatrix();
-   __evas_gl_glapi->glRotatef(view_rotx, 1, 0, 0);
-   __evas_gl_glapi->glRotatef(view_roty, 0, 1, 0);
-   __evas_gl_glapi->glRotatef(view_rotz, 0, 0, 1);
-   __evas_gl_glapi->glScalef(0.5, 0.5, 0.5);
+   api->glPushMatrix();
+   api->glRotatef(ad->view_rotx, 1, 0, 0);
+   api->glRotatef(ad->view_roty, 0, 1, 0);
+   api->glRotatef(ad->view_rotz, 0, 0, 1);
+   api->glScalef(0.5, 0.5, 0.5);
 
-   draw_torus(1.0, 3.0, 30, 60);
+   draw_torus(api, 1.0, 3.0, 30, 60);
 
-   __evas_gl_glapi->glPopMatrix();
+   api->glPopMatrix();
 }
 
 
 /* new window size or exposure */
 static void
-reshape(int width, int height)
+reshape(Evas_GL_API *api, int width, int height)
 {
-   EVAS_GL_API_USE(evas_gl);
    GLfloat ar = (GLfloat) width / (GLfloat) height;
 
-   __evas_gl_glapi->glViewport(0, 0, (GLint) width, (GLint) height);
+   api->glViewport(0, 0, (GLint) width, (GLint) height);
 
-   __evas_gl_glapi->glMatrixMode(GL_PROJECTION);
-   __evas_gl_glapi->glLoadIdentity();
+   api->glMatrixMode(GL_PROJECTION);
+   api->glLoadIdentity();
 
-   __evas_gl_glapi->glFrustumf(-ar, ar, -1, 1, 5.0, 60.0);
+   api->glFrustumf(-ar, ar, -1, 1, 5.0, 60.0);
    
-   __evas_gl_glapi->glMatrixMode(GL_MODELVIEW);
-   __evas_gl_glapi->glLoadIdentity();
-   __evas_gl_glapi->glTranslatef(0.0, 0.0, -15.0);
+   api->glMatrixMode(GL_MODELVIEW);
+   api->glLoadIdentity();
+   api->glTranslatef(0.0, 0.0, -15.0);
 }
 
 
 static GLint
-make_cpal_texture(GLint idx)
+make_cpal_texture(Evas_GL_API *api, GLint idx)
 {
-   EVAS_GL_API_USE(evas_gl);
 #define SZ 64
    GLenum internalFormat = GL_PALETTE4_RGB8_OES + idx;
    GLenum Filter = GL_LINEAR;
@@ -291,15 +313,15 @@ make_cpal_texture(GLint idx)
       }
    }
 
-   __evas_gl_glapi->glActiveTexture(GL_TEXTURE0); /* unit 0 */
-   __evas_gl_glapi->glBindTexture(GL_TEXTURE_2D, 42);
-   __evas_gl_glapi->glCompressedTexImage2D(GL_TEXTURE_2D, 0, internalFormat, SZ, SZ, 0,
+   api->glActiveTexture(GL_TEXTURE0); /* unit 0 */
+   api->glBindTexture(GL_TEXTURE_2D, 42);
+   api->glCompressedTexImage2D(GL_TEXTURE_2D, 0, internalFormat, SZ, SZ, 0,
                           image_size, palette);
 
-   __evas_gl_glapi->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, Filter);
-   __evas_gl_glapi->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, Filter);
-   __evas_gl_glapi->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-   __evas_gl_glapi->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+   api->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, Filter);
+   api->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, Filter);
+   api->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+   api->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 #undef SZ
 
    return image_size;
@@ -307,9 +329,8 @@ make_cpal_texture(GLint idx)
 
 
 static GLint
-make_texture(void)
+make_texture(Evas_GL_API *api)
 {
-   EVAS_GL_API_USE(evas_gl);
 #define SZ 64
    GLenum Filter = GL_LINEAR;
    GLubyte image[SZ][SZ][4];
@@ -334,14 +355,14 @@ make_texture(void)
       }
    }
 
-   __evas_gl_glapi->glActiveTexture(GL_TEXTURE0); /* unit 0 */
-   __evas_gl_glapi->glBindTexture(GL_TEXTURE_2D, 42);
-   __evas_gl_glapi->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SZ, SZ, 0,
+   api->glActiveTexture(GL_TEXTURE0); /* unit 0 */
+   api->glBindTexture(GL_TEXTURE_2D, 42);
+   api->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SZ, SZ, 0,
                 GL_RGBA, GL_UNSIGNED_BYTE, image);
-   __evas_gl_glapi->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, Filter);
-   __evas_gl_glapi->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, Filter);
-   __evas_gl_glapi->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-   __evas_gl_glapi->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+   api->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, Filter);
+   api->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, Filter);
+   api->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+   api->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 #undef SZ
 
    return sizeof(image);
@@ -350,44 +371,43 @@ make_texture(void)
 
 
 static void
-init(void)
+init(Evas_GL_API *api)
 {
-   EVAS_GL_API_USE(evas_gl);
    static const GLfloat red[4] = {1, 0, 0, 0};
    static const GLfloat white[4] = {1.0, 1.0, 1.0, 1.0};
    static const GLfloat diffuse[4] = {0.7, 0.7, 0.7, 1.0};
    static const GLfloat specular[4] = {0.001, 0.001, 0.001, 1.0};
    static const GLfloat pos[4] = {20, 20, 50, 1};
 
-   __evas_gl_glapi->glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, red);
-   __evas_gl_glapi->glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, white);
-   __evas_gl_glapi->glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, 9.0);
+   api->glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, red);
+   api->glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, white);
+   api->glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, 9.0);
 
-   __evas_gl_glapi->glEnable(GL_LIGHTING);
-   __evas_gl_glapi->glEnable(GL_LIGHT0);
-   __evas_gl_glapi->glLightfv(GL_LIGHT0, GL_POSITION, pos);
-   __evas_gl_glapi->glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse);
-   __evas_gl_glapi->glLightfv(GL_LIGHT0, GL_SPECULAR, specular);
+   api->glEnable(GL_LIGHTING);
+   api->glEnable(GL_LIGHT0);
+   api->glLightfv(GL_LIGHT0, GL_POSITION, pos);
+   api->glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse);
+   api->glLightfv(GL_LIGHT0, GL_SPECULAR, specular);
 
-   __evas_gl_glapi->glClearColor(0.4, 0.4, 0.4, 0.0);
-   __evas_gl_glapi->glEnable(GL_DEPTH_TEST);
+   api->glClearColor(0.4, 0.4, 0.4, 0.0);
+   api->glEnable(GL_DEPTH_TEST);
 
-   make_texture();
-   __evas_gl_glapi->glEnable(GL_TEXTURE_2D);
+   make_texture(api);
+   api->glEnable(GL_TEXTURE_2D);
 
    /* Enable automatic normalizing to get proper lighting when torus is
     * scaled down via glScalef
     */
-   __evas_gl_glapi->glEnable(GL_NORMALIZE);
+   api->glEnable(GL_NORMALIZE);
 }
 
 
 static void
-idle(void)
+idle(appdata_s *ad)
 {
    if (animate) {
-      view_rotx += 1.0;
-      view_roty += 2.0;
+      ad->view_rotx += 1.0;
+      ad->view_roty += 2.0;
    }
 }
 
@@ -395,35 +415,53 @@ static void
 _change_cb(void *data, Evas_Object *obj EINA_UNUSED,
           void *event_info EINA_UNUSED)
 {
+   appdata_s *ad = data;
    GLint size;
-   tex_format = (tex_format + 1) % (NUM_CPAL_FORMATS + 1);
-   if (tex_format < NUM_CPAL_FORMATS) {
-      size = make_cpal_texture(tex_format);
+   evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context);
+   ad->tex_format = (ad->tex_format + 1) % (NUM_CPAL_FORMATS + 1);
+   if (ad->tex_format < NUM_CPAL_FORMATS) {
+      size = make_cpal_texture(ad->glapi, ad->tex_format);
       printf("Using %s (%d bytes)\n",
-            cpal_formats[tex_format].name, size);
+            cpal_formats[ad->tex_format].name, size);
    }
    else {
-      size = make_texture();
+      size = make_texture(ad->glapi);
       printf("Using uncompressed texture (%d bytes)\n", size);
    }
 }
 
 void on_pixels(void *data, Evas_Object *o)
 {
-   static int frame = 0;   
+   appdata_s *ad = data;
+   Evas_GL_API *api = ad->glapi;
 
-   evas_gl_make_current(evas_gl, evas_gl_surface, evas_gl_context);
+   frame_stats_frame(ad->frame_stats);
+   bench_draw_begin(ad->bench);
+   perf_counters_begin(ad->perf_counters);
+   evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context);
 
-   if (frame == 0)
+   if (ad->frame == 0)
    {
-      init();
-      reshape(WinWidth, WinHeight);
+      init(api);
+      reshape(api, WinWidth, WinHeight);
    }
 
-   idle();
-   draw();
+   idle(ad);
+   draw(ad);
+   perf_counters_end(ad->perf_counters);
+
+   if (!golden_frame(ad->golden, api, WinWidth, WinHeight))
+      elm_exit();
+   /* one frame mark per round of instances */
+   if (ad->id == 0) {
+      gl_profile_frame();
+      gl_trace_frame();
+      gl_redundant_frame();
+   }
+   if (!bench_draw_end(ad->bench))
+      elm_exit();
 
-   frame++;
+   ad->frame++;
 }
 
 static Eina_Bool anim(void *data) {
@@ -440,11 +478,13 @@ static void del_anim(void *data, Evas *evas, Evas_Object *obj, void *event_info)
 static void
 _win_resize_cb(void *data, Evas *e EINA_UNUSED, Evas_Object *obj, void *event_info EINA_UNUSED)
 {
+   appdata_s *ad = data;
    float aspect;
    Evas_Coord w,h;
    evas_object_geometry_get( obj, NULL, NULL, &w, &h);
 
-   reshape(w, h);
+   evas_gl_make_current(ad->evas_gl, ad->evas_gl_surface, ad->evas_gl_context);
+   reshape(ad->glapi, w, h);
 }
 
 static Evas_Object* add_win(const char *name) {
@@ -503,20 +543,23 @@ static Eina_Bool app_create(void *data) {
    elm_box_pack_end(bx, gl);
    evas_object_show(gl);
 
-   evas_gl = evas_gl_new(e);
+   ad->tex_format = NUM_CPAL_FORMATS;
+
+   ad->evas_gl = evas_gl_new(e);
    evas_gl_config = evas_gl_config_new();
    evas_gl_config->color_format = EVAS_GL_RGBA_8888;
    evas_gl_config->depth_bits = EVAS_GL_DEPTH_BIT_8;
    evas_gl_config->stencil_bits = EVAS_GL_STENCIL_NONE;
-   evas_gl_config->options_bits = EVAS_GL_OPTIONS_DIRECT;
-   evas_gl_surface = evas_gl_surface_create(evas_gl, evas_gl_config, WinWidth, WinHeight);
-   evas_gl_context = evas_gl_context_version_create(evas_gl, NULL, EVAS_GL_GLES_1_X);
+   evas_gl_config->options_bits = direct ? EVAS_GL_OPTIONS_DIRECT : EVAS_GL_OPTIONS_NONE;
+   ad->evas_gl_surface = evas_gl_surface_create(ad->evas_gl, evas_gl_config, WinWidth, WinHeight);
+   ad->evas_gl_context = evas_gl_context_version_create(ad->evas_gl, NULL, EVAS_GL_GLES_1_X);
    evas_gl_config_free(evas_gl_config);
+   ad->glapi = gl_redundant_api(gl_profile_api(gl_trace_api(evas_gl_context_api_get(ad->evas_gl, ad->evas_gl_context))));
 
    Evas_Native_Surface ns;
-   evas_gl_native_surface_get(evas_gl, evas_gl_surface, &ns);
+   evas_gl_native_surface_get(ad->evas_gl, ad->evas_gl_surface, &ns);
    evas_object_image_native_surface_set(gl, &ns);
-   evas_object_image_pixels_get_callback_set(gl, on_pixels, NULL);
+   evas_object_image_pixels_get_callback_set(gl, on_pixels, ad);
 
    bt = elm_button_add(ad->win);
    elm_object_text_set(bt, "Change Texture Format");
@@ -524,7 +567,7 @@ static Eina_Bool app_create(void *data) {
    evas_object_size_hint_align_set(bt, EVAS_HINT_FILL, EVAS_HINT_FILL);
    elm_box_pack_end(bx, bt);
    evas_object_show(bt);
-   evas_object_smart_callback_add(bt, "clicked", _change_cb, NULL);
+   evas_object_smart_callback_add(bt, "clicked", _change_cb, ad);
 
    /* This adds an animator so that the app will regularly
     * trigger updates of the GLView using elm_glview_changed_set().
@@ -536,7 +579,7 @@ static Eina_Bool app_create(void *data) {
    evas_object_data_set(gl, "ani", ani);
    evas_object_data_set(gl, "ad", ad);
    evas_object_event_callback_add(gl, EVAS_CALLBACK_DEL, del_anim, gl);
-   evas_object_event_callback_add(gl, EVAS_CALLBACK_RESIZE, _win_resize_cb, NULL);
+   evas_object_event_callback_add(gl, EVAS_CALLBACK_RESIZE, _win_resize_cb, ad);
 
    evas_object_show(ad->win);
 
@@ -547,12 +590,36 @@ static Eina_Bool app_create(void *data) {
 EAPI_MAIN int
 elm_main(int argc, char **argv)
 {
-   appdata_s ad = {0,};
-   app_create(&ad);
+   appdata_s *ads, *ad;
+   int i, n, status;
+
+   bench_size(&WinWidth, &WinHeight);
+   direct = bench_direct(EINA_TRUE);
+   n = bench_instances();
+
+   ads = calloc(n, sizeof(appdata_s));
+   if (!ads)
+      return 1;
+
+   ad = &ads[0];
+   ad->golden = golden_new("torus");
+   for (i = 0; i < n; i++) {
+      ads[i].id = i;
+      app_create(&ads[i]);
+   }
+   bench_api_lookup("torus", ad->evas_gl, ad->evas_gl_context, ad->glapi);
+   ad->bench = bench_new("torus", ad->win, direct);
+   ad->frame_stats = frame_stats_new("torus");
+   ad->perf_counters = perf_counters_new("torus");
 
    elm_run();
+   perf_counters_free(ad->perf_counters);
+   frame_stats_free(ad->frame_stats);
+   bench_finish(ad->bench);
+   status = golden_finish(ad->golden);
+   free(ads);
    elm_shutdown();
-   return 0;
+   return status;
 }
 ELM_MAIN()
 
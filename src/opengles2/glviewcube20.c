@@ -14,10 +14,39 @@
  * limitations under the License.
  */
 #include <math.h>
-#include <sys/time.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 #include <Elementary.h>
-
-#define UPDATE_INTERVAL 1000ll
+#include "bench.h"
+#include "frame_stats.h"
+#include "gl_profile.h"
+#include "gl_redundant.h"
+#include "gl_trace.h"
+#include "golden.h"
+#include "mat4.h"
+#include "pacing.h"
+#include "perf_counters.h"
+
+/* frames between two submission reports */
+#define STATS_FRAMES 300
+
+/* CUBE_SCENE limits: cube count, and cubes per merged batch so that the
+ * 16-bit indices of GLES2 reach all of a batch's vertices */
+#define SCENE_MAX_CUBES 100000
+#define BATCH_CUBES (65536 / 24)
+
+typedef enum {
+	SCENE_NONE,
+	SCENE_INSTANCED,
+	SCENE_MERGED
+} Scene_Mode;
+
+/* a pre-transformed vertex of the merged batches */
+typedef struct {
+	float position[3];
+	float color[4];
+} Batch_Vertex;
 
 typedef struct appdata {
 	const char *name;
@@ -39,172 +68,63 @@ typedef struct appdata {
 
 	float mvp[16];
 
+	/* static geometry: positions, colors and indices, and on GLES3
+	 * contexts a vertex array object holding the attribute setup */
+	unsigned int vbo[2];
+	unsigned int ibo;
+	unsigned int vao;
+
+	/* GLES3=1 asks for a GLES 3 context, CUBE_BATCH=0 draws from client
+	 * arrays, =compare alternates, CUBE_COUNT=N draws N cubes */
+	Eina_Bool gles3;
+	Eina_Bool batch;
+	Eina_Bool compare;
+	int cube_count;
+	int frames;
+	double submit;
+
+	/* CUBE_SCENE=instanced|merged|compare draws cube_count cubes, each
+	 * with its own transform: instanced from a per-instance matrix
+	 * attribute (GLES3), merged from pre-transformed batches (GLES2) */
+	Scene_Mode scene;
+	Eina_Bool scene_compare;
+	float scene_extent;
+	unsigned int scene_program;
+	unsigned int scene_vtx_shader;
+	int scene_idx_mvp;
+	unsigned int instance_vbo;
+	unsigned int scene_vao;
+	unsigned int *batch_vbo;
+	unsigned int batch_ibo;
+	int batches;
+
 	Eina_Bool mouse_down : 1;
 	Eina_Bool initialized :1;
-} appdata_s;
-
-#define ELEMENTARY_GLVIEW_USE(glview) \
-   Evas_GL_API *__evas_gl_glapi = elm_glview_gl_api_get(glview);
-
-void init_matrix(float* result) {
-	result[0] = 1.0f;
-	result[1] = 0.0f;
-	result[2] = 0.0f;
-	result[3] = 0.0f;
-
-	result[4] = 0.0f;
-	result[5] = 1.0f;
-	result[6] = 0.0f;
-	result[7] = 0.0f;
-
-	result[8] = 0.0f;
-	result[9] = 0.0f;
-	result[10] = 1.0f;
-	result[11] = 0.0f;
-
-	result[12] = 0.0f;
-	result[13] = 0.0f;
-	result[14] = 0.0f;
-	result[15] = 1.0f;
-}
-
-void multiply_matrix(float* result, const float *matrix0,
-		const float *matrix1) {
-	int i, row, column;
-	float temp[16];
-
-	for (column = 0; column < 4; column++) {
-		for (row = 0; row < 4; row++) {
-			temp[column * 4 + row] = 0.0f;
-			for (i = 0; i < 4; i++)
-				temp[column * 4 + row] += matrix0[i * 4 + row]
-						* matrix1[column * 4 + i];
-		}
-	}
-
-	for (i = 0; i < 16; i++)
-		result[i] = temp[i];
-}
-
-void rotate_xyz(float* result, const float anglex, const float angley, const float anglez){
-	float temp[16];
-	float rz = 2.0f * M_PI * anglez / 360.0f;
-	float rx = 2.0f * M_PI * anglex / 360.0f;
-	float ry = 2.0f * M_PI * angley / 360.0f;
-	float sy = sinf(ry);
-	float cy = cosf(ry);
-	float sx = sinf(rx);
-	float cx = cosf(rx);
-	float sz = sinf(rz);
-	float cz = cosf(rz);
-
-	init_matrix(temp);
-
-	temp[0] = cy * cz - sx * sy * sz;
-	temp[1] = cz * sx * sy + cy * sz;
-	temp[2] = -cx * sy;
-
-	temp[4] = -cx * sz;
-	temp[5] = cx * cz;
-	temp[6] = sx;
-
-	temp[8] = cz * sy + cy * sx * sz;
-	temp[9] = -cy * cz * sx + sy * sz;
-	temp[10] = cx * cy;
-
-	multiply_matrix(result, result, temp);
-}
-
-void translate_xyz(float* result, const float translatex,
-		const float translatey, const float translatez) {
-	result[12] += result[0] * translatex + result[4] * translatey
-			+ result[8] * translatez;
-	result[13] += result[1] * translatex + result[5] * translatey
-			+ result[9] * translatez;
-	result[14] += result[2] * translatex + result[6] * translatey
-			+ result[10] * translatez;
-	result[15] += result[3] * translatex + result[7] * translatey
-			+ result[11] * translatez;
-}
-
-void view_set_ortho(float* result, const float left, const float right,
-		const float bottom, const float top, const float near, const float far) {
-	float diffx = right - left;
-	float diffy = top - bottom;
-	float diffz = far - near;
-
-	if ((near <= 0.0f) || (far <= 0.0f) || (diffx <= 0.0f) || (diffy <= 0.0f)
-			|| (diffz <= 0.0f))
-		return;
-
-	result[0] = 2.0f * near / diffx;
-	result[1] = 0.0f;
-	result[2] = 0.0f;
-	result[3] = 0.0f;
-
-	result[4] = 0.0f;
-	result[5] = 2.0f * near / diffy;
-	result[6] = 0.0f;
-	result[7] = 0.0f;
-
-	result[8] = (right + left) / diffx;
-	result[9] = (top + bottom) / diffy;
-	result[10] = -(near + far) / diffz;
-	result[11] = -1.0f;
-
-	result[12] = 0.0f;
-	result[13] = 0.0f;
-	result[14] = -2.0f * near * far / diffz;
-	result[15] = 0.0f;
-}
-
-void view_set_perspective(float* result, const float fovy,
-		const float aspect, const float near, const float far) {
-	float fovradian = fovy / 360.0f * M_PI;
-	float top = tanf(fovradian) * near;
-	float right = top * aspect;
-
-	view_set_ortho(result, -right, right, -top, top, near, far);
-}
-
-long long get_ticks(void) {
-	struct timeval time_value;
-	long long ticks;
-
-	gettimeofday(&time_value, NULL);
-
-	ticks = (long long) time_value.tv_sec * 1000ll;
-	ticks += (long long) time_value.tv_usec / 1000ll;
 
-	return ticks;
-}
-
-void display_fps(void){
-	static long long last_update_time = 0.0f;
-	static int frame_count = 0;
-	static Eina_Bool first = EINA_TRUE;
-	long long current_tick;
-	long long elapsed;
+	/* GOLDEN=record|check, see golden.h */
+	Golden *golden;
 
-	if (first) {
-		last_update_time = get_ticks();
-		first = EINA_FALSE;
-	}
+	/* BENCH_FRAMES, BENCH_SIZE and DIRECT, see bench.h */
+	Bench *bench;
+	Eina_Bool direct;
+	int win_w, win_h;
 
-	frame_count++;
-	current_tick = get_ticks();
+	/* PACING and RENDER_POLICY, see pacing.h */
+	Pacing *pacing;
+	Elm_GLView_Render_Policy render_policy;
 
-	elapsed = current_tick - last_update_time;
+	/* FRAME_STATS, see frame_stats.h */
+	Frame_Stats *frame_stats;
 
-	if (elapsed >= UPDATE_INTERVAL) {
-		float fps = 0.0f;
-		fps = ((float) frame_count / (float) elapsed) * 1000.0f;
-		//dlog_print(DLOG_INFO, LOG_TAG, "FPS: %.2f frames/sec", fps);
+	/* PERF_COUNTERS, see perf_counters.h */
+	Perf_Counters *perf_counters;
+} appdata_s;
 
-		frame_count = 0;
-		last_update_time = current_tick;
-	}
-}
+/* GL_PROFILE, GL_TRACE and GL_REDUNDANT, see gl_profile.h, gl_trace.h
+ * and gl_redundant.h */
+#define ELEMENTARY_GLVIEW_USE(glview) \
+   Evas_GL_API *__evas_gl_glapi = \
+      gl_redundant_api(gl_profile_api(gl_trace_api(elm_glview_gl_api_get(glview))));
 
 const float cube_vertices[] =
 {
@@ -292,6 +212,21 @@ static const char vertex_shader[] =
 		"    gl_Position = u_mvpMatrix * a_position;\n"
 		"}";
 
+/* Vertex Shader Source of the instanced scene, the model matrix comes
+ * per instance */
+static const char scene_vertex_shader[] =
+		"uniform mat4 u_mvpMatrix;\n"
+		"attribute vec4 a_position;\n"
+		"attribute vec4 a_color;\n"
+		"attribute mat4 a_model;\n"
+		"varying vec4 v_color;\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		"    v_color = a_color;\n"
+		"    gl_Position = u_mvpMatrix * a_model * a_position;\n"
+		"}";
+
 /* Fragment Shader Source */
 static const char fragment_shader[] =
 		"#ifdef GL_ES\n"
@@ -338,6 +273,225 @@ static void init_shaders(Evas_Object *obj) {
 	__evas_gl_glapi->glUseProgram(ad->program);
 }
 
+static void init_buffers(Evas_Object *obj) {
+	ELEMENTARY_GLVIEW_USE(obj);
+	appdata_s *ad = evas_object_data_get(obj, "ad");
+
+	__evas_gl_glapi->glGenBuffers(2, ad->vbo);
+	__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, ad->vbo[0]);
+	__evas_gl_glapi->glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices,
+			GL_STATIC_DRAW);
+	__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, ad->vbo[1]);
+	__evas_gl_glapi->glBufferData(GL_ARRAY_BUFFER, sizeof(cube_colors), cube_colors,
+			GL_STATIC_DRAW);
+
+	__evas_gl_glapi->glGenBuffers(1, &ad->ibo);
+	__evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ad->ibo);
+	__evas_gl_glapi->glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cube_indices), cube_indices,
+			GL_STATIC_DRAW);
+	__evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	/* the VAO records the bindings and pointers once, a frame then only
+	 * binds it */
+	if (ad->gles3 && __evas_gl_glapi->glGenVertexArrays) {
+		__evas_gl_glapi->glGenVertexArrays(1, &ad->vao);
+		__evas_gl_glapi->glBindVertexArray(ad->vao);
+		__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, ad->vbo[0]);
+		__evas_gl_glapi->glVertexAttribPointer(ad->idx_position, 3, GL_FLOAT, GL_FALSE,
+				3 * sizeof(float), 0);
+		__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, ad->vbo[1]);
+		__evas_gl_glapi->glVertexAttribPointer(ad->idx_color, 4, GL_FLOAT, GL_FALSE,
+				4 * sizeof(float), 0);
+		__evas_gl_glapi->glEnableVertexAttribArray(ad->idx_position);
+		__evas_gl_glapi->glEnableVertexAttribArray(ad->idx_color);
+		__evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ad->ibo);
+		__evas_gl_glapi->glBindVertexArray(0);
+	}
+	__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, 0);
+	__evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+/* The model matrix of scene cube i: a cube grid of side n centered on
+ * the origin, every cube turned its own way. */
+static void scene_model(float *model, int i, int n) {
+	mat4_identity(model);
+	mat4_translate(model, (i % n - (n - 1) * 0.5f) * 1.5f,
+			(i / n % n - (n - 1) * 0.5f) * 1.5f,
+			(i / (n * n) - (n - 1) * 0.5f) * 1.5f);
+	mat4_rotate_xyz(model, (i * 37) % 360, (i * 101) % 360, 0.0f);
+}
+
+static void init_scene_instanced(Evas_Object *obj, int n) {
+	ELEMENTARY_GLVIEW_USE(obj);
+	appdata_s *ad = evas_object_data_get(obj, "ad");
+	unsigned int idx_position, idx_color, idx_model;
+	const char *p;
+	float *models;
+	int i;
+
+	models = malloc(ad->cube_count * 16 * sizeof(float));
+	if (!models)
+		return;
+	for (i = 0; i < ad->cube_count; i++)
+		scene_model(models + i * 16, i, n);
+
+	p = scene_vertex_shader;
+	ad->scene_vtx_shader = __evas_gl_glapi->glCreateShader(GL_VERTEX_SHADER);
+	__evas_gl_glapi->glShaderSource(ad->scene_vtx_shader, 1, &p, NULL);
+	__evas_gl_glapi->glCompileShader(ad->scene_vtx_shader);
+
+	ad->scene_program = __evas_gl_glapi->glCreateProgram();
+	__evas_gl_glapi->glAttachShader(ad->scene_program, ad->scene_vtx_shader);
+	__evas_gl_glapi->glAttachShader(ad->scene_program, ad->fgmt_shader);
+	__evas_gl_glapi->glLinkProgram(ad->scene_program);
+
+	idx_position = __evas_gl_glapi->glGetAttribLocation(ad->scene_program, "a_position");
+	idx_color = __evas_gl_glapi->glGetAttribLocation(ad->scene_program, "a_color");
+	idx_model = __evas_gl_glapi->glGetAttribLocation(ad->scene_program, "a_model");
+	ad->scene_idx_mvp = __evas_gl_glapi->glGetUniformLocation(ad->scene_program, "u_mvpMatrix");
+
+	__evas_gl_glapi->glGenBuffers(1, &ad->instance_vbo);
+	__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, ad->instance_vbo);
+	__evas_gl_glapi->glBufferData(GL_ARRAY_BUFFER, ad->cube_count * 16 * sizeof(float),
+			models, GL_STATIC_DRAW);
+	free(models);
+
+	__evas_gl_glapi->glGenVertexArrays(1, &ad->scene_vao);
+	__evas_gl_glapi->glBindVertexArray(ad->scene_vao);
+	__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, ad->vbo[0]);
+	__evas_gl_glapi->glVertexAttribPointer(idx_position, 3, GL_FLOAT, GL_FALSE,
+			3 * sizeof(float), 0);
+	__evas_gl_glapi->glEnableVertexAttribArray(idx_position);
+	__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, ad->vbo[1]);
+	__evas_gl_glapi->glVertexAttribPointer(idx_color, 4, GL_FLOAT, GL_FALSE,
+			4 * sizeof(float), 0);
+	__evas_gl_glapi->glEnableVertexAttribArray(idx_color);
+
+	/* a mat4 attribute takes four consecutive locations, one column each */
+	__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, ad->instance_vbo);
+	for (i = 0; i < 4; i++) {
+		__evas_gl_glapi->glVertexAttribPointer(idx_model + i, 4, GL_FLOAT, GL_FALSE,
+				16 * sizeof(float), (void *) (i * 4 * sizeof(float)));
+		__evas_gl_glapi->glEnableVertexAttribArray(idx_model + i);
+		__evas_gl_glapi->glVertexAttribDivisor(idx_model + i, 1);
+	}
+
+	__evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ad->ibo);
+	__evas_gl_glapi->glBindVertexArray(0);
+	__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, 0);
+	__evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+static void init_scene_merged(Evas_Object *obj, int n) {
+	ELEMENTARY_GLVIEW_USE(obj);
+	appdata_s *ad = evas_object_data_get(obj, "ad");
+	Batch_Vertex *vertices, *v;
+	unsigned short *indices;
+	float model[16];
+	int b, i, j, cubes;
+
+	ad->batches = (ad->cube_count + BATCH_CUBES - 1) / BATCH_CUBES;
+	ad->batch_vbo = calloc(ad->batches, sizeof(unsigned int));
+	vertices = malloc(BATCH_CUBES * 24 * sizeof(Batch_Vertex));
+	indices = malloc(BATCH_CUBES * cube_indices_count * sizeof(unsigned short));
+	if (!ad->batch_vbo || !vertices || !indices) {
+		free(ad->batch_vbo);
+		ad->batch_vbo = NULL;
+		ad->batches = 0;
+		free(vertices);
+		free(indices);
+		return;
+	}
+
+	/* every batch has the same index pattern, one buffer serves them all */
+	for (i = 0; i < BATCH_CUBES; i++)
+		for (j = 0; j < cube_indices_count; j++)
+			indices[i * cube_indices_count + j] = i * 24 + cube_indices[j];
+	__evas_gl_glapi->glGenBuffers(1, &ad->batch_ibo);
+	__evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ad->batch_ibo);
+	__evas_gl_glapi->glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+			BATCH_CUBES * cube_indices_count * sizeof(unsigned short), indices, GL_STATIC_DRAW);
+	__evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	free(indices);
+
+	__evas_gl_glapi->glGenBuffers(ad->batches, ad->batch_vbo);
+	for (b = 0; b < ad->batches; b++) {
+		cubes = ad->cube_count - b * BATCH_CUBES;
+		if (cubes > BATCH_CUBES)
+			cubes = BATCH_CUBES;
+
+		for (i = 0, v = vertices; i < cubes; i++, v += 24) {
+			scene_model(model, b * BATCH_CUBES + i, n);
+			mat4_transform_points(model, cube_vertices, 3, v->position,
+					sizeof(Batch_Vertex) / sizeof(float), 24);
+			for (j = 0; j < 24; j++)
+				memcpy(v[j].color, cube_colors + j * 4, sizeof(v->color));
+		}
+
+		__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, ad->batch_vbo[b]);
+		__evas_gl_glapi->glBufferData(GL_ARRAY_BUFFER, cubes * 24 * sizeof(Batch_Vertex),
+				vertices, GL_STATIC_DRAW);
+	}
+	__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, 0);
+	free(vertices);
+}
+
+static void init_scene(Evas_Object *obj) {
+	appdata_s *ad = evas_object_data_get(obj, "ad");
+	int n;
+
+	n = (int) ceilf(cbrtf((float) ad->cube_count));
+	while (n * n * n < ad->cube_count)
+		n++;
+	ad->scene_extent = n * 1.5f;
+
+	if (ad->scene == SCENE_INSTANCED)
+		init_scene_instanced(obj, n);
+	if (!ad->scene_vao) {
+		ad->scene = SCENE_MERGED;
+		ad->scene_compare = EINA_FALSE;
+	}
+	if (ad->scene == SCENE_MERGED || ad->scene_compare)
+		init_scene_merged(obj, n);
+}
+
+static void draw_scene(Evas_Object *obj, appdata_s *ad) {
+	ELEMENTARY_GLVIEW_USE(obj);
+	int b, cubes;
+
+	if (ad->scene == SCENE_INSTANCED) {
+		__evas_gl_glapi->glUseProgram(ad->scene_program);
+		__evas_gl_glapi->glUniformMatrix4fv(ad->scene_idx_mvp, 1, GL_FALSE, ad->mvp);
+		__evas_gl_glapi->glBindVertexArray(ad->scene_vao);
+		__evas_gl_glapi->glDrawElementsInstanced(GL_TRIANGLES, cube_indices_count,
+				GL_UNSIGNED_SHORT, NULL, ad->cube_count);
+		__evas_gl_glapi->glBindVertexArray(0);
+		return;
+	}
+
+	if (ad->vao)
+		__evas_gl_glapi->glBindVertexArray(0);
+	__evas_gl_glapi->glUseProgram(ad->program);
+	__evas_gl_glapi->glUniformMatrix4fv(ad->idx_mvp, 1, GL_FALSE, ad->mvp);
+	__evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ad->batch_ibo);
+	__evas_gl_glapi->glEnableVertexAttribArray(ad->idx_position);
+	__evas_gl_glapi->glEnableVertexAttribArray(ad->idx_color);
+	for (b = 0; b < ad->batches; b++) {
+		cubes = ad->cube_count - b * BATCH_CUBES;
+		if (cubes > BATCH_CUBES)
+			cubes = BATCH_CUBES;
+		__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, ad->batch_vbo[b]);
+		__evas_gl_glapi->glVertexAttribPointer(ad->idx_position, 3, GL_FLOAT, GL_FALSE,
+				sizeof(Batch_Vertex), (void *) offsetof(Batch_Vertex, position));
+		__evas_gl_glapi->glVertexAttribPointer(ad->idx_color, 4, GL_FLOAT, GL_FALSE,
+				sizeof(Batch_Vertex), (void *) offsetof(Batch_Vertex, color));
+		__evas_gl_glapi->glDrawElements(GL_TRIANGLES, cubes * cube_indices_count,
+				GL_UNSIGNED_SHORT, NULL);
+	}
+	__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, 0);
+	__evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
 static void
 mouse_down_cb(void *data, Evas *e , Evas_Object *obj , void *event_info)
 {
@@ -368,58 +522,148 @@ mouse_up_cb(void *data, Evas *e , Evas_Object *obj , void *event_info)
 	ad->mouse_down = EINA_FALSE;
 }
 
+static void submit_stats(appdata_s *ad, double t) {
+	ad->frames++;
+	ad->submit += t;
+	if (ad->frames < STATS_FRAMES)
+		return;
+
+	if (ad->scene)
+		printf("%s scene, %d cubes: %.3f ms/frame submit\n",
+				ad->scene == SCENE_INSTANCED ? "instanced" : "merged batches",
+				ad->cube_count, ad->submit * 1000.0 / ad->frames);
+	else
+		printf("%s, %d cubes: %.3f ms/frame submit\n",
+				!ad->batch ? "client arrays" : ad->vao ? "buffer objects + VAO" : "buffer objects",
+				ad->cube_count, ad->submit * 1000.0 / ad->frames);
+
+	ad->frames = 0;
+	ad->submit = 0.0;
+	if (ad->compare)
+		ad->batch = !ad->batch;
+	if (ad->scene_compare)
+		ad->scene = ad->scene == SCENE_INSTANCED ? SCENE_MERGED : SCENE_INSTANCED;
+}
+
 static void draw_gl(Evas_Object *obj) {
 	ELEMENTARY_GLVIEW_USE(obj);
 	appdata_s *ad = evas_object_data_get(obj, "ad");
 	float model[16], view[16];
 	float aspect;
-	int w, h;
+	double t;
+	int w, h, i, cols, rows;
 
 	if (!ad)
 		return;
 
-	init_matrix(model);
-	init_matrix(view);
+	frame_stats_frame(ad->frame_stats);
+	pacing_draw_begin(ad->pacing);
+	bench_draw_begin(ad->bench);
+	perf_counters_begin(ad->perf_counters);
+	mat4_identity(view);
 
 	elm_glview_size_get(obj, &w, &h);
 	if (!h)
 		return;
 
 	aspect = (float) w / (float) h;
-	view_set_perspective(view, 60.0f, aspect, 1.0f, 20.0f);
-
-	translate_xyz(model, 0.0f, 0.0f, -2.5f);
-	rotate_xyz(model, ad->xangle, ad->yangle, 0.0f);
-
-	multiply_matrix(ad->mvp, view, model);
-
 	__evas_gl_glapi->glViewport(0, 0, w, h);
 
 	__evas_gl_glapi->glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 	__evas_gl_glapi->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	__evas_gl_glapi->glVertexAttribPointer(ad->idx_position, 3, GL_FLOAT, GL_FALSE,
-			3 * sizeof(float), cube_vertices);
-	__evas_gl_glapi->glVertexAttribPointer(ad->idx_color, 4, GL_FLOAT, GL_FALSE,
-			4 * sizeof(float), cube_colors);
-
-	__evas_gl_glapi->glEnableVertexAttribArray(ad->idx_position);
-	__evas_gl_glapi->glEnableVertexAttribArray(ad->idx_color);
+	if (ad->scene) {
+		/* the whole cube block turns, far enough back to fit the view */
+		mat4_perspective(view, 60.0f, aspect, 1.0f, 20.0f + ad->scene_extent * 3.0f);
+		mat4_identity(model);
+		mat4_translate(model, 0.0f, 0.0f, -2.5f - ad->scene_extent * 1.5f);
+		mat4_rotate_xyz(model, ad->xangle, ad->yangle, 0.0f);
+		mat4_multiply(ad->mvp, view, model);
+
+		t = ecore_time_get();
+		draw_scene(obj, ad);
+		submit_stats(ad, ecore_time_get() - t);
+		goto done;
+	}
 
-	__evas_gl_glapi->glUniformMatrix4fv(ad->idx_mvp, 1, GL_FALSE, ad->mvp);
+	/* the cubes on a square grid, pushed back until it fits the view */
+	cols = (int) ceilf(sqrtf((float) ad->cube_count));
+	rows = (ad->cube_count + cols - 1) / cols;
+	mat4_perspective(view, 60.0f, aspect, 1.0f, 20.0f + (cols - 1) * 1.5f);
+
+	t = ecore_time_get();
+	if (ad->batch && ad->vao) {
+		__evas_gl_glapi->glBindVertexArray(ad->vao);
+	} else if (ad->batch) {
+		__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, ad->vbo[0]);
+		__evas_gl_glapi->glVertexAttribPointer(ad->idx_position, 3, GL_FLOAT, GL_FALSE,
+				3 * sizeof(float), 0);
+		__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, ad->vbo[1]);
+		__evas_gl_glapi->glVertexAttribPointer(ad->idx_color, 4, GL_FLOAT, GL_FALSE,
+				4 * sizeof(float), 0);
+		__evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ad->ibo);
+		__evas_gl_glapi->glEnableVertexAttribArray(ad->idx_position);
+		__evas_gl_glapi->glEnableVertexAttribArray(ad->idx_color);
+	} else {
+		if (ad->vao)
+			__evas_gl_glapi->glBindVertexArray(0);
+		__evas_gl_glapi->glBindBuffer(GL_ARRAY_BUFFER, 0);
+		__evas_gl_glapi->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		__evas_gl_glapi->glVertexAttribPointer(ad->idx_position, 3, GL_FLOAT, GL_FALSE,
+				3 * sizeof(float), cube_vertices);
+		__evas_gl_glapi->glVertexAttribPointer(ad->idx_color, 4, GL_FLOAT, GL_FALSE,
+				4 * sizeof(float), cube_colors);
+		__evas_gl_glapi->glEnableVertexAttribArray(ad->idx_position);
+		__evas_gl_glapi->glEnableVertexAttribArray(ad->idx_color);
+	}
 
-	__evas_gl_glapi->glDrawElements(GL_TRIANGLES, cube_indices_count, GL_UNSIGNED_SHORT,
-			cube_indices);
+	/* one uniform update and one draw per cube */
+	for (i = 0; i < ad->cube_count; i++) {
+		mat4_identity(model);
+		mat4_translate(model, (i % cols - (cols - 1) * 0.5f) * 1.5f,
+				(i / cols - (rows - 1) * 0.5f) * 1.5f, -2.5f - (cols - 1) * 1.5f);
+		mat4_rotate_xyz(model, ad->xangle, ad->yangle, 0.0f);
+		mat4_multiply(ad->mvp, view, model);
+
+		__evas_gl_glapi->glUniformMatrix4fv(ad->idx_mvp, 1, GL_FALSE, ad->mvp);
+		__evas_gl_glapi->glDrawElements(GL_TRIANGLES, cube_indices_count, GL_UNSIGNED_SHORT,
+				ad->batch ? NULL : cube_indices);
+	}
+	submit_stats(ad, ecore_time_get() - t);
+
+done:
+	perf_counters_end(ad->perf_counters);
+	if (!golden_frame(ad->golden, __evas_gl_glapi, w, h))
+		elm_exit();
+	pacing_draw_end(ad->pacing);
+	gl_profile_frame();
+	gl_trace_frame();
+	gl_redundant_frame();
+	if (!bench_draw_end(ad->bench))
+		elm_exit();
 
 	__evas_gl_glapi->glFlush();
-
-	display_fps();
 }
 
 static void del_gl(Evas_Object *obj) {
 	ELEMENTARY_GLVIEW_USE(obj);
 	appdata_s *ad = evas_object_data_get(obj, "ad");
 
+	if (ad->vao)
+		__evas_gl_glapi->glDeleteVertexArrays(1, &ad->vao);
+	if (ad->scene_vao) {
+		__evas_gl_glapi->glDeleteVertexArrays(1, &ad->scene_vao);
+		__evas_gl_glapi->glDeleteBuffers(1, &ad->instance_vbo);
+		__evas_gl_glapi->glDeleteProgram(ad->scene_program);
+		__evas_gl_glapi->glDeleteShader(ad->scene_vtx_shader);
+	}
+	if (ad->batches) {
+		__evas_gl_glapi->glDeleteBuffers(ad->batches, ad->batch_vbo);
+		__evas_gl_glapi->glDeleteBuffers(1, &ad->batch_ibo);
+		free(ad->batch_vbo);
+	}
+	__evas_gl_glapi->glDeleteBuffers(2, ad->vbo);
+	__evas_gl_glapi->glDeleteBuffers(1, &ad->ibo);
 	__evas_gl_glapi->glDeleteShader(ad->vtx_shader);
 	__evas_gl_glapi->glDeleteShader(ad->fgmt_shader);
 	__evas_gl_glapi->glDeleteProgram(ad->program);
@@ -434,6 +678,10 @@ static void del_anim(void *data, Evas *evas, Evas_Object *obj, void *event_info)
 }
 
 static Eina_Bool anim(void *data) {
+	appdata_s *ad = evas_object_data_get(data, "ad");
+
+	if (ad)
+		pacing_tick(ad->pacing);
 	elm_glview_changed_set(data);
 	return EINA_TRUE;
 }
@@ -444,6 +692,9 @@ static void init_gl(Evas_Object *obj) {
 
 	if (!ad->initialized) {
 		init_shaders(obj);
+		init_buffers(obj);
+		if (ad->scene)
+			init_scene(obj);
 		__evas_gl_glapi->glEnable(GL_DEPTH_TEST);
 		ad->initialized = EINA_TRUE;
 	}
@@ -470,12 +721,12 @@ static void create_indicator(appdata_s *ad) {
 	evas_object_show(ad->conform);
 }
 
-static Evas_Object* add_win(const char *name) {
+static Evas_Object* add_win(const char *name, int w, int h) {
 	Evas_Object *win;
 
 	elm_config_accel_preference_set("opengl:depth24");
 	win = elm_win_util_standard_add(name, "OpenGL example: Cube");
-	evas_object_resize(win, 360, 480);
+	evas_object_resize(win, w, h);
 
 	if (!win)
 		return NULL;
@@ -504,7 +755,7 @@ static Eina_Bool app_create(void *data) {
 		return EINA_FALSE;
 
 	/* Create the window */
-	ad->win = add_win(ad->name);
+	ad->win = add_win(ad->name, ad->win_w, ad->win_h);
 
 	if (!ad->win)
 		return EINA_FALSE;
@@ -513,14 +764,25 @@ static Eina_Bool app_create(void *data) {
 	evas_object_smart_callback_add(ad->win, "delete,request", win_delete_request_cb, NULL);
 	//eext_object_event_callback_add(ad->win, EEXT_CALLBACK_BACK, win_back_cb, ad);
 
-	/* Create and initialize GLView */
-	gl = elm_glview_add(ad->conform);
+	/* Create and initialize GLView, GLES 3 for the vertex array object */
+	gl = NULL;
+	if (ad->gles3)
+		gl = elm_glview_version_add(ad->conform, EVAS_GL_GLES_3_X);
+	if (!gl) {
+		if (ad->gles3 && ad->scene)
+			printf("no GLES 3 context, merged batches instead of instancing\n");
+		ad->gles3 = EINA_FALSE;
+		ad->scene_compare = EINA_FALSE;
+		if (ad->scene)
+			ad->scene = SCENE_MERGED;
+		gl = elm_glview_add(ad->conform);
+	}
 	//ELEMENTARY_GLVIEW_GLOBAL_USE(gl);
 	evas_object_size_hint_align_set(gl, EVAS_HINT_FILL, EVAS_HINT_FILL);
 	evas_object_size_hint_weight_set(gl, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
 
 	/* Request a surface with alpha and a depth buffer */
-        if (getenv("DIRECT"))
+        if (ad->direct)
 	  elm_glview_mode_set(gl, ELM_GLVIEW_DEPTH|ELM_GLVIEW_DIRECT);
         else
 	  elm_glview_mode_set(gl, ELM_GLVIEW_DEPTH);
@@ -536,8 +798,9 @@ static Eina_Bool app_create(void *data) {
 	 * called only when the object is visible.
 	 * ELM_GLVIEW_RENDER_POLICY_ALWAYS would cause the callback to be
 	 * called even if the object were hidden.
+	 * RENDER_POLICY=always picks the latter, see pacing.h.
 	 */
-	elm_glview_render_policy_set(gl, ELM_GLVIEW_RENDER_POLICY_ON_DEMAND);
+	elm_glview_render_policy_set(gl, ad->render_policy);
 
 	/* The initialize callback function gets registered here */
 	elm_glview_init_func_set(gl, init_gl);
@@ -595,11 +858,51 @@ EAPI_MAIN int
 elm_main(int argc, char **argv)
 {
    appdata_s ad = {0,};
+   const char *scene;
+   int status;
+
+   ad.win_w = 360;
+   ad.win_h = 480;
+   bench_size(&ad.win_w, &ad.win_h);
+   ad.direct = bench_direct(EINA_FALSE);
+   ad.render_policy = pacing_render_policy();
+
+   /* GLES3=1, CUBE_BATCH=0|compare and CUBE_COUNT=N */
+   ad.gles3 = getenv("GLES3") && atoi(getenv("GLES3"));
+   ad.batch = !getenv("CUBE_BATCH") || strcmp(getenv("CUBE_BATCH"), "0");
+   ad.compare = getenv("CUBE_BATCH") && !strcmp(getenv("CUBE_BATCH"), "compare");
+   ad.cube_count = getenv("CUBE_COUNT") ? atoi(getenv("CUBE_COUNT")) : 1;
+   if (ad.cube_count < 1)
+      ad.cube_count = 1;
+
+   /* CUBE_SCENE=instanced|merged|compare, instancing needs GLES 3 */
+   scene = getenv("CUBE_SCENE");
+   if (scene) {
+      ad.scene_compare = !strcmp(scene, "compare");
+      ad.scene = ad.scene_compare || !strcmp(scene, "instanced") ? SCENE_INSTANCED : SCENE_MERGED;
+      if (ad.scene == SCENE_INSTANCED)
+         ad.gles3 = EINA_TRUE;
+      if (!getenv("CUBE_COUNT"))
+         ad.cube_count = 10000;
+      if (ad.cube_count > SCENE_MAX_CUBES)
+         ad.cube_count = SCENE_MAX_CUBES;
+   }
+
+   ad.golden = golden_new("glviewcube20");
    app_create(&ad);
+   ad.bench = bench_new("glviewcube20", ad.win, ad.direct);
+   ad.pacing = pacing_new("glviewcube20", ad.win, ad.render_policy);
+   ad.frame_stats = frame_stats_new("glviewcube20");
+   ad.perf_counters = perf_counters_new("glviewcube20");
 
    elm_run();
+   perf_counters_free(ad.perf_counters);
+   frame_stats_free(ad.frame_stats);
+   pacing_free(ad.pacing);
+   bench_finish(ad.bench);
+   status = golden_finish(ad.golden);
    elm_shutdown();
-   return 0;
+   return status;
 }
 ELM_MAIN()
 
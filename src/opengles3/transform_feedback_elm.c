@@ -10,6 +10,15 @@
  */
 #include <Elementary.h>
 #include <Evas_GL.h>
+#include "bench.h"
+#include "frame_stats.h"
+#include "gl_profile.h"
+#include "gl_redundant.h"
+#include "gl_trace.h"
+#include "golden.h"
+#include "mat4.h"
+#include "pacing.h"
+#include "perf_counters.h"
 #include <stdio.h>
 #include <assert.h>
 
@@ -56,7 +65,6 @@ void tcLog(const char* format, ...)
 typedef struct _GLData GLData;
 #define side 10
 #define numVertices side * side * side
-static const float PI = 3.1415926535897932384626433832795f;
 
 #define CHECK_GL_ERROR { int _err = gl->glGetError(); if (_err != GL_NO_ERROR) { tcLog("GL error %#0.4x, file %s, line %d\n", _err, __FILE__, __LINE__); /*ret = 0; goto finish;*/ } }
 
@@ -102,6 +110,21 @@ struct _GLData {
 	GLuint m_textureId;
 	int w; // window width
 	int h; // window height
+
+	// GOLDEN=record|check, see golden.h
+	Golden *golden;
+
+	// BENCH_FRAMES, BENCH_SIZE and DIRECT, see bench.h
+	Bench *bench;
+
+	// PACING and RENDER_POLICY, see pacing.h
+	Pacing *pacing;
+
+	// FRAME_STATS, see frame_stats.h
+	Frame_Stats *frame_stats;
+
+	// PERF_COUNTERS, see perf_counters.h
+	Perf_Counters *perf_counters;
 };
 
 GLuint load_shader( GLData *gld, GLenum type, const char *shader_src );
@@ -341,8 +364,9 @@ int tfInit_TransformFeedback(GLData *gld){
 	gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
 	CHECK_GL_ERROR;
 
-	// initialize random number generator to randomly change the position
-	srand((unsigned) time(&t));
+	// initialize random number generator to randomly change the position,
+	// with a fixed seed when frames go to the golden store
+	srand(gld->golden ? 1 : (unsigned) time(&t));
 
 finish:
 	if( 0 != vertShader)
@@ -456,87 +480,6 @@ finish:
 	return ret;
 }
 
-///////////////////////////////////////
-// some maths functions here
-///////////////////////////////////////
-void
-tsTranslate4x4f(float pResult[], float tx, float ty, float tz)
-{
-	float temp[4][4];
-
-	memcpy((float*)&temp[0][0], (float*)pResult, sizeof(float)*16);
-
-	temp[3][0] += (temp[0][0] * tx + temp[1][0] * ty + temp[2][0] * tz);
-	temp[3][1] += (temp[0][1] * tx + temp[1][1] * ty + temp[2][1] * tz);
-	temp[3][2] += (temp[0][2] * tx + temp[1][2] * ty + temp[2][2] * tz);
-	temp[3][3] += (temp[0][3] * tx + temp[1][3] * ty + temp[2][3] * tz);
-	memcpy((float*)pResult, (float*)&temp[0][0],  sizeof(float)*16);
-}
-
-void
-tsRotate4x4f(float pResult[], float angle, float x, float y, float z)
-{
-	float rotate[4][4];
-
-	float cos = cosf(angle * PI / 180.0f);
-	float sin = sinf(angle * PI / 180.0f);
-	float cos1 = 1.0f - cos;
-
-	float magnitude= sqrt (x*x+ y*y + z*z);
-	if( magnitude)
-	{
-		x/=magnitude;
-		y/=magnitude;
-		z=magnitude;
-	}
-
-	rotate[0][0] = (x * x) * cos1 + cos;
-	rotate[0][1] = (x * y) * cos1 - z * sin;
-	rotate[0][2] = (z * x) * cos1 + y * sin;
-	rotate[0][3] = 0.0f;
-
-	rotate[1][0] = (x * y) * cos1 + z * sin;
-	rotate[1][1] = (y * y) * cos1 + cos;
-	rotate[1][2] = (y * z) * cos1 - x * sin;
-	rotate[1][3] = 0.0f;
-
-	rotate[2][0] = (z * x) * cos1 - y * sin;
-	rotate[2][1] = (y * z) * cos1 + x * sin;
-	rotate[2][2] = (z * z) * cos1 + cos;
-
-	rotate[2][3] = rotate[3][0] = rotate[3][1] = rotate[3][2] = 0.0f;
-	rotate[3][3] = 1.0f;
-
-	memcpy((float*)pResult,(float*) &rotate[0][0], sizeof(float)*16);
-}
-
-void
-tsScale4x4f(float pResult[], float x, float y, float z)
-{
-
-	pResult[0] = x;
-	pResult[5] = y;
-	pResult[10] = z;
-
-}
-
-void MatrixMultiply(float* inMatrix, float* inVector, float* outVector, int size)
-{
-	int i,j;
-	assert(inMatrix);
-	assert(inVector);
-	assert(outVector);
-	assert(size);
-
-	for( i = 0; i < size; i++)
-	{
-		outVector[i]=0;
-		for( j=0; j < size; j++)
-			outVector[i]+= inMatrix[i*size+j] * inVector[j];
-	}
-}
-
-
 ////////////////////////////////////////////////
 // Function to test transform feedback vertex shader
 ////////////////////////////////////////////////
@@ -559,7 +502,7 @@ int tfVertexShader(float* aPosition, float* aForce, float* uPositionMatrix, floa
 	for(i = 0; i < 3; i++)
 		aPositionAndForce[i]=aPosition[i] + aForce[i];
 
-	MatrixMultiply(uPositionMatrix, aPositionAndForce, oPosition, 3);
+	mat3_transform(uPositionMatrix, aPositionAndForce, oPosition);
 
 
 	direction[0]=uTouchPosition[0] - oPosition[0];
@@ -864,10 +807,14 @@ _resize_gl(Evas_Object *obj)
 static void
 _draw_gl(Evas_Object *obj)
 {
-   Evas_GL_API *gl = elm_glview_gl_api_get(obj);
+   Evas_GL_API *gl = gl_redundant_api(gl_profile_api(gl_trace_api(elm_glview_gl_api_get(obj))));
    GLData *gld = evas_object_data_get(obj, "gld");
    if (!gld) return;
 
+	frame_stats_frame(gld->frame_stats);
+	pacing_draw_begin(gld->pacing);
+	bench_draw_begin(gld->bench);
+	perf_counters_begin(gld->perf_counters);
 	elm_glview_size_get(obj, &gld->w, &gld->h);
 
 	if (!tfUpdate(gld)) {
@@ -881,12 +828,25 @@ _draw_gl(Evas_Object *obj)
 //		ret = 0;
 //		goto finish;
 	}
+
+	perf_counters_end(gld->perf_counters);
+	if (!golden_frame(gld->golden, gl, gld->w, gld->h))
+		elm_exit();
+	pacing_draw_end(gld->pacing);
+	gl_profile_frame();
+	gl_trace_frame();
+	gl_redundant_frame();
+	if (!bench_draw_end(gld->bench))
+		elm_exit();
 }
 
 // just need to notify that glview has changed so it can render
 static Eina_Bool
 _anim(void *data)
 {
+   GLData *gld = evas_object_data_get(data, "gld");
+
+   if (gld) pacing_tick(gld->pacing);
    elm_glview_changed_set(data);
    return EINA_TRUE;
 }
@@ -912,8 +872,15 @@ elm_main(int argc, char **argv)
    Evas_Object *win, *bg, *bx, *bt, *gl;
    Ecore_Animator *ani;
    GLData *gld = NULL;
+   Eina_Bool direct;
+   Elm_GLView_Render_Policy policy;
+   int status, w = 320, h = 480;
 
    if (!(gld = calloc(1, sizeof(GLData)))) return 1;
+   gld->golden = golden_new("transform_feedback");
+   bench_size(&w, &h);
+   direct = bench_direct(EINA_FALSE);
+   policy = pacing_render_policy();
 
    // set the preferred engine to opengl_x11. if it isnt' available it
    // may use another transparently
@@ -938,13 +905,18 @@ elm_main(int argc, char **argv)
    //-//
    // create a new glview object
    gl = elm_glview_version_add(win,EVAS_GL_GLES_3_X );
-   gld->glapi = elm_glview_gl_api_get(gl);
+   // GL_PROFILE, GL_TRACE and GL_REDUNDANT, see gl_profile.h, gl_trace.h
+   // and gl_redundant.h
+   gld->glapi = gl_redundant_api(gl_profile_api(gl_trace_api(elm_glview_gl_api_get(gl))));
    evas_object_size_hint_align_set(gl, EVAS_HINT_FILL, EVAS_HINT_FILL);
    evas_object_size_hint_weight_set(gl, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
    // mode is simply for supporting alpha, depth buffering, and stencil
    // buffering.
    //if(!getenv("TESTAPP_INDIRECT")) 
-   elm_glview_mode_set(gl, ELM_GLVIEW_ALPHA /*| ELM_GLVIEW_DEPTH | ELM_GLVIEW_DIRECT*/);
+   if (direct)
+     elm_glview_mode_set(gl, ELM_GLVIEW_ALPHA | ELM_GLVIEW_DIRECT);
+   else
+     elm_glview_mode_set(gl, ELM_GLVIEW_ALPHA /*| ELM_GLVIEW_DEPTH | ELM_GLVIEW_DIRECT*/);
    //else
    //elm_glview_mode_set(gl, ELM_GLVIEW_ALPHA | ELM_GLVIEW_DEPTH);
    // resize policy tells glview what to do with the surface when it
@@ -955,8 +927,9 @@ elm_main(int argc, char **argv)
    // gl code. ELM_GLVIEW_RENDER_POLICY_ON_DEMAND will have the gl
    // calls called in the pixel_get callback, which only gets called
    // if the object is visible, hence ON_DEMAND.  ALWAYS mode renders
-   // it despite the visibility of the object.
-   elm_glview_render_policy_set(gl, ELM_GLVIEW_RENDER_POLICY_ON_DEMAND);
+   // it despite the visibility of the object.  RENDER_POLICY picks one,
+   // see pacing.h
+   elm_glview_render_policy_set(gl, policy);
    // initialize callback function gets registered here
    elm_glview_init_func_set(gl, _init_gl);
    // delete callback function gets registered here
@@ -991,13 +964,22 @@ elm_main(int argc, char **argv)
    evas_object_show(bt);
    evas_object_smart_callback_add(bt, "clicked", _on_done, win);
 
-   evas_object_resize(win, 320, 480);
+   evas_object_resize(win, w, h);
    evas_object_show(win);
+   gld->bench = bench_new("transform_feedback", win, direct);
+   gld->pacing = pacing_new("transform_feedback", win, policy);
+   gld->frame_stats = frame_stats_new("transform_feedback");
+   gld->perf_counters = perf_counters_new("transform_feedback");
 
    // run the mainloop and process events and callbacks
    elm_run();
+   pacing_free(gld->pacing);
+   frame_stats_free(gld->frame_stats);
+   perf_counters_free(gld->perf_counters);
+   bench_finish(gld->bench);
+   status = golden_finish(gld->golden);
    elm_shutdown();
 
-   return 0;
+   return status;
 }
 ELM_MAIN()